@@ -1,21 +1,26 @@
 #include <ncurses.h>   // Terminal UI library
+#include "wormtype_core.h"  // Corpus, layout, scoring and leaderboard file
+#include "wormtype_net.h"   // Race mode client and server
 #include <string>      // String class
 #include <vector>      // Dynamic arrays
 #include <ctime>       // Time functions
-#include <cstdlib>     // Random number generation and atexit()
+#include <cstdlib>     // For atexit() and strtoull()
+#include <cstdint>     // Fixed-width integers
 #include <fstream>     // File I/O
 #include <algorithm>   // For sorting
 #include <iomanip>     // For formatting
+#include <iterator>    // For reading whole files
 #include <unistd.h>    // For usleep() delay function
+#include <fcntl.h>     // For open() of /proc/self/io
 #include <signal.h>    // For signal handling
+#include <poll.h>      // For poll() in the frame loop
+#include <dirent.h>    // For importing the old saves directory
 #include <cctype>      // For toupper()
-
-// Utility function to convert string to uppercase
-std::string toUpperCase(const std::string& str) {
-    std::string result = str;
-    std::transform(result.begin(), result.end(), result.begin(), ::toupper);
-    return result;
-}
+#include <cstring>     // For strlen()
+#include <bitset>      // Unlocked achievement flags
+#include <unordered_map>  // Achievement id lookup
+#include <cmath>       // For ceil() of the time left
+#include <thread>      // Background score history load for --quick
 
 // Forward declarations
 void drawBouncyWorm(int y, int start_x, int width, double position, int frame);
@@ -24,39 +29,144 @@ void initializeAchievements();
 void saveAchievements();
 void loadAchievements();
 void checkAchievements(double wpm, double accuracy, double time);
+void showPendingAchievements();
 bool showWormCloset();
+void showKeyStats();
 std::string getNewPlayerName();
 int getCustomWordCount();
 
 
 // Achievement system
-struct Achievement {
-    std::string id;
-    std::string name;
-    std::string description;
-    bool unlocked;
-    
-    Achievement(const std::string& i, const std::string& n, const std::string& d) 
-        : id(i), name(n), description(d), unlocked(false) {}
+
+// Test result an achievement rule looks at
+enum AchievementStat {
+    STAT_WPM,        // Final WPM
+    STAT_ACCURACY,   // Final accuracy in percent
+    STAT_TIME,       // Test duration in seconds
+    STAT_STREAK      // Tests in a row at kStreakAccuracy or better
+};
+
+// One achievement: unlocked when its stat reaches the minimum
+struct AchievementDef {
+    const char* id;             // Stable id, as written by old save files
+    const char* name;
+    const char* description;
+    const char* unlockMessage;  // Shown on the notification screen
+    AchievementStat stat;
+    double minimum;
+};
+
+// Achievement table. The position is the achievement's bit in the unlocked set and in
+// the player database, so new achievements are only ever appended.
+enum AchievementIndex {
+    ACH_PINK_WORM,
+    ACH_BLUE_WORM,
+    ACH_MAGENTA_WORM,
+    ACH_YELLOW_WORM,
+    ACH_SHARPSHOOTER,
+    ACH_MARATHON,
+    ACH_STEADY_HANDS,
+    ACH_COUNT
+};
+
+static const AchievementDef kAchievements[ACH_COUNT] = {
+    { "pink_worm", "red!worm?pink!worm?", "Achieve 60+ WPM to unlock the pink worm variant!",
+      "Pink worm variant unlocked!", STAT_WPM, 60.0 },
+    { "blue_worm", "blue!worm?speedy!typer?", "Achieve 75+ WPM to unlock the blue worm variant!",
+      "Blue worm variant unlocked!", STAT_WPM, 75.0 },
+    { "magenta_worm", "magenta!worm?lightning!fingers?", "Achieve 80+ WPM to unlock the magenta worm variant!",
+      "Magenta worm variant unlocked!", STAT_WPM, 80.0 },
+    { "yellow_worm", "golden!worm?typing!master?", "Achieve 90+ WPM to unlock the golden worm variant!",
+      "Golden worm variant unlocked!", STAT_WPM, 90.0 },
+    { "sharpshooter", "sharp!shooter?no!typos?", "Finish a test with 100% accuracy!",
+      "Not a single typo!", STAT_ACCURACY, 100.0 },
+    { "marathon", "long!worm?marathon!typer?", "Keep typing for 5+ minutes in one test!",
+      "Five minutes of typing in one go!", STAT_TIME, 300.0 },
+    { "steady_hands", "steady!worm?steady!hands?", "Finish 5 tests in a row at 95%+ accuracy!",
+      "Five accurate tests in a row!", STAT_STREAK, 5.0 }
+};
+
+// Accuracy a test needs to extend the streak
+static const double kStreakAccuracy = 95.0;
+
+// Dense index of an achievement id, or ACH_COUNT if unknown
+AchievementIndex findAchievement(const std::string& id) {
+    static std::unordered_map<std::string, int> index;
+    if (index.empty()) {
+        for (int i = 0; i < ACH_COUNT; i++) index[kAchievements[i].id] = i;
+    }
+    std::unordered_map<std::string, int>::const_iterator it = index.find(id);
+    return it == index.end() ? ACH_COUNT : (AchievementIndex)it->second;
+}
+
+// Worm skins, in closet slot order. Skins are resolved to an id once when a profile is
+// loaded or a skin is equipped, so drawing never compares color names.
+enum WormSkinId {
+    SKIN_DEFAULT,
+    SKIN_PINK,
+    SKIN_BLUE,
+    SKIN_MAGENTA,
+    SKIN_YELLOW,
+    SKIN_COUNT
+};
+
+struct WormSkin {
+    const char* colorName;        // Stored in the player database
+    char slotKey;                 // Closet slot letter
+    const char* info;             // Closet description once unlocked
+    const char* lockedInfo;       // Closet description while locked
+    int colorPair;                // Color pair set up in main
+    AchievementIndex unlockedBy;  // ACH_COUNT if always available
+    char headFrames[4];           // Head glyph per animation frame
+};
+
+static const WormSkin kWormSkins[SKIN_COUNT] = {
+    { "default", 'D', "Default Worm - Classic orange-red", "Default Worm - Classic orange-red",
+      5, ACH_COUNT, { 'O', 'o', 'O', '0' } },
+    { "pink", 'P', "Pink Worm - Unlocked at 60+ WPM", "??? - Achieve 60+ WPM to unlock",
+      4, ACH_PINK_WORM, { 'O', 'o', 'O', '0' } },
+    { "blue", 'B', "Blue Worm - Unlocked at 75+ WPM", "??? - Achieve 75+ WPM to unlock",
+      7, ACH_BLUE_WORM, { 'O', 'o', 'O', '0' } },
+    { "magenta", 'M', "Magenta Worm - Unlocked at 80+ WPM", "??? - Achieve 80+ WPM to unlock",
+      8, ACH_MAGENTA_WORM, { 'O', 'o', 'O', '0' } },
+    { "yellow", 'Y', "Golden Worm - Unlocked at 90+ WPM", "??? - Achieve 90+ WPM to unlock",
+      9, ACH_YELLOW_WORM, { 'O', 'o', 'O', '0' } }
 };
 
+// Skin for a stored color name; unknown names fall back to the default worm
+WormSkinId findWormSkin(const std::string& colorName) {
+    for (int i = 0; i < SKIN_COUNT; i++) {
+        if (colorName == kWormSkins[i].colorName) return (WormSkinId)i;
+    }
+    return SKIN_DEFAULT;
+}
+
 // Player save data structure
 struct PlayerSaveData {
     std::string playerName;
-    std::vector<Achievement> achievements;
-    std::string equippedWormColor;
+    std::bitset<ACH_COUNT> unlocked;   // By AchievementIndex
+    WormSkinId equippedSkin;
     int currency;
+    int streak;                        // Tests in a row at kStreakAccuracy or better
+    KeyStats keyStats;                 // Per-key and bigram timing, kept in keystats.db
     
     PlayerSaveData(const std::string& name) 
-        : playerName(name), equippedWormColor("default"), currency(0) {
-        // Initialize with default achievements
-        achievements.push_back(Achievement("pink_worm", "red!worm?pink!worm?", "Achieve 60+ WPM to unlock the pink worm variant!"));
-        achievements.push_back(Achievement("blue_worm", "blue!worm?speedy!typer?", "Achieve 75+ WPM to unlock the blue worm variant!"));
-        achievements.push_back(Achievement("magenta_worm", "magenta!worm?lightning!fingers?", "Achieve 80+ WPM to unlock the magenta worm variant!"));
-        achievements.push_back(Achievement("yellow_worm", "golden!worm?typing!master?", "Achieve 90+ WPM to unlock the golden worm variant!"));
+        : playerName(name), equippedSkin(SKIN_DEFAULT), currency(0), streak(0) {
+        clearKeyStats(keyStats);
+    }
+    
+    bool hasSkin(WormSkinId skin) const {
+        return kWormSkins[skin].unlockedBy == ACH_COUNT || unlocked.test(kWormSkins[skin].unlockedBy);
     }
 };
 
+// Achievements unlocked by the last test, shown after its result screen
+std::vector<AchievementIndex> pendingAchievements;
+
+// Key statistics of the running test, added to the profile only if it is completed
+KeyStats testKeyStats;
+KeyTimer testKeyTimer;
+
 // Global player data
 PlayerSaveData* currentPlayerData = nullptr;
 std::string currentPlayerName = "";
@@ -65,238 +175,484 @@ std::string currentPlayerName = "";
 void savePlayerData(const PlayerSaveData& playerData);
 PlayerSaveData loadPlayerData(const std::string& playerName);
 void setCurrentPlayer(const std::string& playerName);
-std::string getSafeFileName(const std::string& playerName);
-std::vector<std::string> getAllSavedPlayerNames();
 bool confirmDeleteAllPlayers();
 void deleteAllSavedPlayers();
+void importLegacySaves();
 
-// Structure to hold player score data
-struct PlayerScore {
-    std::string name;
-    double wpm;
-    double accuracy;
-    double time;
-    std::string date;
-    int wordCount;
-    bool hasPunctuation;
-    bool hasNumbers;
-    
-    // Constructor with all options
-    PlayerScore(const std::string& n, double w, double a, double t, const std::string& d, int wc, bool punct, bool nums) 
-        : name(n), wpm(w), accuracy(a), time(t), date(d), wordCount(wc), hasPunctuation(punct), hasNumbers(nums) {}
-    
-    // Constructor with word count and options but without date (auto-generates date)
-    PlayerScore(const std::string& n, double w, double a, double t, int wc, bool punct, bool nums) 
-        : name(n), wpm(w), accuracy(a), time(t), wordCount(wc), hasPunctuation(punct), hasNumbers(nums) {
-        // Get current date/time
-        time_t rawtime;
-        struct tm* timeinfo;
-        char buffer[80];
-        
-        ::time(&rawtime);
-        timeinfo = localtime(&rawtime);
-        strftime(buffer, sizeof(buffer), "%m/%d/%Y %H:%M", timeinfo);
-        date = std::string(buffer);
-    }
-    
-    // Constructor with date and word count (backward compatibility - no punctuation/numbers)
-    PlayerScore(const std::string& n, double w, double a, double t, const std::string& d, int wc) 
-        : name(n), wpm(w), accuracy(a), time(t), date(d), wordCount(wc), hasPunctuation(false), hasNumbers(false) {}
-    
-    // Constructor with word count but without date (backward compatibility - no punctuation/numbers)
-    PlayerScore(const std::string& n, double w, double a, double t, int wc) 
-        : name(n), wpm(w), accuracy(a), time(t), wordCount(wc), hasPunctuation(false), hasNumbers(false) {
-        // Get current date/time
-        time_t rawtime;
-        struct tm* timeinfo;
-        char buffer[80];
-        
-        ::time(&rawtime);
-        timeinfo = localtime(&rawtime);
-        strftime(buffer, sizeof(buffer), "%m/%d/%Y %H:%M", timeinfo);
-        date = std::string(buffer);
-    }
-    
-    // Constructor with date (for backward compatibility - assumes 15 words, no punctuation/numbers)
-    PlayerScore(const std::string& n, double w, double a, double t, const std::string& d) 
-        : name(n), wpm(w), accuracy(a), time(t), date(d), wordCount(15), hasPunctuation(false), hasNumbers(false) {}
-    
-    // Constructor without date (for backward compatibility - assumes 15 words, no punctuation/numbers)
-    PlayerScore(const std::string& n, double w, double a, double t) 
-        : name(n), wpm(w), accuracy(a), time(t), wordCount(15), hasPunctuation(false), hasNumbers(false) {
-        // Get current date/time
-        time_t rawtime;
-        struct tm* timeinfo;
-        char buffer[80];
-        
-        ::time(&rawtime);
-        timeinfo = localtime(&rawtime);
-        strftime(buffer, sizeof(buffer), "%m/%d/%Y %H:%M", timeinfo);
-        date = std::string(buffer);
-    }
-    
-    // Default constructor for file loading
-    PlayerScore() : name(""), wpm(0), accuracy(0), time(0), date(""), wordCount(15), hasPunctuation(false), hasNumbers(false) {}
+// Shutdown on SIGINT/SIGTERM. The handler only records the signal. Every key read goes
+// through readKey(), which sees it on the main thread and runs cleanup(), so the
+// queued saves are drained and curses is torn down outside the handler. The process then
+// dies by the same signal, so the shell or supervisor sees how it ended. The handlers are
+// installed without SA_RESTART, so a blocking getch() or poll() returns as soon as one arrives.
+volatile sig_atomic_t pendingSignal = 0;
+
+void cleanup();
+
+void signalHandler(int signum) {
+    pendingSignal = signum;
+}
+
+// getch() that shuts down once a termination signal has arrived
+int readKey() {
+    int ch = getch();
+    if (pendingSignal != 0) {
+        int signum = pendingSignal;
+        cleanup();
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_handler = SIG_DFL;
+        sigemptyset(&action.sa_mask);
+        sigaction(signum, &action, nullptr);
+        raise(signum);
+        _exit(128 + signum);  // Not reached
+    }
+    return ch;
+}
+
+// Frame clock for the animated screens. Each loop waits for input or the next
+// tick, drains every pending key, then repaints once.
+static const int64_t kMenuFrameNs = 100000000;   // Closet and leaderboard: 10 frames/s
+static const int64_t kTypingFrameNs = 33333333;  // Typing screen: 30 frames/s
+
+struct FrameClock {
+    int64_t period_ns;
+    int64_t next_ns;   // Deadline of the next tick
+    int net_fd;        // Race socket that also wakes the loop, -1 for none
+    
+    FrameClock(int64_t period) : period_ns(period), next_ns(monotonicNanos() + period), net_fd(-1) {}
+};
+
+// Sleep until stdin is readable or the tick deadline passes. Returns true when a tick is due,
+// or as soon as net_fd is readable so network updates are drawn without waiting for the tick.
+// Keys must be drained with getch() in nodelay mode before calling, so none sit in curses' queue.
+bool waitForFrame(FrameClock& clock) {
+    int64_t now = monotonicNanos();
+    if (now < clock.next_ns) {
+        struct pollfd pfd[2];
+        pfd[0].fd = STDIN_FILENO;
+        pfd[0].events = POLLIN;
+        pfd[0].revents = 0;
+        pfd[1].fd = clock.net_fd;
+        pfd[1].events = POLLIN;
+        pfd[1].revents = 0;
+        int timeout_ms = (int)((clock.next_ns - now + 999999) / 1000000);  // Round up so we never spin
+        poll(pfd, clock.net_fd >= 0 ? 2 : 1, timeout_ms);
+        if (pfd[1].revents != 0) return true;  // Tick deadline unchanged
+        now = monotonicNanos();
+    }
+    if (now < clock.next_ns) return false;
+    
+    clock.next_ns += clock.period_ns;
+    if (clock.next_ns <= now) clock.next_ns = now + clock.period_ns;  // Fell behind - skip, don't burst
+    return true;
+}
+
+// Puts stdscr in nodelay mode for a frame loop and restores the previous mode on scope exit
+struct NodelayScope {
+    bool previous;
+    
+    NodelayScope() : previous(is_nodelay(stdscr)) { nodelay(stdscr, TRUE); }
+    ~NodelayScope() { nodelay(stdscr, previous); }
+};
+
+// Compositor. The static chrome of a screen (borders, titles, separators, fixed text) is drawn
+// once into an offscreen window and stamped onto stdscr each frame; the screen then draws its
+// dynamic content over it and presents with one doupdate(). Frames start with erase(), not
+// clear(), so curses only sends the cells that changed.
+struct ChromeLayer {
+    WINDOW* win;       // Screen-sized, blank outside the chrome
+    std::string key;   // What the chrome was built for
+    
+    ChromeLayer() : win(nullptr) {}
+};
+
+// Get the layer ready for chrome described by key. Returns true when the caller has to draw the
+// chrome into layer.win; false when the cached chrome is still current. The window is only
+// re-created when the terminal size changes.
+bool prepareChrome(ChromeLayer& layer, const std::string& key) {
+    int max_x, max_y;
+    getmaxyx(stdscr, max_y, max_x);
+    int win_x = 0, win_y = 0;
+    if (layer.win != nullptr) getmaxyx(layer.win, win_y, win_x);
+    
+    if (layer.win == nullptr || win_x != max_x || win_y != max_y) {
+        if (layer.win != nullptr) delwin(layer.win);
+        layer.win = newwin(max_y, max_x, 0, 0);
+        layer.key.clear();
+        if (layer.win == nullptr) return false;
+    } else if (layer.key == key) {
+        return false;
+    }
+    
+    werase(layer.win);
+    layer.key = key;
+    return true;
+}
+
+// Draw a retro box outline
+void drawRetroBox(WINDOW* win, int y, int x, int height, int width) {
+    mvwaddch(win, y, x, ACS_ULCORNER);
+    mvwhline(win, y, x + 1, ACS_HLINE, width - 2);
+    mvwaddch(win, y, x + width - 1, ACS_URCORNER);
+    mvwvline(win, y + 1, x, ACS_VLINE, height - 2);
+    mvwvline(win, y + 1, x + width - 1, ACS_VLINE, height - 2);
+    mvwaddch(win, y + height - 1, x, ACS_LLCORNER);
+    mvwhline(win, y + height - 1, x + 1, ACS_HLINE, width - 2);
+    mvwaddch(win, y + height - 1, x + width - 1, ACS_LRCORNER);
+}
+
+// Draw a title centered in a box with a separator line under it
+void drawBoxHeader(WINDOW* win, int y, int x, int width, const std::string& title, int titleRow, int separatorRow) {
+    mvwprintw(win, y + titleRow, x + (width - (int)title.length()) / 2, "%s", title.c_str());
+    mvwhline(win, y + separatorRow, x + 2, ACS_HLINE, width - 4);
+}
+
+// Copy the chrome onto stdscr. Only its non-blank cells are copied, and nothing is sent yet.
+void stampChrome(const ChromeLayer& layer) {
+    if (layer.win != nullptr) overlay(layer.win, stdscr);
+}
+
+// Chrome of most menus: a retro box with a title and separator, stamped onto stdscr
+void composeBoxChrome(ChromeLayer& layer, int y, int x, int height, int width,
+                      const std::string& title, int titleRow, int separatorRow) {
+    std::string key = std::to_string(y) + "," + std::to_string(x) + "," + std::to_string(height) + "," +
+                      std::to_string(width) + "," + title;
+    if (prepareChrome(layer, key)) {
+        drawRetroBox(layer.win, y, x, height, width);
+        drawBoxHeader(layer.win, y, x, width, title, titleRow, separatorRow);
+    }
+    stampChrome(layer);
+}
+
+// Send the finished frame to the terminal in one update
+void presentFrame() {
+    wnoutrefresh(stdscr);
+    doupdate();
+}
+
+// Frame profiler (--profile). Times the stages of every typing frame that handled input,
+// from the wake-up to the end of doupdate(), and counts the bytes written to the terminal
+// for it. Shown as an overlay on the bottom row; the histograms are written to a file on
+// exit. Without --profile frameProfiler is null and each hook is one pointer test.
+enum ProfileStage {
+    STAGE_INPUT,     // Reading keys with getch()
+    STAGE_UPDATE,    // Typing state, recorder and live stats
+    STAGE_LAYOUT,    // Wrap layout (only when the text or width changed)
+    STAGE_DRAW,      // Curses draw calls into stdscr
+    STAGE_REFRESH,   // doupdate() - computing and writing the terminal output
+    STAGE_FRAME,     // Whole frame
+    STAGE_COUNT
+};
+
+static const char* const kProfileStageNames[STAGE_COUNT] = {
+    "input", "update", "layout", "draw", "refresh", "frame"
+};
+
+struct FrameProfiler {
+    std::string path;                       // Report written on exit
+    int io_fd;                              // /proc/self/io, -1 if unavailable
+    LatencyHistogram stages[STAGE_COUNT];
+    int64_t current_ns[STAGE_COUNT];        // Stage times of the frame in progress
+    int64_t last_ns[STAGE_COUNT];           // Stage times of the latest recorded frame
+    int64_t frame_start_ns;
+    int64_t frame_bytes_start;
+    int64_t bytes_total;                    // Terminal output of the recorded frames
+    int64_t bytes_max;
+    int64_t bytes_last;
+    
+    FrameProfiler(const std::string& p) : path(p), io_fd(-1), frame_start_ns(0), frame_bytes_start(0),
+                                          bytes_total(0), bytes_max(0), bytes_last(0) {
+        for (int i = 0; i < STAGE_COUNT; i++) current_ns[i] = last_ns[i] = 0;
+    }
 };
 
-// Function to get unique player names from leaderboard and save files
+// Active profiler, or nullptr
+FrameProfiler* frameProfiler = nullptr;
+
+// Bytes this process has written so far (wchar in /proc/self/io), or -1.
+// Curses writes straight to the terminal's file descriptor, so this is the only way to see
+// its output without putting a pty in between.
+static int64_t processBytesWritten(const FrameProfiler& profiler) {
+    if (profiler.io_fd < 0) return -1;
+    char buf[512];
+    ssize_t n = pread(profiler.io_fd, buf, sizeof(buf) - 1, 0);
+    if (n <= 0) return -1;
+    buf[n] = '\0';
+    const char* wchar = strstr(buf, "wchar:");
+    return wchar != nullptr ? strtoll(wchar + 6, nullptr, 10) : -1;
+}
+
+// Profile into path from now on
+void enableProfiler(const std::string& path) {
+    frameProfiler = new FrameProfiler(path);
+    frameProfiler->io_fd = open("/proc/self/io", O_RDONLY);
+}
+
+// Start timing a frame
+void profileBeginFrame(FrameProfiler& profiler) {
+    for (int i = 0; i < STAGE_COUNT; i++) profiler.current_ns[i] = 0;
+    profiler.frame_bytes_start = processBytesWritten(profiler);
+    profiler.frame_start_ns = monotonicNanos();
+}
+
+// Finish the frame in progress and add it to the histograms
+void profileEndFrame(FrameProfiler& profiler) {
+    profiler.current_ns[STAGE_FRAME] = monotonicNanos() - profiler.frame_start_ns;
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        recordLatency(profiler.stages[i], profiler.current_ns[i]);
+        profiler.last_ns[i] = profiler.current_ns[i];
+    }
+    
+    int64_t bytes = processBytesWritten(profiler);
+    if (bytes >= 0 && profiler.frame_bytes_start >= 0) {
+        profiler.bytes_last = bytes - profiler.frame_bytes_start;
+        profiler.bytes_total += profiler.bytes_last;
+        profiler.bytes_max = std::max(profiler.bytes_max, profiler.bytes_last);
+    }
+}
+
+// readKey() that charges its time to the input stage
+int profiledGetch() {
+    if (frameProfiler == nullptr) return readKey();
+    int64_t start = monotonicNanos();
+    int ch = readKey();
+    frameProfiler->current_ns[STAGE_INPUT] += monotonicNanos() - start;
+    return ch;
+}
+
+// Draw the profile summary on the bottom row of the terminal
+void drawProfileOverlay(const FrameProfiler& profiler) {
+    int max_x, max_y;
+    getmaxyx(stdscr, max_y, max_x);
+    const LatencyHistogram& frame = profiler.stages[STAGE_FRAME];
+    uint64_t frames = frame.samples;
+    
+    char text[256];
+    snprintf(text, sizeof(text),
+             "PROFILE %llu frames | p50 %.0fus p99 %.0fus max %.0fus | %lld B/frame (max %lld) | "
+             "in %.0f upd %.0f lay %.0f draw %.0f ref %.0f us",
+             (unsigned long long)frames, latencyPercentile(frame, 0.50) / 1000.0,
+             latencyPercentile(frame, 0.99) / 1000.0, frame.max_ns / 1000.0,
+             frames > 0 ? (long long)(profiler.bytes_total / (int64_t)frames) : 0LL, (long long)profiler.bytes_max,
+             profiler.last_ns[STAGE_INPUT] / 1000.0, profiler.last_ns[STAGE_UPDATE] / 1000.0,
+             profiler.last_ns[STAGE_LAYOUT] / 1000.0, profiler.last_ns[STAGE_DRAW] / 1000.0,
+             profiler.last_ns[STAGE_REFRESH] / 1000.0);
+    mvprintw(max_y - 1, 0, "%-*.*s", max_x - 1, max_x - 1, text);
+}
+
+// Write the per-stage summary and the frame latency histogram
+void writeProfileReport(const FrameProfiler& profiler) {
+    FILE* file = fopen(profiler.path.c_str(), "w");
+    if (file == nullptr) {
+        fprintf(stderr, "wormtype: could not write profile '%s'\n", profiler.path.c_str());
+        return;
+    }
+    
+    const LatencyHistogram& frame = profiler.stages[STAGE_FRAME];
+    fprintf(file, "# wormtype frame profile: %llu frames with input\n", (unsigned long long)frame.samples);
+    fprintf(file, "# stage      p50_us    p99_us    max_us   mean_us\n");
+    for (int i = 0; i < STAGE_COUNT; i++) {
+        const LatencyHistogram& stage = profiler.stages[i];
+        fprintf(file, "%-8s  %8.1f  %8.1f  %8.1f  %8.1f\n", kProfileStageNames[i],
+                latencyPercentile(stage, 0.50) / 1000.0, latencyPercentile(stage, 0.99) / 1000.0,
+                stage.max_ns / 1000.0, stage.samples > 0 ? stage.total_ns / 1000.0 / stage.samples : 0.0);
+    }
+    fprintf(file, "# terminal bytes per frame: mean %.1f max %lld\n",
+            frame.samples > 0 ? (double)profiler.bytes_total / frame.samples : 0.0, (long long)profiler.bytes_max);
+    
+    // One line per non-empty bucket: lower edge in microseconds, sample count
+    fprintf(file, "# frame latency histogram: bucket_us count\n");
+    for (int i = 0; i < kLatencyBucketCount; i++) {
+        if (frame.counts[i] > 0) {
+            fprintf(file, "%.3f %llu\n", latencyBucketFloor(i) / 1000.0, (unsigned long long)frame.counts[i]);
+        }
+    }
+    fclose(file);
+}
+
+// Function to get unique player names: players on the leaderboard first (in rank order),
+// then everyone else in the name registry who has scores or a profile
 std::vector<std::string> getUniquePlayerNames(const std::vector<PlayerScore>& leaderboard) {
     std::vector<std::string> uniqueNames;
+    std::vector<bool> listed(nameRegistry.names.size(), false);  // By registry id
     
     // Add names from leaderboard
     for (size_t i = 0; i < leaderboard.size(); i++) {
-        const std::string& name = leaderboard[i].name;
-        bool found = false;
-        
-        // Check if name already exists in uniqueNames
-        for (size_t j = 0; j < uniqueNames.size(); j++) {
-            if (uniqueNames[j] == name) {
-                found = true;
-                break;
-            }
-        }
-        
-        if (!found) {
-            uniqueNames.push_back(name);
+        uint32_t id = leaderboard[i].playerId;
+        if (id >= listed.size()) listed.resize(id + 1, false);
+        if (!listed[id]) {
+            listed[id] = true;
+            uniqueNames.push_back(leaderboard[i].name());
         }
     }
     
-    // Add names from saved players (those who have save files but may not be on leaderboard)
-    std::vector<std::string> savedNames = getAllSavedPlayerNames();
-    for (size_t i = 0; i < savedNames.size(); i++) {
-        const std::string& name = savedNames[i];
-        bool found = false;
-        
-        // Check if name already exists in uniqueNames
-        for (size_t j = 0; j < uniqueNames.size(); j++) {
-            if (uniqueNames[j] == name) {
-                found = true;
-                break;
-            }
-        }
-        
-        if (!found) {
-            uniqueNames.push_back(name);
+    // Add every other known player (history and saved profiles)
+    for (size_t id = 0; id < nameRegistry.names.size() && id < listed.size(); id++) {
+        if (!listed[id] && nameRegistry.sources[id] != 0) {
+            uniqueNames.push_back(nameRegistry.names[id]);
         }
     }
     
     return uniqueNames;
 }
 
+// Narrow matches to the names containing filter (case-insensitive).
+// When the filter only grew, the previous matches are searched instead of every name.
+static void filterNames(const std::vector<std::string>& names, const std::string& filter,
+                        bool extended, std::vector<size_t>& matches) {
+    std::string needle = toUpperCase(filter);
+    std::vector<size_t> candidates;
+    if (extended) {
+        candidates.swap(matches);
+    } else {
+        for (size_t i = 0; i < names.size(); i++) candidates.push_back(i);
+    }
+    
+    matches.clear();
+    for (size_t i = 0; i < candidates.size(); i++) {
+        if (needle.empty() || toUpperCase(names[candidates[i]]).find(needle) != std::string::npos) {
+            matches.push_back(candidates[i]);
+        }
+    }
+}
+
 // Function to show name selection menu
+// Type '/' to search: letters then narrow the list, Backspace edits, ESC clears the search.
 std::string showNameSelectionMenu(const std::vector<std::string>& names) {
     int max_x, max_y;
     int choice = 0;
     int ch;
+    int scroll = 0;                // First match shown in the list
+    std::string filter;            // Search text
+    bool searching = false;        // Letters go to the search text
+    std::vector<size_t> matches;   // Indexes into names that pass the filter
+    filterNames(names, filter, false, matches);
     
     while (true) {
         getmaxyx(stdscr, max_y, max_x);
-        clear();
+        erase();
+        
+        int matchCount = (int)matches.size();
         
         // Calculate box dimensions
         int box_width = 40;
-        int box_height = names.size() + 8;  // Title + names + new name option + delete option + padding
-        if (box_height > max_y - 4) box_height = max_y - 4;
+        int visible = max_y - 4 - 10;  // Rows left for names inside the box
+        if (visible < 1) visible = 1;
+        if (visible > matchCount) visible = matchCount;
+        int box_height = visible + 10;  // Title + search + names + new name option + delete option + padding
         int box_start_x = (max_x - box_width) / 2;
         int box_start_y = (max_y - box_height) / 2;
         
-        // Draw retro box border
-        // Top border
-        mvaddch(box_start_y, box_start_x, ACS_ULCORNER);
-        for (int x = box_start_x + 1; x < box_start_x + box_width - 1; x++) {
-            mvaddch(box_start_y, x, ACS_HLINE);
-        }
-        mvaddch(box_start_y, box_start_x + box_width - 1, ACS_URCORNER);
-        
-        // Side borders
-        for (int y = box_start_y + 1; y < box_start_y + box_height - 1; y++) {
-            mvaddch(y, box_start_x, ACS_VLINE);
-            mvaddch(y, box_start_x + box_width - 1, ACS_VLINE);
-        }
-        
-        // Bottom border
-        mvaddch(box_start_y + box_height - 1, box_start_x, ACS_LLCORNER);
-        for (int x = box_start_x + 1; x < box_start_x + box_width - 1; x++) {
-            mvaddch(box_start_y + box_height - 1, x, ACS_HLINE);
+        // Keep the selected name in view
+        if (choice < matchCount) {
+            if (choice < scroll) scroll = choice;
+            if (choice >= scroll + visible) scroll = choice - visible + 1;
         }
-        mvaddch(box_start_y + box_height - 1, box_start_x + box_width - 1, ACS_LRCORNER);
+        if (scroll > matchCount - visible) scroll = matchCount - visible;
+        if (scroll < 0) scroll = 0;
         
-        // Title inside box
+        // Box, title and separator come from the cached chrome
+        static ChromeLayer chrome;
         std::string title = "SELECT YOUR NAME";
-        mvprintw(box_start_y + 2, box_start_x + (box_width - title.length()) / 2, "%s", title.c_str());
-        
-        // Draw separator line
-        for (int x = box_start_x + 2; x < box_start_x + box_width - 2; x++) {
-            mvaddch(box_start_y + 3, x, ACS_HLINE);
-        }
-        
-        // Show previous names inside box
-        int startY = box_start_y + 5;
+        composeBoxChrome(chrome, box_start_y, box_start_x, box_height, box_width, title, 2, 3);
+        
+        // Search line with match count
+        std::string searchLine = (searching || !filter.empty()) ? "Search: " + filter + (searching ? "_" : "")
+                                                                 : "Press / to search";
+        char countText[32];
+        snprintf(countText, sizeof(countText), "%d/%d", matchCount, (int)names.size());
+        mvprintw(box_start_y + 4, box_start_x + 3, "%.*s", box_width - 12, searchLine.c_str());
+        mvprintw(box_start_y + 4, box_start_x + box_width - 3 - (int)strlen(countText), "%s", countText);
+        
+        // Show the visible window of matching names inside box
+        int startY = box_start_y + 6;
         int center_x = box_start_x + box_width / 2;
         
-        for (size_t i = 0; i < names.size() && i < 6; i++) {  // Show max 6 names to fit in box
-            std::string displayName = toUpperCase(names[i]);
+        for (int row = 0; row < visible; row++) {
+            int i = scroll + row;
+            std::string displayName = toUpperCase(names[matches[i]]);
             if (displayName.length() > 32) {
                 displayName = displayName.substr(0, 29) + "...";
             }
             
             // Highlight selected option - center the text
-            if (choice == (int)i) {
+            if (choice == i) {
                 std::string fullOption = "[" + displayName + "]";
                 int option_x = center_x - fullOption.length() / 2;
-                mvprintw(startY + i, option_x, "%s", fullOption.c_str());
+                mvprintw(startY + row, option_x, "%s", fullOption.c_str());
             } else {
                 int option_x = center_x - displayName.length() / 2;
-                mvprintw(startY + i, option_x, "%s", displayName.c_str());
+                mvprintw(startY + row, option_x, "%s", displayName.c_str());
             }
         }
         
+        // Scroll markers when names are hidden above or below
+        if (scroll > 0) mvaddch(startY, box_start_x + box_width - 3, '^');
+        if (scroll + visible < matchCount) mvaddch(startY + visible - 1, box_start_x + box_width - 3, 'v');
+        
         // Add "Enter new name" option inside box
         std::string newNameOption = "Create New Player";
-        if (choice == (int)names.size()) {
+        if (choice == matchCount) {
             std::string fullOption = "[" + newNameOption + "]";
             int option_x = center_x - fullOption.length() / 2;
-            mvprintw(startY + names.size(), option_x, "%s", fullOption.c_str());
+            mvprintw(startY + visible, option_x, "%s", fullOption.c_str());
         } else {
             int option_x = center_x - newNameOption.length() / 2;
-            mvprintw(startY + names.size(), option_x, "%s", newNameOption.c_str());
+            mvprintw(startY + visible, option_x, "%s", newNameOption.c_str());
         }
         
         // Add "Delete All Saved Players" option inside box
         std::string deleteOption = "Delete All Saved Players";
-        if (choice == (int)names.size() + 1) {
+        if (choice == matchCount + 1) {
             std::string fullOption = "[" + deleteOption + "]";
             int option_x = center_x - fullOption.length() / 2;
-            mvprintw(startY + names.size() + 1, option_x, "%s", fullOption.c_str());
+            mvprintw(startY + visible + 1, option_x, "%s", fullOption.c_str());
         } else {
             int option_x = center_x - deleteOption.length() / 2;
-            mvprintw(startY + names.size() + 1, option_x, "%s", deleteOption.c_str());
+            mvprintw(startY + visible + 1, option_x, "%s", deleteOption.c_str());
         }
         
-        
-        refresh();
-        
         // Instructions at bottom of terminal (outside box)
-        std::string instructions = "WASD/Arrows + Enter | Q: Back";
+        std::string instructions = searching ? "Type to filter | Arrows + Enter | ESC: Clear search"
+                                             : "WASD/Arrows + Enter | /: Search | Q: Back";
         mvprintw(max_y - 2, (max_x - instructions.length()) / 2, "%s", instructions.c_str());
         
         // Add program-wide worm closet instruction
         std::string wormInstruction = "Press W for Worm Closet";
         mvprintw(max_y - 1, (max_x - wormInstruction.length()) / 2, "%s", wormInstruction.c_str());
         
-        ch = getch();
-        if (ch == 'W') {  // Only capital W for worm closet
+        presentFrame();
+        
+        ch = readKey();
+        if (searching && ch == 27) {  // ESC - clear the search
+            searching = false;
+            filter.clear();
+            filterNames(names, filter, false, matches);
+            choice = 0;
+        } else if (searching && (ch == KEY_BACKSPACE || ch == 127 || ch == 8)) {
+            if (!filter.empty()) {
+                filter.erase(filter.length() - 1);
+                filterNames(names, filter, false, matches);
+                choice = 0;
+            }
+        } else if (searching && ch >= 32 && ch < 127) {
+            filter += (char)ch;
+            filterNames(names, filter, true, matches);
+            choice = 0;
+        } else if (ch == '/') {
+            searching = true;
+        } else if (ch == 'W') {  // Only capital W for worm closet
             return "WORM_CLOSET";  // Signal to open worm closet
         } else if ((ch == KEY_UP || ch == 'w') && choice > 0) {  // Added 'w' for up movement
             choice--;
-        } else if ((ch == KEY_DOWN || ch == 's' || ch == 'S') && choice < (int)names.size() + 1) {  // names.size() + "new name" + "delete"
+        } else if ((ch == KEY_DOWN || ch == 's' || ch == 'S') && choice < matchCount + 1) {  // matches + "new name" + "delete"
             choice++;
         } else if (ch == 10 || ch == 13) { // Enter
-            if (choice < (int)names.size()) {
-                return names[choice];  // Return selected existing name
-            } else if (choice == (int)names.size()) {
+            if (choice < matchCount) {
+                return names[matches[choice]];  // Return selected existing name
+            } else if (choice == matchCount) {
                 return "";  // Signal to enter new name
-            } else if (choice == (int)names.size() + 1) {
+            } else if (choice == matchCount + 1) {
                 return "DELETE_ALL";  // Signal to delete all saved players
             }
         } else if (ch == 'q' || ch == 'Q') { // Q - go back to main menu
@@ -313,7 +669,7 @@ std::string getNewPlayerName() {
     
     while (true) {
         getmaxyx(stdscr, max_y, max_x);
-        clear();
+        erase();
         
         // Calculate box dimensions
         int box_width = 40;
@@ -321,35 +677,10 @@ std::string getNewPlayerName() {
         int box_start_x = (max_x - box_width) / 2;
         int box_start_y = (max_y - box_height) / 2;
         
-        // Draw retro box border
-        // Top border
-        mvaddch(box_start_y, box_start_x, ACS_ULCORNER);
-        for (int x = box_start_x + 1; x < box_start_x + box_width - 1; x++) {
-            mvaddch(box_start_y, x, ACS_HLINE);
-        }
-        mvaddch(box_start_y, box_start_x + box_width - 1, ACS_URCORNER);
-        
-        // Side borders
-        for (int y = box_start_y + 1; y < box_start_y + box_height - 1; y++) {
-            mvaddch(y, box_start_x, ACS_VLINE);
-            mvaddch(y, box_start_x + box_width - 1, ACS_VLINE);
-        }
-        
-        // Bottom border
-        mvaddch(box_start_y + box_height - 1, box_start_x, ACS_LLCORNER);
-        for (int x = box_start_x + 1; x < box_start_x + box_width - 1; x++) {
-            mvaddch(box_start_y + box_height - 1, x, ACS_HLINE);
-        }
-        mvaddch(box_start_y + box_height - 1, box_start_x + box_width - 1, ACS_LRCORNER);
-        
-        // Title inside box
+        // Box, title and separator come from the cached chrome
+        static ChromeLayer chrome;
         std::string title = "CREATE PLAYER";
-        mvprintw(box_start_y + 1, box_start_x + (box_width - title.length()) / 2, "%s", title.c_str());
-        
-        // Draw separator line
-        for (int x = box_start_x + 2; x < box_start_x + box_width - 2; x++) {
-            mvaddch(box_start_y + 2, x, ACS_HLINE);
-        }
+        composeBoxChrome(chrome, box_start_y, box_start_x, box_height, box_width, title, 1, 2);
         
         // Input field inside box
         mvprintw(box_start_y + 4, box_start_x + 3, "Name: ");
@@ -367,17 +698,17 @@ std::string getNewPlayerName() {
         }
         mvprintw(box_start_y + 4, input_start_x, "%-*s", input_width, displayName.c_str());
         
+        // Instructions at bottom of terminal (outside box)
+        std::string instructions = name.empty() ? "Type your name..." : "Enter: Confirm | Q: Back";
+        mvprintw(max_y - 1, (max_x - instructions.length()) / 2, "%s", instructions.c_str());
+        
         // Show cursor at input position
         curs_set(1);
         move(box_start_y + 4, input_start_x + displayName.length());
         
-        refresh();
-        
-        // Instructions at bottom of terminal (outside box)
-        std::string instructions = name.empty() ? "Type your name..." : "Enter: Confirm | Q: Back";
-        mvprintw(max_y - 1, (max_x - instructions.length()) / 2, "%s", instructions.c_str());
+        presentFrame();
         
-        ch = getch();
+        ch = readKey();
         if ((ch == 10 || ch == 13) && !name.empty()) { // Enter key and name not empty
             break;
         } else if (ch == 'q' || ch == 'Q') { // Q - go back
@@ -407,7 +738,7 @@ int getCustomWordCount() {
     
     while (true) {
         getmaxyx(stdscr, max_y, max_x);
-        clear();
+        erase();
         
         // Calculate box dimensions
         int box_width = 40;
@@ -415,35 +746,10 @@ int getCustomWordCount() {
         int box_start_x = (max_x - box_width) / 2;
         int box_start_y = (max_y - box_height) / 2;
         
-        // Draw retro box border
-        // Top border
-        mvaddch(box_start_y, box_start_x, ACS_ULCORNER);
-        for (int x = box_start_x + 1; x < box_start_x + box_width - 1; x++) {
-            mvaddch(box_start_y, x, ACS_HLINE);
-        }
-        mvaddch(box_start_y, box_start_x + box_width - 1, ACS_URCORNER);
-        
-        // Side borders
-        for (int y = box_start_y + 1; y < box_start_y + box_height - 1; y++) {
-            mvaddch(y, box_start_x, ACS_VLINE);
-            mvaddch(y, box_start_x + box_width - 1, ACS_VLINE);
-        }
-        
-        // Bottom border
-        mvaddch(box_start_y + box_height - 1, box_start_x, ACS_LLCORNER);
-        for (int x = box_start_x + 1; x < box_start_x + box_width - 1; x++) {
-            mvaddch(box_start_y + box_height - 1, x, ACS_HLINE);
-        }
-        mvaddch(box_start_y + box_height - 1, box_start_x + box_width - 1, ACS_LRCORNER);
-        
-        // Title inside box
+        // Box, title and separator come from the cached chrome
+        static ChromeLayer chrome;
         std::string title = "CUSTOM WORD COUNT";
-        mvprintw(box_start_y + 1, box_start_x + (box_width - title.length()) / 2, "%s", title.c_str());
-        
-        // Draw separator line
-        for (int x = box_start_x + 2; x < box_start_x + box_width - 2; x++) {
-            mvaddch(box_start_y + 2, x, ACS_HLINE);
-        }
+        composeBoxChrome(chrome, box_start_y, box_start_x, box_height, box_width, title, 1, 2);
         
         // Input field inside box
         mvprintw(box_start_y + 4, box_start_x + 3, "Words: ");
@@ -461,17 +767,17 @@ int getCustomWordCount() {
         }
         mvprintw(box_start_y + 4, input_start_x, "%-*s", input_width, displayInput.c_str());
         
+        // Instructions at bottom of terminal (outside box)
+        std::string instructions = input.empty() ? "Enter number of words (1-1000)..." : "Enter: Confirm | Q: Back";
+        mvprintw(max_y - 1, (max_x - instructions.length()) / 2, "%s", instructions.c_str());
+        
         // Show cursor at input position
         curs_set(1);
         move(box_start_y + 4, input_start_x + displayInput.length());
         
-        refresh();
-        
-        // Instructions at bottom of terminal (outside box)
-        std::string instructions = input.empty() ? "Enter number of words (1-1000)..." : "Enter: Confirm | Q: Back";
-        mvprintw(max_y - 1, (max_x - instructions.length()) / 2, "%s", instructions.c_str());
+        presentFrame();
         
-        ch = getch();
+        ch = readKey();
         if ((ch == 10 || ch == 13) && !input.empty()) { // Enter key and input not empty
             try {
                 int wordCount = std::stoi(input);
@@ -505,8 +811,15 @@ struct GameSettings {
     bool includeNumbers;
     bool isCustomWordCount;
     int customWords;
+    int timedSeconds;   // Length of a timed test; 0 for a word-count test
+    bool endless;       // Endless practice: streamed text, no score
+    bool weakKeys;      // Weak-key practice: words weighted to the player's slow bigrams, no score
 };
 
+// Lengths the timed option cycles through
+static const int kTimedDurations[] = {15, 30, 60, 120};
+static const int kTimedDurationCount = sizeof(kTimedDurations) / sizeof(kTimedDurations[0]);
+
 
 // Function to show word count selection menu
 int showWordCountMenu() {
@@ -521,7 +834,7 @@ int showWordCountMenu() {
     
     while (true) {
         getmaxyx(stdscr, max_y, max_x);
-        clear();
+        erase();
         
         // Calculate box dimensions
         int box_width = 30;
@@ -529,35 +842,10 @@ int showWordCountMenu() {
         int box_start_x = (max_x - box_width) / 2;
         int box_start_y = (max_y - box_height) / 2;
         
-        // Draw retro box border
-        // Top border
-        mvaddch(box_start_y, box_start_x, ACS_ULCORNER);
-        for (int x = box_start_x + 1; x < box_start_x + box_width - 1; x++) {
-            mvaddch(box_start_y, x, ACS_HLINE);
-        }
-        mvaddch(box_start_y, box_start_x + box_width - 1, ACS_URCORNER);
-        
-        // Side borders
-        for (int y = box_start_y + 1; y < box_start_y + box_height - 1; y++) {
-            mvaddch(y, box_start_x, ACS_VLINE);
-            mvaddch(y, box_start_x + box_width - 1, ACS_VLINE);
-        }
-        
-        // Bottom border
-        mvaddch(box_start_y + box_height - 1, box_start_x, ACS_LLCORNER);
-        for (int x = box_start_x + 1; x < box_start_x + box_width - 1; x++) {
-            mvaddch(box_start_y + box_height - 1, x, ACS_HLINE);
-        }
-        mvaddch(box_start_y + box_height - 1, box_start_x + box_width - 1, ACS_LRCORNER);
-        
-        // Title inside box
+        // Box, title and separator come from the cached chrome
+        static ChromeLayer chrome;
         std::string title = "WORD COUNT";
-        mvprintw(box_start_y + 2, box_start_x + (box_width - title.length()) / 2, "%s", title.c_str());
-        
-        // Draw separator line
-        for (int x = box_start_x + 2; x < box_start_x + box_width - 2; x++) {
-            mvaddch(box_start_y + 3, x, ACS_HLINE);
-        }
+        composeBoxChrome(chrome, box_start_y, box_start_x, box_height, box_width, title, 2, 3);
         
         // Show word count options inside box
         int startY = box_start_y + 5;
@@ -580,13 +868,13 @@ int showWordCountMenu() {
             mvprintw(startY + wordCounts.size(), box_start_x + 4, "%s", customOption.c_str());
         }
         
-        refresh();
-        
         // Instructions at bottom of terminal (outside box)
         std::string instructions = "WASD/Arrows + Enter | Q: Back";
         mvprintw(max_y - 1, (max_x - instructions.length()) / 2, "%s", instructions.c_str());
         
-        ch = getch();
+        presentFrame();
+        
+        ch = readKey();
         if ((ch == KEY_UP || ch == 'w' || ch == 'W') && choice > 0) {
             choice--;
         } else if ((ch == KEY_DOWN || ch == 's' || ch == 'S') && choice < (int)wordCounts.size()) {
@@ -620,7 +908,7 @@ void showTextOptionsMenu(bool& includePunctuation, bool& includeNumbers) {
     
     while (true) {
         getmaxyx(stdscr, max_y, max_x);
-        clear();
+        erase();
         
         // Calculate box dimensions
         int box_width = 38;
@@ -628,35 +916,10 @@ void showTextOptionsMenu(bool& includePunctuation, bool& includeNumbers) {
         int box_start_x = (max_x - box_width) / 2;
         int box_start_y = (max_y - box_height) / 2;
         
-        // Draw retro box border
-        // Top border
-        mvaddch(box_start_y, box_start_x, ACS_ULCORNER);
-        for (int x = box_start_x + 1; x < box_start_x + box_width - 1; x++) {
-            mvaddch(box_start_y, x, ACS_HLINE);
-        }
-        mvaddch(box_start_y, box_start_x + box_width - 1, ACS_URCORNER);
-        
-        // Side borders
-        for (int y = box_start_y + 1; y < box_start_y + box_height - 1; y++) {
-            mvaddch(y, box_start_x, ACS_VLINE);
-            mvaddch(y, box_start_x + box_width - 1, ACS_VLINE);
-        }
-        
-        // Bottom border
-        mvaddch(box_start_y + box_height - 1, box_start_x, ACS_LLCORNER);
-        for (int x = box_start_x + 1; x < box_start_x + box_width - 1; x++) {
-            mvaddch(box_start_y + box_height - 1, x, ACS_HLINE);
-        }
-        mvaddch(box_start_y + box_height - 1, box_start_x + box_width - 1, ACS_LRCORNER);
-        
-        // Title inside box
+        // Box, title and separator come from the cached chrome
+        static ChromeLayer chrome;
         std::string title = "TEXT OPTIONS";
-        mvprintw(box_start_y + 2, box_start_x + (box_width - title.length()) / 2, "%s", title.c_str());
-        
-        // Draw separator line
-        for (int x = box_start_x + 2; x < box_start_x + box_width - 2; x++) {
-            mvaddch(box_start_y + 3, x, ACS_HLINE);
-        }
+        composeBoxChrome(chrome, box_start_y, box_start_x, box_height, box_width, title, 2, 3);
         
         // Show options with checkboxes inside box
         int startY = box_start_y + 5;
@@ -678,8 +941,6 @@ void showTextOptionsMenu(bool& includePunctuation, bool& includeNumbers) {
             mvprintw(startY + 1, box_start_x + 5, "%s", numbersOption.c_str());
         }
         
-        refresh();
-        
         // Instructions at bottom of terminal (outside box)
         std::string instructions = "WASD/Arrows: Navigate | Space: Toggle | Enter: Continue | Q: Back";
         mvprintw(max_y - 2, (max_x - instructions.length()) / 2, "%s", instructions.c_str());
@@ -688,7 +949,9 @@ void showTextOptionsMenu(bool& includePunctuation, bool& includeNumbers) {
         std::string wormInstruction = "Press W for Worm Closet";
         mvprintw(max_y - 1, (max_x - wormInstruction.length()) / 2, "%s", wormInstruction.c_str());
         
-        ch = getch();
+        presentFrame();
+        
+        ch = readKey();
         if ((ch == KEY_UP || ch == 'w' || ch == 'W') && choice > 0) {
             choice--;
         } else if ((ch == KEY_DOWN || ch == 's' || ch == 'S') && choice < 1) {
@@ -715,10 +978,12 @@ bool showWormCloset() {
     int choice = 0;
     int ch;
     int worm_frame = 0;  // Animation frame counter for decorative worms
+    NodelayScope nodelayScope;
+    FrameClock frameClock(kMenuFrameNs);
     
     while (true) {
         getmaxyx(stdscr, max_y, max_x);
-        clear();
+        erase();
         
         // Calculate box dimensions
         int box_width = 50;
@@ -726,35 +991,10 @@ bool showWormCloset() {
         int box_start_x = (max_x - box_width) / 2;
         int box_start_y = (max_y - box_height) / 2;
         
-        // Draw retro box border
-        // Top border
-        mvaddch(box_start_y, box_start_x, ACS_ULCORNER);
-        for (int x = box_start_x + 1; x < box_start_x + box_width - 1; x++) {
-            mvaddch(box_start_y, x, ACS_HLINE);
-        }
-        mvaddch(box_start_y, box_start_x + box_width - 1, ACS_URCORNER);
-        
-        // Side borders
-        for (int y = box_start_y + 1; y < box_start_y + box_height - 1; y++) {
-            mvaddch(y, box_start_x, ACS_VLINE);
-            mvaddch(y, box_start_x + box_width - 1, ACS_VLINE);
-        }
-        
-        // Bottom border
-        mvaddch(box_start_y + box_height - 1, box_start_x, ACS_LLCORNER);
-        for (int x = box_start_x + 1; x < box_start_x + box_width - 1; x++) {
-            mvaddch(box_start_y + box_height - 1, x, ACS_HLINE);
-        }
-        mvaddch(box_start_y + box_height - 1, box_start_x + box_width - 1, ACS_LRCORNER);
-        
-        // Title inside box
+        // Box, title and separator come from the cached chrome
+        static ChromeLayer chrome;
         std::string title = "WORM CLOSET";
-        mvprintw(box_start_y + 2, box_start_x + (box_width - title.length()) / 2, "%s", title.c_str());
-        
-        // Draw separator line
-        for (int x = box_start_x + 2; x < box_start_x + box_width - 2; x++) {
-            mvaddch(box_start_y + 3, x, ACS_HLINE);
-        }
+        composeBoxChrome(chrome, box_start_y, box_start_x, box_height, box_width, title, 2, 3);
         
         // Show achievement grid (3x3 for future expansion)
         int startY = box_start_y + 5;
@@ -771,187 +1011,47 @@ bool showWormCloset() {
                 bool isUnlocked = false;
                 std::string slotContent = "[ ]";
                 
-                // Check worm slots
+                // Worm slots come from the skin table, the rest are empty
                 int slot_id = row * 3 + col;
-                if (slot_id == 0) {
-                    // Default worm (always available)
-                    isUnlocked = true;
-                    if (currentPlayerData != nullptr && currentPlayerData->equippedWormColor == "default") {
-                        slotContent = "[*]";  // Equipped
-                    } else {
-                        slotContent = "[D]";  // Default available
-                    }
-                } else if (slot_id == 1) {
-                    // Pink worm (60+ WPM)
-                    if (currentPlayerData != nullptr) {
-                        for (size_t i = 0; i < currentPlayerData->achievements.size(); i++) {
-                            if (currentPlayerData->achievements[i].id == "pink_worm" && currentPlayerData->achievements[i].unlocked) {
-                                isUnlocked = true;
-                                if (currentPlayerData->equippedWormColor == "pink") {
-                                    slotContent = "[*]";  // Equipped
-                                } else {
-                                    slotContent = "[P]";  // Pink available
-                                }
-                                break;
-                            }
-                        }
-                    }
-                    if (!isUnlocked) {
-                        slotContent = "[?]";  // Locked
-                    }
-                } else if (slot_id == 2) {
-                    // Blue worm (75+ WPM)
-                    if (currentPlayerData != nullptr) {
-                        for (size_t i = 0; i < currentPlayerData->achievements.size(); i++) {
-                            if (currentPlayerData->achievements[i].id == "blue_worm" && currentPlayerData->achievements[i].unlocked) {
-                                isUnlocked = true;
-                                if (currentPlayerData->equippedWormColor == "blue") {
-                                    slotContent = "[*]";  // Equipped
-                                } else {
-                                    slotContent = "[B]";  // Blue available
-                                }
-                                break;
-                            }
-                        }
-                    }
-                    if (!isUnlocked) {
-                        slotContent = "[?]";  // Locked
-                    }
-                } else if (slot_id == 3) {
-                    // Magenta worm (80+ WPM)
-                    if (currentPlayerData != nullptr) {
-                        for (size_t i = 0; i < currentPlayerData->achievements.size(); i++) {
-                            if (currentPlayerData->achievements[i].id == "magenta_worm" && currentPlayerData->achievements[i].unlocked) {
-                                isUnlocked = true;
-                                if (currentPlayerData->equippedWormColor == "magenta") {
-                                    slotContent = "[*]";  // Equipped
-                                } else {
-                                    slotContent = "[M]";  // Magenta available
-                                }
-                                break;
-                            }
-                        }
-                    }
-                    if (!isUnlocked) {
-                        slotContent = "[?]";  // Locked
-                    }
-                } else if (slot_id == 4) {
-                    // Yellow worm (90+ WPM)
-                    if (currentPlayerData != nullptr) {
-                        for (size_t i = 0; i < currentPlayerData->achievements.size(); i++) {
-                            if (currentPlayerData->achievements[i].id == "yellow_worm" && currentPlayerData->achievements[i].unlocked) {
-                                isUnlocked = true;
-                                if (currentPlayerData->equippedWormColor == "yellow") {
-                                    slotContent = "[*]";  // Equipped
-                                } else {
-                                    slotContent = "[Y]";  // Yellow available
-                                }
-                                break;
-                            }
-                        }
-                    }
+                int color_pair = 0;
+                if (slot_id < SKIN_COUNT) {
+                    WormSkinId skin = (WormSkinId)slot_id;
+                    isUnlocked = kWormSkins[skin].unlockedBy == ACH_COUNT ||
+                                 (currentPlayerData != nullptr && currentPlayerData->hasSkin(skin));
                     if (!isUnlocked) {
                         slotContent = "[?]";  // Locked
+                    } else if (currentPlayerData != nullptr && currentPlayerData->equippedSkin == skin) {
+                        slotContent = "[*]";  // Equipped
+                    } else {
+                        slotContent = std::string("[") + kWormSkins[skin].slotKey + "]";  // Available
                     }
-                } else {
-                    slotContent = "[ ]";  // Empty slot for future achievements
+                    if (skin != SKIN_DEFAULT) color_pair = COLOR_PAIR(kWormSkins[skin].colorPair);
                 }
                 
                 // Draw selection indicator
                 if (isSelected) {
                     mvprintw(slot_y, slot_x, "> ");
-                    // Apply appropriate color for each worm type
-                    if (isUnlocked && has_colors()) {
-                        int color_pair = 0;
-                        if (slot_id == 1) color_pair = COLOR_PAIR(4);      // Pink worm
-                        else if (slot_id == 2) color_pair = COLOR_PAIR(7); // Blue worm
-                        else if (slot_id == 3) color_pair = COLOR_PAIR(8); // Magenta worm
-                        else if (slot_id == 4) color_pair = COLOR_PAIR(9); // Yellow worm
-                        
-                        if (color_pair != 0) {
-                            attron(color_pair);
-                            mvprintw(slot_y, slot_x + 2, "%s", slotContent.c_str());
-                            attroff(color_pair);
-                        } else {
-                            mvprintw(slot_y, slot_x + 2, "%s", slotContent.c_str());
-                        }
-                    } else {
-                        mvprintw(slot_y, slot_x + 2, "%s", slotContent.c_str());
-                    }
-                    mvprintw(slot_y, slot_x + 5, " <");
+                }
+                if (isUnlocked && has_colors() && color_pair != 0) {
+                    attron(color_pair);
+                    mvprintw(slot_y, slot_x + 2, "%s", slotContent.c_str());
+                    attroff(color_pair);
                 } else {
-                    // Apply appropriate color for each worm type
-                    if (isUnlocked && has_colors()) {
-                        int color_pair = 0;
-                        if (slot_id == 1) color_pair = COLOR_PAIR(4);      // Pink worm
-                        else if (slot_id == 2) color_pair = COLOR_PAIR(7); // Blue worm
-                        else if (slot_id == 3) color_pair = COLOR_PAIR(8); // Magenta worm
-                        else if (slot_id == 4) color_pair = COLOR_PAIR(9); // Yellow worm
-                        
-                        if (color_pair != 0) {
-                            attron(color_pair);
-                            mvprintw(slot_y, slot_x + 2, "%s", slotContent.c_str());
-                            attroff(color_pair);
-                        } else {
-                            mvprintw(slot_y, slot_x + 2, "%s", slotContent.c_str());
-                        }
-                    } else {
-                        mvprintw(slot_y, slot_x + 2, "%s", slotContent.c_str());
-                    }
+                    mvprintw(slot_y, slot_x + 2, "%s", slotContent.c_str());
+                }
+                if (isSelected) {
+                    mvprintw(slot_y, slot_x + 5, " <");
                 }
             }
         }
         
         // Show current selection info
-        std::string info = "";
-        if (choice == 0) {
-            info = "Default Worm - Classic orange-red";
-        } else if (choice == 1) {
-            bool pinkUnlocked = false;
-            if (currentPlayerData != nullptr) {
-                for (size_t i = 0; i < currentPlayerData->achievements.size(); i++) {
-                    if (currentPlayerData->achievements[i].id == "pink_worm" && currentPlayerData->achievements[i].unlocked) {
-                        pinkUnlocked = true;
-                        break;
-                    }
-                }
-            }
-            info = pinkUnlocked ? "Pink Worm - Unlocked at 60+ WPM" : "??? - Achieve 60+ WPM to unlock";
-        } else if (choice == 2) {
-            bool blueUnlocked = false;
-            if (currentPlayerData != nullptr) {
-                for (size_t i = 0; i < currentPlayerData->achievements.size(); i++) {
-                    if (currentPlayerData->achievements[i].id == "blue_worm" && currentPlayerData->achievements[i].unlocked) {
-                        blueUnlocked = true;
-                        break;
-                    }
-                }
-            }
-            info = blueUnlocked ? "Blue Worm - Unlocked at 75+ WPM" : "??? - Achieve 75+ WPM to unlock";
-        } else if (choice == 3) {
-            bool magentaUnlocked = false;
-            if (currentPlayerData != nullptr) {
-                for (size_t i = 0; i < currentPlayerData->achievements.size(); i++) {
-                    if (currentPlayerData->achievements[i].id == "magenta_worm" && currentPlayerData->achievements[i].unlocked) {
-                        magentaUnlocked = true;
-                        break;
-                    }
-                }
-            }
-            info = magentaUnlocked ? "Magenta Worm - Unlocked at 80+ WPM" : "??? - Achieve 80+ WPM to unlock";
-        } else if (choice == 4) {
-            bool yellowUnlocked = false;
-            if (currentPlayerData != nullptr) {
-                for (size_t i = 0; i < currentPlayerData->achievements.size(); i++) {
-                    if (currentPlayerData->achievements[i].id == "yellow_worm" && currentPlayerData->achievements[i].unlocked) {
-                        yellowUnlocked = true;
-                        break;
-                    }
-                }
-            }
-            info = yellowUnlocked ? "Golden Worm - Unlocked at 90+ WPM" : "??? - Achieve 90+ WPM to unlock";
-        } else {
-            info = "Empty Slot - Future achievement";
+        std::string info = "Empty Slot - Future achievement";
+        if (choice < SKIN_COUNT) {
+            WormSkinId skin = (WormSkinId)choice;
+            bool unlocked = kWormSkins[skin].unlockedBy == ACH_COUNT ||
+                            (currentPlayerData != nullptr && currentPlayerData->hasSkin(skin));
+            info = unlocked ? kWormSkins[skin].info : kWormSkins[skin].lockedInfo;
         }
         
         mvprintw(box_start_y + box_height - 4, box_start_x + 3, "%-44s", info.c_str());
@@ -990,82 +1090,95 @@ bool showWormCloset() {
             }
         }
         
-        worm_frame++;  // Advance animation
-        
-        refresh();
-        
         // Instructions at bottom of terminal
         std::string instructions = "WASD/Arrows: Navigate | Enter: Equip | Q: Back";
         mvprintw(max_y - 1, (max_x - instructions.length()) / 2, "%s", instructions.c_str());
         
-        // Use timeout for smooth animation
-        timeout(100);  // 100ms timeout
-        ch = getch();
-        timeout(-1);   // Reset to blocking mode
-        
-        if (ch == ERR) {
-            // No key pressed, continue animation
-            continue;
-        }
-        if ((ch == KEY_UP || ch == 'w' || ch == 'W') && choice >= 3) {
-            choice -= 3;
-        } else if ((ch == KEY_DOWN || ch == 's' || ch == 'S') && choice < 6) {
-            choice += 3;
-        } else if ((ch == KEY_LEFT || ch == 'a' || ch == 'A') && choice % 3 > 0) {
-            choice--;
-        } else if ((ch == KEY_RIGHT || ch == 'd' || ch == 'D') && choice % 3 < 2) {
-            choice++;
-        } else if (ch == 10 || ch == 13) { // Enter - equip worm
-            if (currentPlayerData != nullptr) {
-                if (choice == 0) {
-                    // Default worm (always available)
-                    currentPlayerData->equippedWormColor = "default";
+        presentFrame();
+        
+        // Sleep until a key arrives or the next animation tick is due
+        bool tick = false;
+        while (!tick && (ch = readKey()) == ERR) tick = waitForFrame(frameClock);
+        if (tick) worm_frame++;  // Advance animation
+        
+        // Handle this key and every other one already waiting, then repaint once
+        for (; ch != ERR; ch = readKey()) {
+            if ((ch == KEY_UP || ch == 'w' || ch == 'W') && choice >= 3) {
+                choice -= 3;
+            } else if ((ch == KEY_DOWN || ch == 's' || ch == 'S') && choice < 6) {
+                choice += 3;
+            } else if ((ch == KEY_LEFT || ch == 'a' || ch == 'A') && choice % 3 > 0) {
+                choice--;
+            } else if ((ch == KEY_RIGHT || ch == 'd' || ch == 'D') && choice % 3 < 2) {
+                choice++;
+            } else if (ch == 10 || ch == 13) { // Enter - equip worm
+                // Other slots are empty for future achievements
+                if (currentPlayerData != nullptr && choice < SKIN_COUNT && currentPlayerData->hasSkin((WormSkinId)choice)) {
+                    currentPlayerData->equippedSkin = (WormSkinId)choice;
                     savePlayerData(*currentPlayerData);
-                } else if (choice == 1) {
-                    // Pink worm (60+ WPM)
-                    for (size_t i = 0; i < currentPlayerData->achievements.size(); i++) {
-                        if (currentPlayerData->achievements[i].id == "pink_worm" && currentPlayerData->achievements[i].unlocked) {
-                            currentPlayerData->equippedWormColor = "pink";
-                            savePlayerData(*currentPlayerData);
-                            break;
-                        }
-                    }
-                } else if (choice == 2) {
-                    // Blue worm (75+ WPM)
-                    for (size_t i = 0; i < currentPlayerData->achievements.size(); i++) {
-                        if (currentPlayerData->achievements[i].id == "blue_worm" && currentPlayerData->achievements[i].unlocked) {
-                            currentPlayerData->equippedWormColor = "blue";
-                            savePlayerData(*currentPlayerData);
-                            break;
-                        }
-                    }
-                } else if (choice == 3) {
-                    // Magenta worm (80+ WPM)
-                    for (size_t i = 0; i < currentPlayerData->achievements.size(); i++) {
-                        if (currentPlayerData->achievements[i].id == "magenta_worm" && currentPlayerData->achievements[i].unlocked) {
-                            currentPlayerData->equippedWormColor = "magenta";
-                            savePlayerData(*currentPlayerData);
-                            break;
-                        }
-                    }
-                } else if (choice == 4) {
-                    // Yellow worm (90+ WPM)
-                    for (size_t i = 0; i < currentPlayerData->achievements.size(); i++) {
-                        if (currentPlayerData->achievements[i].id == "yellow_worm" && currentPlayerData->achievements[i].unlocked) {
-                            currentPlayerData->equippedWormColor = "yellow";
-                            savePlayerData(*currentPlayerData);
-                            break;
-                        }
-                    }
                 }
-                // Other slots are empty for future achievements
+            } else if (ch == 'q' || ch == 'Q') { // Q
+                return false;
             }
-        } else if (ch == 'q' || ch == 'Q') { // Q
-            return false;
         }
     }
 }
 
+// Screen rows of one key statistics column: the slowest cells with their mean interval and error rate
+static void drawKeyStatColumn(int y, int x, const char* title, const KeyStat* table, int cells,
+                              uint32_t minTimed, size_t rows) {
+    mvprintw(y, x, "%s", title);
+    std::vector<int> slowest = slowestKeyStats(table, cells, minTimed, rows);
+    for (size_t i = 0; i < slowest.size(); i++) {
+        int cell = slowest[i];
+        std::string label = "'";
+        if (cells == kKeyStatChars) {
+            label += (char)(' ' + cell);
+        } else {
+            label += (char)(' ' + cell / kKeyStatChars);
+            label += (char)(' ' + cell % kKeyStatChars);
+        }
+        label += "'";
+        const KeyStat& stat = table[cell];
+        mvprintw(y + 1 + (int)i, x, "%-5s %5.0f ms %5.1f%%", label.c_str(), keyStatMeanMs(stat),
+                 stat.errors * 100.0 / stat.presses);
+    }
+    if (slowest.empty()) mvprintw(y + 1, x, "Not enough data yet");
+}
+
+// Key statistics of the current player: the slowest keys and bigrams, for targeted drills
+void showKeyStats() {
+    int max_x, max_y;
+    static ChromeLayer chrome;
+    
+    while (true) {
+        getmaxyx(stdscr, max_y, max_x);
+        erase();
+        
+        int box_width = 56;
+        int box_height = 20;
+        int box_start_x = (max_x - box_width) / 2;
+        int box_start_y = (max_y - box_height) / 2;
+        composeBoxChrome(chrome, box_start_y, box_start_x, box_height, box_width, "KEY STATS", 2, 3);
+        
+        int y = box_start_y + 5;
+        if (currentPlayerData == nullptr) {
+            mvprintw(y, box_start_x + 3, "No player selected");
+        } else {
+            const KeyStats& stats = currentPlayerData->keyStats;
+            drawKeyStatColumn(y, box_start_x + 3, "SLOWEST KEYS", stats.keys, kKeyStatChars, 5, 10);
+            drawKeyStatColumn(y, box_start_x + 29, "SLOWEST BIGRAMS", stats.bigrams, kKeyStatBigrams, 3, 10);
+        }
+        
+        std::string instruction = "Mean time per key | error rate. Any key: back";
+        mvprintw(box_start_y + box_height - 2, box_start_x + (box_width - (int)instruction.length()) / 2,
+                 "%s", instruction.c_str());
+        presentFrame();
+        
+        if (readKey() != KEY_RESIZE) return;
+    }
+}
+
 // Legacy achievement system functions (kept for compatibility)
 void initializeAchievements() {
     // No longer used - achievements are now player-specific
@@ -1079,135 +1192,166 @@ void loadAchievements() {
     // No longer used - use loadPlayerData instead
 }
 
+// Evaluate every achievement rule against a finished test in one pass.
+// Newly unlocked achievements are saved at once and queued for showPendingAchievements.
 void checkAchievements(double wpm, double accuracy, double time) {
     if (currentPlayerData == nullptr) return;
     
-    bool newAchievement = false;
-    
-    // Check for all worm achievements based on WPM thresholds
-    struct WormThreshold {
-        std::string id;
-        double minWpm;
-        std::string description;
-    };
-    
-    WormThreshold thresholds[] = {
-        {"yellow_worm", 90.0, "Golden worm variant unlocked!"},
-        {"magenta_worm", 80.0, "Magenta worm variant unlocked!"},
-        {"blue_worm", 75.0, "Blue worm variant unlocked!"},
-        {"pink_worm", 60.0, "Pink worm variant unlocked!"}
-    };
-    
-    // Check thresholds from highest to lowest WPM
-    for (int t = 0; t < 4; t++) {
-        if (wpm >= thresholds[t].minWpm) {
-            for (size_t i = 0; i < currentPlayerData->achievements.size(); i++) {
-                if (currentPlayerData->achievements[i].id == thresholds[t].id && !currentPlayerData->achievements[i].unlocked) {
-                    currentPlayerData->achievements[i].unlocked = true;
-                    newAchievement = true;
-                    
-                    // Show achievement notification
-                    int max_x, max_y;
-                    getmaxyx(stdscr, max_y, max_x);
-                    clear();
-                    
-                    std::string congrats = "ACHIEVEMENT UNLOCKED!";
-                    std::string achieveName = currentPlayerData->achievements[i].name;
-                    std::string description = thresholds[t].description;
-                    std::string instruction = "Press any key to continue...";
-                    
-                    mvprintw(max_y/2 - 2, (max_x - congrats.length())/2, "%s", congrats.c_str());
-                    mvprintw(max_y/2, (max_x - achieveName.length())/2, "%s", achieveName.c_str());
-                    mvprintw(max_y/2 + 1, (max_x - description.length())/2, "%s", description.c_str());
-                    mvprintw(max_y/2 + 3, (max_x - instruction.length())/2, "%s", instruction.c_str());
-                    
-                    refresh();
-                    getch();
-                    break; // Only show one achievement notification per session
-                }
-            }
-            if (newAchievement) break; // Exit outer loop if we found an achievement
+    currentPlayerData->streak = (accuracy >= kStreakAccuracy) ? currentPlayerData->streak + 1 : 0;
+    
+    double stats[4];
+    stats[STAT_WPM] = wpm;
+    stats[STAT_ACCURACY] = accuracy;
+    stats[STAT_TIME] = time;
+    stats[STAT_STREAK] = currentPlayerData->streak;
+    
+    for (int i = 0; i < ACH_COUNT; i++) {
+        if (!currentPlayerData->unlocked.test(i) && stats[kAchievements[i].stat] >= kAchievements[i].minimum) {
+            currentPlayerData->unlocked.set(i);
+            pendingAchievements.push_back((AchievementIndex)i);
         }
     }
     
-    if (newAchievement) {
-        savePlayerData(*currentPlayerData);
-    }
+    savePlayerData(*currentPlayerData);  // Unlocks and the streak
 }
 
-// Player save system functions
-std::string getSafeFileName(const std::string& playerName) {
-    std::string safeName = playerName;
-    // Replace any problematic characters with underscores
-    for (size_t i = 0; i < safeName.length(); i++) {
-        if (safeName[i] == ' ' || safeName[i] == '/' || safeName[i] == '\\' || 
-            safeName[i] == ':' || safeName[i] == '*' || safeName[i] == '?' || 
-            safeName[i] == '"' || safeName[i] == '<' || safeName[i] == '>' || 
-            safeName[i] == '|' || safeName[i] == '.') {
-            safeName[i] = '_';
-        }
+// Show the achievements queued by checkAchievements, all on one screen
+void showPendingAchievements() {
+    if (pendingAchievements.empty()) return;
+    
+    int max_x, max_y;
+    getmaxyx(stdscr, max_y, max_x);
+    clear();
+    
+    std::string congrats = pendingAchievements.size() == 1 ? "ACHIEVEMENT UNLOCKED!" : "ACHIEVEMENTS UNLOCKED!";
+    std::string instruction = "Press any key to continue...";
+    int height = (int)pendingAchievements.size() * 3 + 4;
+    int y = max_y/2 - height/2;
+    
+    mvprintw(y, (max_x - congrats.length())/2, "%s", congrats.c_str());
+    y += 2;
+    for (size_t i = 0; i < pendingAchievements.size(); i++) {
+        const AchievementDef& def = kAchievements[pendingAchievements[i]];
+        mvprintw(y, (max_x - strlen(def.name))/2, "%s", def.name);
+        mvprintw(y + 1, (max_x - strlen(def.unlockMessage))/2, "%s", def.unlockMessage);
+        y += 3;
     }
-    return "saves/" + safeName + ".save";
+    mvprintw(y, (max_x - instruction.length())/2, "%s", instruction.c_str());
+    
+    refresh();
+    readKey();
+    pendingAchievements.clear();
+}
+
+// Background load of the score history (--quick). The first test starts while the loader
+// reads the raw log; the records are decoded into the score store on the UI thread when
+// the loader is joined, so everything that needs the scores waits for that first.
+static std::thread scoreStoreLoader;
+static ScoreLogImage scoreLogImage;  // Filled by the loader, taken over at the join
+
+static void loadScoreStore() {
+    readScoreLog(scoreLogImage);
+}
+
+void loadScoreStoreInBackground() {
+    // The loader blocks signals so SIGINT/SIGTERM still reach the UI thread
+    sigset_t all, previous;
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, &previous);
+    scoreStoreLoader = std::thread(loadScoreStore);
+    pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+}
+
+// Block until the score history is loaded. Does nothing once it is (or if it was opened up front).
+void waitForScoreStore() {
+    if (!scoreStoreLoader.joinable()) return;
+    scoreStoreLoader.join();
+    openScoreStore(scoreStore, scoreLogImage);
 }
 
+// Player save system functions - profiles live in the player database
+
 void savePlayerData(const PlayerSaveData& playerData) {
-    // Create saves directory if it doesn't exist
-    system("mkdir -p saves");
+    PlayerRecord& record = upsertPlayer(playerDatabase, playerData.playerName);
+    record.wormColor = kWormSkins[playerData.equippedSkin].colorName;
+    record.currency = playerData.currency;
+    record.achievements = (uint32_t)playerData.unlocked.to_ulong();
+    record.streak = (uint16_t)std::min(playerData.streak, 0xFFFF);
+    record.dirty = true;
+    flushPlayerDatabase(playerDatabase);
+}
+
+PlayerSaveData loadPlayerData(const std::string& playerName) {
+    PlayerSaveData playerData(playerName);
     
-    std::string filename = getSafeFileName(playerData.playerName);
-    std::ofstream file(filename);
-    if (file.is_open()) {
-        // Save format: playerName|equippedWormColor|currency
-        file << playerData.playerName << "|" << playerData.equippedWormColor << "|" << playerData.currency << std::endl;
-        
-        // Save achievements
-        for (size_t i = 0; i < playerData.achievements.size(); i++) {
-            file << playerData.achievements[i].id << "|" << (playerData.achievements[i].unlocked ? 1 : 0) << std::endl;
-        }
-        file.close();
+    const PlayerRecord* record = findPlayer(playerDatabase, playerName);
+    if (record != nullptr) {
+        playerData.equippedSkin = findWormSkin(record->wormColor);
+        playerData.currency = record->currency;
+        playerData.unlocked = std::bitset<ACH_COUNT>(record->achievements);
+        playerData.streak = record->streak;
     }
+    loadKeyStats(keyStatsStore, playerName, playerData.keyStats);
+    
+    return playerData;
 }
 
-PlayerSaveData loadPlayerData(const std::string& playerName) {
-    std::string filename = getSafeFileName(playerName);
+// Read one saves/<name>.save file from before the player database
+static bool loadLegacyPlayerFile(const std::string& filename, PlayerSaveData& playerData) {
     std::ifstream file(filename);
+    if (!file.is_open()) return false;
+    
+    std::string line;
+    
+    // Read player info line: playerName|equippedWormColor|currency
+    if (!std::getline(file, line)) return false;
+    size_t pos1 = line.find('|');
+    size_t pos2 = line.find('|', pos1 + 1);
+    if (pos1 == std::string::npos || pos2 == std::string::npos) return false;
+    playerData = PlayerSaveData(line.substr(0, pos1));
+    playerData.equippedSkin = findWormSkin(line.substr(pos1 + 1, pos2 - pos1 - 1));
+    try {
+        playerData.currency = std::stoi(line.substr(pos2 + 1));
+    } catch (const std::exception&) {
+        playerData.currency = 0;
+    }
     
-    PlayerSaveData playerData(playerName);
-    
-    if (file.is_open()) {
-        std::string line;
-        
-        // Read player info line
-        if (std::getline(file, line)) {
-            size_t pos1 = line.find('|');
-            size_t pos2 = line.find('|', pos1 + 1);
-            
-            if (pos1 != std::string::npos && pos2 != std::string::npos) {
-                playerData.equippedWormColor = line.substr(pos1 + 1, pos2 - pos1 - 1);
-                playerData.currency = std::stoi(line.substr(pos2 + 1));
+    // Read achievements
+    while (std::getline(file, line)) {
+        size_t pos = line.find('|');
+        if (pos != std::string::npos) {
+            AchievementIndex achievement = findAchievement(line.substr(0, pos));
+            if (achievement != ACH_COUNT) {
+                playerData.unlocked.set(achievement, line.substr(pos + 1) == "1");
             }
         }
-        
-        // Read achievements
-        while (std::getline(file, line)) {
-            size_t pos = line.find('|');
-            if (pos != std::string::npos) {
-                std::string id = line.substr(0, pos);
-                bool unlocked = line.substr(pos + 1) == "1";
-                
-                // Find and update the achievement
-                for (size_t i = 0; i < playerData.achievements.size(); i++) {
-                    if (playerData.achievements[i].id == id) {
-                        playerData.achievements[i].unlocked = unlocked;
-                        break;
-                    }
-                }
+    }
+    return true;
+}
+
+// First run with the player database: carry over every saves/*.save file
+void importLegacySaves() {
+    DIR* dir = opendir("saves");
+    if (dir != nullptr) {
+        const std::string extension = ".save";
+        struct dirent* entry;
+        while ((entry = readdir(dir)) != nullptr) {
+            std::string file = entry->d_name;
+            if (file.length() <= extension.length() ||
+                file.compare(file.length() - extension.length(), extension.length(), extension) != 0) {
+                continue;
             }
+            PlayerSaveData playerData("");
+            if (!loadLegacyPlayerFile("saves/" + file, playerData) || playerData.playerName.empty()) continue;
+            
+            PlayerRecord& record = upsertPlayer(playerDatabase, playerData.playerName);
+            record.wormColor = kWormSkins[playerData.equippedSkin].colorName;
+            record.currency = playerData.currency;
+            record.achievements = (uint32_t)playerData.unlocked.to_ulong();
         }
-        file.close();
+        closedir(dir);
     }
-    
-    return playerData;
+    flushPlayerDatabase(playerDatabase);  // Also creates an empty database if there was nothing to import
 }
 
 void setCurrentPlayer(const std::string& playerName) {
@@ -1219,28 +1363,57 @@ void setCurrentPlayer(const std::string& playerName) {
     currentPlayerData = new PlayerSaveData(loadPlayerData(playerName));
 }
 
-std::vector<std::string> getAllSavedPlayerNames() {
-    std::vector<std::string> savedNames;
-    
-    // Use system command to list .save files in saves directory
-    system("mkdir -p saves");  // Ensure directory exists
-    system("ls saves/*.save 2>/dev/null | sed 's|saves/||g' | sed 's|\\.save||g' > /tmp/saved_players.txt");
-    
-    std::ifstream file("/tmp/saved_players.txt");
-    if (file.is_open()) {
-        std::string line;
-        while (std::getline(file, line)) {
-            if (!line.empty()) {
-                savedNames.push_back(line);
-            }
-        }
-        file.close();
+// Last-used settings and player, kept in the session block of the player database.
+// The equipped skin comes back with the player's profile.
+
+// Settings and player of the last test started, if one was saved. Values the menu
+// cannot produce fall back to the defaults.
+void restoreSession(GameSettings& settings, std::string& playerName) {
+    const PlayerSession& session = playerDatabase.session;
+    if (session.player.empty()) return;
+    playerName = session.player;
+    
+    settings.wordCount = 25;
+    static const int kPresetCounts[] = {5, 10, 25, 50};
+    for (int i = 0; i < 4; i++) {
+        if (session.wordCount == kPresetCounts[i]) settings.wordCount = session.wordCount;
+    }
+    settings.isCustomWordCount = (session.flags & SESSION_CUSTOM_WORDS) != 0 &&
+                                 session.customWords >= 1 && session.customWords <= 1000;
+    settings.customWords = settings.isCustomWordCount ? session.customWords : 0;
+    settings.timedSeconds = 0;
+    for (int i = 0; i < kTimedDurationCount; i++) {
+        if (session.timedSeconds == kTimedDurations[i]) settings.timedSeconds = session.timedSeconds;
+    }
+    settings.endless = (session.flags & SESSION_ENDLESS) != 0 && settings.timedSeconds == 0;
+    settings.includePunctuation = (session.flags & SESSION_PUNCTUATION) != 0;
+    settings.includeNumbers = (session.flags & SESSION_NUMBERS) != 0;
+    settings.weakKeys = (session.flags & SESSION_WEAK_KEYS) != 0;
+}
+
+// Remember the settings of the test being started. Written only when something changed.
+void rememberSession(const GameSettings& settings, const std::string& playerName) {
+    PlayerSession next;
+    next.player = playerName;
+    next.wordCount = (uint16_t)settings.wordCount;
+    next.customWords = (uint16_t)settings.customWords;
+    next.timedSeconds = (uint16_t)settings.timedSeconds;
+    next.flags = (settings.isCustomWordCount ? SESSION_CUSTOM_WORDS : 0) |
+                 (settings.includePunctuation ? SESSION_PUNCTUATION : 0) |
+                 (settings.includeNumbers ? SESSION_NUMBERS : 0) |
+                 (settings.endless ? SESSION_ENDLESS : 0) |
+                 (settings.weakKeys ? SESSION_WEAK_KEYS : 0);
+    PlayerSession& session = playerDatabase.session;
+    if (next.player == session.player && next.wordCount == session.wordCount &&
+        next.customWords == session.customWords && next.timedSeconds == session.timedSeconds &&
+        next.flags == session.flags) {
+        return;
     }
     
-    // Clean up temp file
-    system("rm -f /tmp/saved_players.txt");
-    
-    return savedNames;
+    upsertPlayer(playerDatabase, playerName);  // The session points at a profile record
+    next.dirty = true;
+    session = next;
+    flushPlayerDatabase(playerDatabase);
 }
 
 bool confirmDeleteAllPlayers() {
@@ -1250,7 +1423,7 @@ bool confirmDeleteAllPlayers() {
     
     while (true) {
         getmaxyx(stdscr, max_y, max_x);
-        clear();
+        erase();
         
         // Calculate box dimensions
         int box_width = 50;
@@ -1258,35 +1431,10 @@ bool confirmDeleteAllPlayers() {
         int box_start_x = (max_x - box_width) / 2;
         int box_start_y = (max_y - box_height) / 2;
         
-        // Draw retro box border
-        // Top border
-        mvaddch(box_start_y, box_start_x, ACS_ULCORNER);
-        for (int x = box_start_x + 1; x < box_start_x + box_width - 1; x++) {
-            mvaddch(box_start_y, x, ACS_HLINE);
-        }
-        mvaddch(box_start_y, box_start_x + box_width - 1, ACS_URCORNER);
-        
-        // Side borders
-        for (int y = box_start_y + 1; y < box_start_y + box_height - 1; y++) {
-            mvaddch(y, box_start_x, ACS_VLINE);
-            mvaddch(y, box_start_x + box_width - 1, ACS_VLINE);
-        }
-        
-        // Bottom border
-        mvaddch(box_start_y + box_height - 1, box_start_x, ACS_LLCORNER);
-        for (int x = box_start_x + 1; x < box_start_x + box_width - 1; x++) {
-            mvaddch(box_start_y + box_height - 1, x, ACS_HLINE);
-        }
-        mvaddch(box_start_y + box_height - 1, box_start_x + box_width - 1, ACS_LRCORNER);
-        
-        // Title and warning message
+        // Box, title and separator come from the cached chrome
+        static ChromeLayer chrome;
         std::string title = "DELETE ALL SAVED PLAYERS";
-        mvprintw(box_start_y + 2, box_start_x + (box_width - title.length()) / 2, "%s", title.c_str());
-        
-        // Draw separator line
-        for (int x = box_start_x + 2; x < box_start_x + box_width - 2; x++) {
-            mvaddch(box_start_y + 3, x, ACS_HLINE);
-        }
+        composeBoxChrome(chrome, box_start_y, box_start_x, box_height, box_width, title, 2, 3);
         
         std::string warning = "This will delete ALL saved player data!";
         mvprintw(box_start_y + 5, box_start_x + (box_width - warning.length()) / 2, "%s", warning.c_str());
@@ -1317,9 +1465,9 @@ bool confirmDeleteAllPlayers() {
             mvprintw(box_start_y + 9, option_x, "%s", noOption.c_str());
         }
         
-        refresh();
+        presentFrame();
         
-        ch = getch();
+        ch = readKey();
         if ((ch == KEY_UP || ch == 'w' || ch == 'W') && choice > 0) {
             choice--;
         } else if ((ch == KEY_DOWN || ch == 's' || ch == 'S') && choice < 1) {
@@ -1333,9 +1481,10 @@ bool confirmDeleteAllPlayers() {
 }
 
 void deleteAllSavedPlayers() {
-    // More robust deletion - remove the entire saves directory and recreate it
-    system("rm -rf saves");
-    system("mkdir -p saves");
+    // Remove every profile from the player database
+    clearPlayerDatabase(playerDatabase);
+    flushPlayerDatabase(playerDatabase);
+    clearKeyStatsStore(keyStatsStore);
     
     // Also clear current player data since it may no longer exist
     if (currentPlayerData != nullptr) {
@@ -1356,7 +1505,7 @@ void deleteAllSavedPlayers() {
     mvprintw(max_y / 2 + 2, (max_x - instruction.length()) / 2, "%s", instruction.c_str());
     
     refresh();
-    getch();
+    readKey();
 }
 
 // Function to get player name (with selection option)
@@ -1389,113 +1538,23 @@ std::string getPlayerName(const std::vector<PlayerScore>& leaderboard) {
     }
 }
 
-// Function to load leaderboard from file
-std::vector<PlayerScore> loadLeaderboard() {
-    std::vector<PlayerScore> leaderboard;
-    std::ifstream file("leaderboard.txt");
-    
-    if (file.is_open()) {
-        std::string line;
-        while (std::getline(file, line)) {
-            size_t pos1 = line.find('|');
-            size_t pos2 = line.find('|', pos1 + 1);
-            size_t pos3 = line.find('|', pos2 + 1);
-            size_t pos4 = line.find('|', pos3 + 1);
-            size_t pos5 = line.find('|', pos4 + 1);
-            size_t pos6 = line.find('|', pos5 + 1);
-            size_t pos7 = line.find('|', pos6 + 1);
-            
-            if (pos1 != std::string::npos && pos2 != std::string::npos && pos3 != std::string::npos) {
-                std::string name = toUpperCase(line.substr(0, pos1));
-                double wpm = std::stod(line.substr(pos1 + 1, pos2 - pos1 - 1));
-                double accuracy = std::stod(line.substr(pos2 + 1, pos3 - pos2 - 1));
-                
-                std::string date = "";
-                int wordCount = 15;  // Default for backward compatibility
-                bool hasPunctuation = false;  // Default for backward compatibility
-                bool hasNumbers = false;  // Default for backward compatibility
-                double time = 0.0;
-                
-                if (pos4 != std::string::npos) {
-                    time = std::stod(line.substr(pos3 + 1, pos4 - pos3 - 1));
-                } else {
-                    // Very old format with only 3 fields (name|wpm|accuracy)
-                    time = std::stod(line.substr(pos3 + 1));
-                    date = "Unknown";
-                    leaderboard.push_back(PlayerScore(name, wpm, accuracy, time, date, wordCount, hasPunctuation, hasNumbers));
-                    continue;
-                }
-                
-                if (pos7 != std::string::npos) {
-                    // Newest format with all fields
-                    try {
-                        date = line.substr(pos4 + 1, pos5 - pos4 - 1);
-                        wordCount = std::stoi(line.substr(pos5 + 1, pos6 - pos5 - 1));
-                        hasPunctuation = (std::stoi(line.substr(pos6 + 1, pos7 - pos6 - 1)) == 1);
-                        hasNumbers = (std::stoi(line.substr(pos7 + 1)) == 1);
-                    } catch (const std::exception&) {
-                        // Fall back to defaults if parsing fails
-                        date = "Unknown";
-                        wordCount = 15;
-                        hasPunctuation = false;
-                        hasNumbers = false;
-                    }
-                } else if (pos5 != std::string::npos) {
-                    // Format with word count but no punctuation/numbers
-                    try {
-                        date = line.substr(pos4 + 1, pos5 - pos4 - 1);
-                        wordCount = std::stoi(line.substr(pos5 + 1));
-                    } catch (const std::exception&) {
-                        // Fall back to defaults if parsing fails
-                        date = "Unknown";
-                        wordCount = 15;
-                    }
-                } else {
-                    // Old format without word count
-                    date = line.substr(pos4 + 1);
-                    if (date.empty()) {
-                        date = "Unknown";
-                    }
-                }
-                
-                leaderboard.push_back(PlayerScore(name, wpm, accuracy, time, date, wordCount, hasPunctuation, hasNumbers));
-            }
-        }
-        file.close();
-    }
-    
-    return leaderboard;
-}
-
-// Function to save leaderboard to file
-void saveLeaderboard(const std::vector<PlayerScore>& leaderboard) {
-    std::ofstream file("leaderboard.txt");
-    
-    if (file.is_open()) {
-        for (size_t i = 0; i < leaderboard.size(); i++) {
-            file << leaderboard[i].name << "|" << leaderboard[i].wpm << "|" << leaderboard[i].accuracy << "|" << leaderboard[i].time << "|" << leaderboard[i].date << "|" << leaderboard[i].wordCount << "|" << (leaderboard[i].hasPunctuation ? 1 : 0) << "|" << (leaderboard[i].hasNumbers ? 1 : 0) << std::endl;
-        }
-        file.close();
-    }
-}
-
-// Comparison function for sorting scores
-bool compareScores(const PlayerScore& a, const PlayerScore& b) {
-    if (a.wpm != b.wpm) return a.wpm > b.wpm;
-    return a.accuracy > b.accuracy;
+// Test length column of a leaderboard row: "25w" for a word-count test, "30s" for a timed one
+std::string scoreLengthLabel(const PlayerScore& score) {
+    if (score.isTimed()) return std::to_string(score.timedSeconds()) + "s";
+    return std::to_string(score.wordCount()) + "w";
 }
 
-// Function to add score to leaderboard and maintain top 10
-void addToLeaderboard(std::vector<PlayerScore>& leaderboard, const PlayerScore& newScore) {
-    leaderboard.push_back(newScore);
-    
-    // Sort by WPM (descending), then by accuracy (descending) if WPM is same
-    std::sort(leaderboard.begin(), leaderboard.end(), compareScores);
-    
-    // Keep only top 10
-    if (leaderboard.size() > 10) {
-        leaderboard.resize(10);
+// Title of one leaderboard category
+std::string scoreModeName(uint32_t mode) {
+    std::string name;
+    if (mode & kScoreModeTimed) {
+        name = std::to_string((mode & ~kScoreModeTimed) >> 2) + " SECONDS";
+    } else {
+        name = std::to_string(mode >> 2) + " WORDS";
     }
+    if (mode & SCORE_PUNCTUATION) name += " + PUNCTUATION";
+    if (mode & SCORE_NUMBERS) name += " + NUMBERS";
+    return name;
 }
 
 // Function to display leaderboard with clear, change name, and worm closet options
@@ -1505,13 +1564,62 @@ int showLeaderboard(std::vector<PlayerScore>& leaderboard) {
     int ch;
     int worm_frame = 0;         // Animation frame for the worm
     double worm_position = 0.0; // Worm position (0.0 to 1.0)
+    NodelayScope nodelayScope;
+    FrameClock frameClock(kMenuFrameNs);
+    
+    // Category 0 is every mode (the board passed in), then one per mode in the score log.
+    // A category's top 10 is fetched once when it is switched to, not on every redraw.
+    std::vector<uint32_t> modes = scoreModes(scoreStore);
+    size_t category = 0;
+    std::vector<PlayerScore> categoryScores;
+    std::string categoryName = "ALL MODES";
+    static ChromeLayer chrome;  // Title, column headers and instructions
     
     while (true) {
         getmaxyx(stdscr, max_y, max_x);
-        clear();
+        erase();
+        
+        const std::vector<PlayerScore>& board = (category == 0) ? leaderboard : categoryScores;
         
-        std::string title = "=== TOP 10 LEADERBOARD ===";
-        mvprintw(2, (max_x - title.length())/2, "%s", title.c_str());
+        // Make leaderboard responsive to terminal width
+        int display_width = max_x - 4;
+        bool compact = display_width < 95;
+        int compact_width = 50;  // Total width of compact leaderboard
+        int compact_start_x = (max_x - compact_width) / 2;
+        int start_x = (max_x - 105)/2;
+        
+        // Title, column headers and instructions only change with the category or the width
+        std::string title = "=== TOP 10 LEADERBOARD: " + categoryName + " ===";
+        if (prepareChrome(chrome, title + (compact ? "|compact" : "|full"))) {
+            WINDOW* win = chrome.win;
+            mvwprintw(win, 2, (max_x - title.length())/2, "%s", title.c_str());
+            
+            if (compact) {
+                mvwprintw(win, 4, compact_start_x, "# Name         WPM   Acc%%  Time  Words  Mode");
+                mvwprintw(win, 5, compact_start_x, "- ----------- ----  ----  ----  -----  ----");
+            } else {
+                mvwprintw(win, 4, start_x, "Rank  Name            WPM    Accuracy  Time   Words  Mode  Date & Time");
+                mvwprintw(win, 5, start_x, "----  --------------  -----  --------  ----   -----  ----  ----------------");
+            }
+            
+            // Center all instruction strings properly
+            std::string clearStr = "Press 'C' to clear leaderboard";
+            std::string nameStr = "Press 'N' to change player name";
+            std::string wormStr = "Press 'W' to open worm closet";
+            std::string continueStr = "Press any other key to continue";
+            std::string categoryStr = "Left/Right: switch word count and mode";
+            
+            mvwprintw(win, max_y - 9, (max_x - categoryStr.length())/2, "%s", categoryStr.c_str());
+            mvwprintw(win, max_y - 8, (max_x - clearStr.length())/2, "%s", clearStr.c_str());
+            mvwprintw(win, max_y - 7, (max_x - nameStr.length())/2, "%s", nameStr.c_str());
+            mvwprintw(win, max_y - 6, (max_x - wormStr.length())/2, "%s", wormStr.c_str());
+            mvwprintw(win, max_y - 5, (max_x - continueStr.length())/2, "%s", continueStr.c_str());
+            
+            // Add worm closet instruction
+            std::string wormInstruction = "Press W for Worm Closet";
+            mvwprintw(win, max_y - 3, (max_x - wormInstruction.length()) / 2, "%s", wormInstruction.c_str());
+        }
+        stampChrome(chrome);
         
         // Draw animated worm under the title
         int worm_y = 3;
@@ -1519,89 +1627,73 @@ int showLeaderboard(std::vector<PlayerScore>& leaderboard) {
         int worm_width = max_x - 4;
         drawBouncyWorm(worm_y, worm_start_x, worm_width, worm_position, worm_frame);
         
-        // Update worm animation
-        worm_position += 0.02;  // Move worm forward
-        if (worm_position >= 1.0) worm_position = 0.0;  // Loop back
-        worm_frame++;
-        
-        // Make leaderboard responsive to terminal width
-        int display_width = max_x - 4;
-        if (display_width < 95) {
+        if (compact) {
             // Compact format for narrow terminals - center the content
-            int compact_width = 50;  // Total width of compact leaderboard
-            int compact_start_x = (max_x - compact_width) / 2;
-            
-            mvprintw(4, compact_start_x, "# Name         WPM   Acc%%  Time  Words  Mode");
-            mvprintw(5, compact_start_x, "- ----------- ----  ----  ----  -----  ----");
-            
-            for (size_t i = 0; i < leaderboard.size() && i < 10; i++) {
-                std::string nameDisplay = toUpperCase(leaderboard[i].name);
+            for (size_t i = 0; i < board.size() && i < 10; i++) {
+                std::string nameDisplay = toUpperCase(board[i].name());
                 if (nameDisplay.length() > 11) {
                     nameDisplay = nameDisplay.substr(0, 8) + "...";
                 }
                 
                 // Create mode indicator (P for punctuation, N for numbers)
                 std::string mode = "";
-                if (leaderboard[i].hasPunctuation) mode += "P";
-                if (leaderboard[i].hasNumbers) mode += "N";
+                if (board[i].hasPunctuation()) mode += "P";
+                if (board[i].hasNumbers()) mode += "N";
                 if (mode.empty()) mode = "-";
                 
-                mvprintw(6 + i, compact_start_x, "%2zu %-11s %4.0f  %3.0f%%  %3.0fs  %3dw   %-2s", 
-                         i + 1, nameDisplay.c_str(), leaderboard[i].wpm, 
-                         leaderboard[i].accuracy, leaderboard[i].time, leaderboard[i].wordCount, mode.c_str());
+                mvprintw(6 + i, compact_start_x, "%2zu %-11s %4.0f  %3.0f%%  %3.0fs  %4s   %-2s", 
+                         i + 1, nameDisplay.c_str(), board[i].wpm, 
+                         board[i].accuracy, board[i].time, scoreLengthLabel(board[i]).c_str(), mode.c_str());
             }
         } else {
             // Full format for wider terminals
-            int start_x = (max_x - 105)/2;
-            mvprintw(4, start_x, "Rank  Name            WPM    Accuracy  Time   Words  Mode  Date & Time");
-            mvprintw(5, start_x, "----  --------------  -----  --------  ----   -----  ----  ----------------");
-            
-            for (size_t i = 0; i < leaderboard.size() && i < 10; i++) {
-                std::string nameDisplay = toUpperCase(leaderboard[i].name);
+            for (size_t i = 0; i < board.size() && i < 10; i++) {
+                std::string nameDisplay = toUpperCase(board[i].name());
                 if (nameDisplay.length() > 14) {
                     nameDisplay = nameDisplay.substr(0, 11) + "...";
                 }
                 
                 // Create mode indicator (P for punctuation, N for numbers)
                 std::string mode = "";
-                if (leaderboard[i].hasPunctuation) mode += "P";
-                if (leaderboard[i].hasNumbers) mode += "N";
+                if (board[i].hasPunctuation()) mode += "P";
+                if (board[i].hasNumbers()) mode += "N";
                 if (mode.empty()) mode = "-";
                 
-                mvprintw(6 + i, start_x, "%4zu  %-14s  %5.1f  %7.1f%%  %4.0fs  %3dw   %-4s  %s", 
-                         i + 1, nameDisplay.c_str(), leaderboard[i].wpm, 
-                         leaderboard[i].accuracy, leaderboard[i].time, leaderboard[i].wordCount, mode.c_str(), leaderboard[i].date.c_str());
+                mvprintw(6 + i, start_x, "%4zu  %-14s  %5.1f  %7.1f%%  %4.0fs  %4s   %-4s  %s", 
+                         i + 1, nameDisplay.c_str(), board[i].wpm, 
+                         board[i].accuracy, board[i].time, scoreLengthLabel(board[i]).c_str(), mode.c_str(),
+                         formatScoreDate(board[i].timestampMs).c_str());
             }
         }
         
-        if (leaderboard.empty()) {
+        if (board.empty()) {
             mvprintw(8, (max_x - 25)/2, "No scores recorded yet!");
         }
         
-        // Center all instruction strings properly
-        std::string clearStr = "Press 'C' to clear leaderboard";
-        std::string nameStr = "Press 'N' to change player name";
-        std::string wormStr = "Press 'W' to open worm closet";
-        std::string continueStr = "Press any other key to continue";
-        
-        mvprintw(max_y - 8, (max_x - clearStr.length())/2, "%s", clearStr.c_str());
-        mvprintw(max_y - 7, (max_x - nameStr.length())/2, "%s", nameStr.c_str());
-        mvprintw(max_y - 6, (max_x - wormStr.length())/2, "%s", wormStr.c_str());
-        mvprintw(max_y - 5, (max_x - continueStr.length())/2, "%s", continueStr.c_str());
-        
-        // Add worm closet instruction
-        std::string wormInstruction = "Press W for Worm Closet";
-        mvprintw(max_y - 3, (max_x - wormInstruction.length()) / 2, "%s", wormInstruction.c_str());
-        refresh();
+        presentFrame();
         
-        // Use timeout to allow animation to continue
-        timeout(100);  // 100ms timeout for getch
-        ch = getch();
-        timeout(-1);   // Reset to blocking mode
+        // Sleep until a key arrives or the next animation tick is due
+        bool tick = false;
+        while (!tick && (ch = readKey()) == ERR) tick = waitForFrame(frameClock);
         
         if (ch == ERR) {
-            // No key pressed, continue animation loop
+            // Update worm animation
+            worm_position += 0.02;  // Move worm forward
+            if (worm_position >= 1.0) worm_position = 0.0;  // Loop back
+            worm_frame++;
             continue;
+        } else if (ch == KEY_LEFT || ch == KEY_RIGHT) {
+            // Switch category
+            size_t count = modes.size() + 1;
+            category = (ch == KEY_RIGHT) ? (category + 1) % count : (category + count - 1) % count;
+            if (category == 0) {
+                categoryName = "ALL MODES";
+                categoryScores.clear();
+            } else {
+                uint32_t mode = modes[category - 1];
+                categoryScores = topScoresForMode(scoreStore, mode, 10);
+                categoryName = scoreModeName(mode);
+            }
         } else if (ch == 'c' || ch == 'C') {
             // Confirm clear action
             clear();
@@ -1610,10 +1702,12 @@ int showLeaderboard(std::vector<PlayerScore>& leaderboard) {
             mvprintw(max_y/2 + 1, (max_x - 30)/2, "Press any other key to cancel");
             refresh();
             
-            int confirm = getch();
+            nodelay(stdscr, FALSE);  // Wait for the answer
+            int confirm = readKey();
+            nodelay(stdscr, TRUE);
             if (confirm == 'y' || confirm == 'Y') {
                 leaderboard.clear();
-                saveLeaderboard(leaderboard);
+                clearScoreStore(scoreStore);
                 return 1; // Leaderboard was cleared
             }
             // If not confirmed, continue the loop to show leaderboard again
@@ -1633,10 +1727,11 @@ bool showUnifiedMenu(GameSettings& settings, const std::vector<PlayerScore>& lea
     int currentSection = 0;  // 0=Player, 1=Words, 2=Options, 3=Start
     int sectionChoice[] = {0, 0, 0, 0};  // Choice within each section
     int ch;
+    static ChromeLayer chrome;  // Section boxes, titles and instructions
     
     // Available word counts
     std::vector<int> wordCounts = {5, 10, 25, 50};
-    std::vector<std::string> wordOptions = {"5", "10", "25", "50", "Custom"};
+    std::vector<std::string> wordOptions = {"5", "10", "25", "50", "Custom", "Timed", "Endless"};
     
     // Initialize settings if needed
     if (settings.wordCount == 0) {
@@ -1645,16 +1740,19 @@ bool showUnifiedMenu(GameSettings& settings, const std::vector<PlayerScore>& lea
         settings.includeNumbers = false;
         settings.isCustomWordCount = false;
         settings.customWords = 0;
+        settings.timedSeconds = 0;
+        settings.endless = false;
+        settings.weakKeys = false;
     }
     
     while (true) {
         getmaxyx(stdscr, max_y, max_x);
-        clear();
+        erase();
         
         // Calculate layout for 4 boxes side by side
         int total_width = max_x - 4;  // Leave some margin
         int box_width = total_width / 4;
-        int box_height = 12;
+        int box_height = 14;
         int start_y = (max_y - box_height) / 2;
         int start_x = 2;
         
@@ -1664,51 +1762,39 @@ bool showUnifiedMenu(GameSettings& settings, const std::vector<PlayerScore>& lea
             start_x = (max_x - (box_width * 4)) / 2;
         }
         
-        // Draw boxes for each section
+        // Boxes, section titles and instructions only change with the active section or the size
+        std::string chromeKey = std::to_string(start_y) + "," + std::to_string(start_x) + "," +
+                                std::to_string(box_width) + "," + std::to_string(currentSection);
+        if (prepareChrome(chrome, chromeKey)) {
+            static const char* sectionTitles[4] = { "PLAYER", "WORDS", "OPTIONS", "START" };
+            for (int section = 0; section < 4; section++) {
+                int box_x = start_x + (section * box_width);
+                
+                // Draw box border (highlight active section)
+                if (currentSection == section) {
+                    wattron(chrome.win, COLOR_PAIR(1));  // Yellow highlight for active section
+                }
+                drawRetroBox(chrome.win, start_y, box_x, box_height, box_width);
+                if (currentSection == section) {
+                    wattroff(chrome.win, COLOR_PAIR(1));
+                }
+                drawBoxHeader(chrome.win, start_y, box_x, box_width, sectionTitles[section], 2, 3);
+            }
+            
+            // Instructions at bottom
+            mvwprintw(chrome.win, max_y - 2, 2, "A/D or Left/Right: Navigate sections");
+            mvwprintw(chrome.win, max_y - 1, 2, "W/S or Up/Down: Navigate within section | Space/Enter: Select/Toggle | Q: Quit");
+        }
+        stampChrome(chrome);
+        
+        // Draw the contents of each section
         for (int section = 0; section < 4; section++) {
             int box_x = start_x + (section * box_width);
             bool isActive = (currentSection == section);
             
-            // Draw box border (highlight active section)
-            if (isActive) {
-                attron(COLOR_PAIR(1));  // Yellow highlight for active section
-            }
-            
-            // Top border
-            mvaddch(start_y, box_x, ACS_ULCORNER);
-            for (int x = 1; x < box_width - 1; x++) {
-                mvaddch(start_y, box_x + x, ACS_HLINE);
-            }
-            mvaddch(start_y, box_x + box_width - 1, ACS_URCORNER);
-            
-            // Side borders
-            for (int y = 1; y < box_height - 1; y++) {
-                mvaddch(start_y + y, box_x, ACS_VLINE);
-                mvaddch(start_y + y, box_x + box_width - 1, ACS_VLINE);
-            }
-            
-            // Bottom border
-            mvaddch(start_y + box_height - 1, box_x, ACS_LLCORNER);
-            for (int x = 1; x < box_width - 1; x++) {
-                mvaddch(start_y + box_height - 1, box_x + x, ACS_HLINE);
-            }
-            mvaddch(start_y + box_height - 1, box_x + box_width - 1, ACS_LRCORNER);
-            
-            if (isActive) {
-                attroff(COLOR_PAIR(1));
-            }
-            
             // Draw section content
             switch (section) {
                 case 0: {  // Player section
-                    std::string title = "PLAYER";
-                    mvprintw(start_y + 2, box_x + (box_width - title.length()) / 2, "%s", title.c_str());
-                    
-                    // Draw separator
-                    for (int x = 2; x < box_width - 2; x++) {
-                        mvaddch(start_y + 3, box_x + x, ACS_HLINE);
-                    }
-                    
                     // Show current player name (truncated if too long)
                     std::string displayName = settings.playerName;
                     if (displayName.length() > box_width - 6) {
@@ -1730,40 +1816,40 @@ bool showUnifiedMenu(GameSettings& settings, const std::vector<PlayerScore>& lea
                         mvprintw(start_y + 8, box_x + 1, ">");
                     }
                     
-                    mvprintw(start_y + 9, box_x + 2, "Leaderboard");
+                    mvprintw(start_y + 9, box_x + 2, "Key Stats");
                     if (isActive && sectionChoice[0] == 3) {
                         mvprintw(start_y + 9, box_x + 1, ">");
                     }
+                    
+                    mvprintw(start_y + 10, box_x + 2, "Leaderboard");
+                    if (isActive && sectionChoice[0] == 4) {
+                        mvprintw(start_y + 10, box_x + 1, ">");
+                    }
                     break;
                 }
                 
                 case 1: {  // Word Count section
-                    std::string title = "WORDS";
-                    mvprintw(start_y + 2, box_x + (box_width - title.length()) / 2, "%s", title.c_str());
-                    
-                    // Draw separator
-                    for (int x = 2; x < box_width - 2; x++) {
-                        mvaddch(start_y + 3, box_x + x, ACS_HLINE);
-                    }
-                    
-                    // Show word count options
-                    for (int i = 0; i < 5; i++) {  // 4 preset + custom
+                    // Show word count options, then the streamed modes
+                    bool wordTest = settings.timedSeconds == 0 && !settings.endless;
+                    for (int i = 0; i < 7; i++) {  // 4 preset + custom + timed + endless
                         bool isSelected = false;
-                        if (i < 4 && !settings.isCustomWordCount && settings.wordCount == wordCounts[i]) {
+                        if (i < 4 && wordTest && !settings.isCustomWordCount && settings.wordCount == wordCounts[i]) {
+                            isSelected = true;
+                        } else if (i == 4 && wordTest && settings.isCustomWordCount) {
                             isSelected = true;
-                        } else if (i == 4 && settings.isCustomWordCount) {
+                        } else if (i == 5 && settings.timedSeconds > 0) {
+                            isSelected = true;
+                        } else if (i == 6 && settings.endless) {
                             isSelected = true;
                         }
                         
                         std::string option;
-                        if (i < 4) {
-                            option = std::string(isSelected ? "[X]" : "[ ]") + " " + wordOptions[i];
+                        if (i == 4 && isSelected) {
+                            option = "[X] Custom (" + std::to_string(settings.customWords) + ")";
+                        } else if (i == 5 && isSelected) {
+                            option = "[X] Timed (" + std::to_string(settings.timedSeconds) + "s)";
                         } else {
-                            if (settings.isCustomWordCount) {
-                                option = "[X] Custom (" + std::to_string(settings.customWords) + ")";
-                            } else {
-                                option = "[ ] Custom";
-                            }
+                            option = std::string(isSelected ? "[X]" : "[ ]") + " " + wordOptions[i];
                         }
                         
                         if (option.length() > box_width - 4) {
@@ -1780,14 +1866,6 @@ bool showUnifiedMenu(GameSettings& settings, const std::vector<PlayerScore>& lea
                 }
                 
                 case 2: {  // Text Options section
-                    std::string title = "OPTIONS";
-                    mvprintw(start_y + 2, box_x + (box_width - title.length()) / 2, "%s", title.c_str());
-                    
-                    // Draw separator
-                    for (int x = 2; x < box_width - 2; x++) {
-                        mvaddch(start_y + 3, box_x + x, ACS_HLINE);
-                    }
-                    
                     // Show options with checkboxes
                     std::string punctOption = std::string(settings.includePunctuation ? "[X]" : "[ ]") + " Punctuation";
                     std::string numbersOption = std::string(settings.includeNumbers ? "[X]" : "[ ]") + " Numbers";
@@ -1801,18 +1879,16 @@ bool showUnifiedMenu(GameSettings& settings, const std::vector<PlayerScore>& lea
                     if (isActive && sectionChoice[2] == 1) {
                         mvprintw(start_y + 6, box_x + 1, ">");
                     }
+                    
+                    std::string weakOption = std::string(settings.weakKeys ? "[X]" : "[ ]") + " Weak Keys";
+                    mvprintw(start_y + 7, box_x + 2, "%s", weakOption.c_str());
+                    if (isActive && sectionChoice[2] == 2) {
+                        mvprintw(start_y + 7, box_x + 1, ">");
+                    }
                     break;
                 }
                 
                 case 3: {  // Start section
-                    std::string title = "START";
-                    mvprintw(start_y + 2, box_x + (box_width - title.length()) / 2, "%s", title.c_str());
-                    
-                    // Draw separator
-                    for (int x = 2; x < box_width - 2; x++) {
-                        mvaddch(start_y + 3, box_x + x, ACS_HLINE);
-                    }
-                    
                     if (isActive) {
                         attron(COLOR_PAIR(1));  // Highlight start button
                     }
@@ -1826,13 +1902,9 @@ bool showUnifiedMenu(GameSettings& settings, const std::vector<PlayerScore>& lea
             }
         }
         
-        refresh();
-        
-        // Instructions at bottom
-        mvprintw(max_y - 2, 2, "A/D or Left/Right: Navigate sections");
-        mvprintw(max_y - 1, 2, "W/S or Up/Down: Navigate within section | Space/Enter: Select/Toggle | Q: Quit");
+        presentFrame();
         
-        ch = getch();
+        ch = readKey();
         
         // Handle navigation between sections
         if ((ch == KEY_LEFT || ch == 'a' || ch == 'A') && currentSection > 0) {
@@ -1847,9 +1919,9 @@ bool showUnifiedMenu(GameSettings& settings, const std::vector<PlayerScore>& lea
             else if (currentSection == 1 && sectionChoice[1] > 0) sectionChoice[1]--;  
             else if (currentSection == 2 && sectionChoice[2] > 0) sectionChoice[2]--;
         } else if (ch == KEY_DOWN || ch == 's' || ch == 'S') {
-            if (currentSection == 0 && sectionChoice[0] < 3) sectionChoice[0]++;  // Now 4 options (0-3)
-            else if (currentSection == 1 && sectionChoice[1] < 4) sectionChoice[1]++;
-            else if (currentSection == 2 && sectionChoice[2] < 1) sectionChoice[2]++;
+            if (currentSection == 0 && sectionChoice[0] < 4) sectionChoice[0]++;  // Now 5 options (0-4)
+            else if (currentSection == 1 && sectionChoice[1] < 6) sectionChoice[1]++;
+            else if (currentSection == 2 && sectionChoice[2] < 2) sectionChoice[2]++;
         }
         
         // Handle selections/toggles
@@ -1864,28 +1936,47 @@ bool showUnifiedMenu(GameSettings& settings, const std::vector<PlayerScore>& lea
                     }
                 } else if (sectionChoice[0] == 2) {  // Worm Closet
                     showWormCloset();
-                } else if (sectionChoice[0] == 3) {  // Leaderboard
-                    // Reload leaderboard from file to get latest scores
-                    std::vector<PlayerScore> currentLeaderboard = loadLeaderboard();
+                } else if (sectionChoice[0] == 3) {  // Key Stats
+                    showKeyStats();
+                } else if (sectionChoice[0] == 4) {  // Leaderboard
+                    // Take the latest scores from the score log
+                    std::vector<PlayerScore> currentLeaderboard = topScores(scoreStore, 10);
                     showLeaderboard(currentLeaderboard);
                 }
             } else if (currentSection == 1) {  // Word Count section
                 if (sectionChoice[1] < 4) {
                     settings.wordCount = wordCounts[sectionChoice[1]];
                     settings.isCustomWordCount = false;
-                } else {  // Custom option
+                    settings.timedSeconds = 0;
+                    settings.endless = false;
+                } else if (sectionChoice[1] == 4) {  // Custom option
                     int customWords = getCustomWordCount();
                     if (customWords > 0) {
                         settings.isCustomWordCount = true;
                         settings.customWords = customWords;
                         settings.wordCount = customWords;
+                        settings.timedSeconds = 0;
+                        settings.endless = false;
+                    }
+                } else if (sectionChoice[1] == 5) {  // Timed - selecting it again tries the next length
+                    int next = 0;
+                    for (int i = 0; i < kTimedDurationCount; i++) {
+                        if (kTimedDurations[i] == settings.timedSeconds) next = (i + 1) % kTimedDurationCount;
                     }
+                    if (settings.timedSeconds == 0) next = 1;  // 30 seconds
+                    settings.timedSeconds = kTimedDurations[next];
+                    settings.endless = false;
+                } else {  // Endless
+                    settings.timedSeconds = 0;
+                    settings.endless = true;
                 }
             } else if (currentSection == 2) {  // Options section
                 if (sectionChoice[2] == 0) {
                     settings.includePunctuation = !settings.includePunctuation;
                 } else if (sectionChoice[2] == 1) {
                     settings.includeNumbers = !settings.includeNumbers;
+                } else if (sectionChoice[2] == 2) {
+                    settings.weakKeys = !settings.weakKeys;
                 }
             } else if (currentSection == 3) {  // Start section
                 return true;  // Start the test
@@ -1899,146 +1990,158 @@ bool showUnifiedMenu(GameSettings& settings, const std::vector<PlayerScore>& lea
     }
 }
 
-// Function to show animated intro title
-void showAnimatedIntro() {
-    int max_x, max_y;
-    getmaxyx(stdscr, max_y, max_x);
+// Precomputed worm animation. Every glyph a worm shows repeats over a short cycle, so each
+// segment of each frame is stored as a ready chtype (glyph plus color) and drawing is a
+// lookup per cell. Built by initColors() once the color pairs exist.
+static const int kBouncyWormLength = 9;       // Head and 8 body segments
+static const int kBouncyWormCycle = 12;       // Head repeats every 4 frames, the body every 2 and 3
+static const int kDecorativeWormLength = 7;   // Head and 6 body segments
+static const int kDecorativeWormCycle = 4;
+static const int kWormColorPairs = 10;        // Pairs 0-9 set up by initColors()
+
+static chtype bouncyWormFrames[SKIN_COUNT][kBouncyWormCycle][kBouncyWormLength];
+static chtype decorativeWormFrames[kWormColorPairs][kDecorativeWormCycle][kDecorativeWormLength];
+
+// Intro timeline, one entry per kIntroFrameNs tick: the title appears word by word while
+// the worm crosses below it (a worm frame every 3 ticks), the finished title holds for
+// half a second, then the prompt types itself out a letter per tick
+static const int64_t kIntroFrameNs = 50000000;
+static const int kIntroWormFrames = 20;
+static const int kIntroTicksPerWormFrame = 3;
+static const int kIntroHoldTicks = 10;
+static const char* const kIntroTitleWords[] = { "W4RMUP", "W0RM'S", "T3RMINAL", "TYP3R" };
+static const int kIntroTitleWordCount = 4;
+static const char* const kIntroPrompt = "Press any key to continue...";
+
+struct IntroFrame {
+    uint8_t words;           // Title words shown
+    int8_t wormFrame;        // Worm animation frame, -1 once the worm is gone
+    uint8_t promptLetters;   // Letters of the prompt shown
+};
+
+static std::vector<IntroFrame> introFrames;
+
+// Fill the worm and intro frame tables
+void buildAnimationFrames() {
+    for (int skin = 0; skin < SKIN_COUNT; skin++) {
+        chtype attr = has_colors() ? COLOR_PAIR(kWormSkins[skin].colorPair) : 0;
+        for (int frame = 0; frame < kBouncyWormCycle; frame++) {
+            chtype* cells = bouncyWormFrames[skin][frame];
+            cells[0] = (chtype)(unsigned char)kWormSkins[skin].headFrames[frame % 4] | attr;
+            for (int i = 1; i < kBouncyWormLength; i++) {
+                char body_char;
+                if (i == 1) {
+                    body_char = 'o';  // Close to head
+                } else if (i <= 3) {
+                    body_char = '.';  // Medium distance
+                } else if (i <= 5) {
+                    body_char = (frame % 2 == 0) ? '.' : ':';  // Animated middle
+                } else {
+                    body_char = (frame % 3 == 0) ? ':' : '.';  // Tail with slight animation
+                }
+                cells[i] = (chtype)body_char | attr;
+            }
+        }
+    }
     
-    // Split title into words
-    std::vector<std::string> title_words;
-    title_words.push_back("W4RMUP");
-    title_words.push_back("W0RM'S");
-    title_words.push_back("T3RMINAL");
-    title_words.push_back("TYP3R");
+    static const char kDecorativeHeads[] = { 'O', 'o', 'O', '0' };
+    for (int pair = 0; pair < kWormColorPairs; pair++) {
+        chtype attr = has_colors() ? COLOR_PAIR(pair) : 0;
+        for (int frame = 0; frame < kDecorativeWormCycle; frame++) {
+            chtype* cells = decorativeWormFrames[pair][frame];
+            cells[0] = (chtype)kDecorativeHeads[frame] | attr;
+            for (int i = 1; i < kDecorativeWormLength; i++) {
+                char body_char = (i == 1) ? 'o' : (i <= 3) ? '.' : (frame % 2 == 0) ? ':' : '.';
+                cells[i] = (chtype)body_char | attr;
+            }
+        }
+    }
     
-    // Calculate full title length for centering
-    std::string full_title = "W4RMUP W0RM'S T3RMINAL TYP3R";
-    int title_start_x = (max_x - full_title.length()) / 2;
+    introFrames.clear();
+    int promptLength = (int)strlen(kIntroPrompt);
+    for (int frame = 0; frame < kIntroWormFrames; frame++) {
+        IntroFrame f;
+        f.words = (uint8_t)std::min(kIntroTitleWordCount, frame * kIntroTitleWordCount / (kIntroWormFrames - 1) + 1);
+        f.wormFrame = (int8_t)frame;
+        f.promptLetters = 0;
+        introFrames.insert(introFrames.end(), kIntroTicksPerWormFrame, f);
+    }
+    IntroFrame f;
+    f.words = kIntroTitleWordCount;
+    f.wormFrame = -1;
+    f.promptLetters = 0;
+    introFrames.insert(introFrames.end(), kIntroHoldTicks, f);
+    for (int letters = 1; letters <= promptLength; letters++) {
+        f.promptLetters = (uint8_t)letters;
+        introFrames.push_back(f);
+    }
+}
+
+// Draw one step of the intro timeline
+static void drawIntroFrame(const IntroFrame& f) {
+    int max_x, max_y;
+    getmaxyx(stdscr, max_y, max_x);
+    int title_start_x = (max_x - (int)strlen("W4RMUP W0RM'S T3RMINAL TYP3R")) / 2;
     int title_y = max_y / 2;
+    erase();
     
-    clear();
+    if (f.wormFrame >= 0) {
+        std::string skip_msg = "Press any key to skip the intro";
+        mvprintw(1, (max_x - (int)skip_msg.length()) / 2, "%s", skip_msg.c_str());
+    }
     
-    // Show skip instruction
-    std::string skip_msg = "Press 's' to skip intro";
-    mvprintw(1, (max_x - skip_msg.length()) / 2, "%s", skip_msg.c_str());
-    refresh();
+    // Title words shown so far
+    int temp_x = title_start_x;
+    int cursor_x = temp_x;  // End of the last word drawn
+    if (has_colors()) attron(COLOR_PAIR(5));  // Orange-red title
+    for (int j = 0; j < f.words; j++) {
+        mvprintw(title_y, temp_x, "%s", kIntroTitleWords[j]);
+        cursor_x = temp_x + (int)strlen(kIntroTitleWords[j]);
+        temp_x = cursor_x + 1;
+    }
+    if (has_colors()) attroff(COLOR_PAIR(5));
     
-    // Set non-blocking input to check for skip key
-    nodelay(stdscr, TRUE);
-    
-    // Worm animation variables
-    double worm_position = 0.0;
-    int worm_frame = 0;
-    int worm_y = title_y + 2;  // Position worm below the title
-    int worm_start_x = 2;
-    int worm_width = max_x - 4;
-    
-    // Display words one by one with animation and smooth worm movement
-    int total_frames = 20;  // 20 frames for slower, smoother worm movement
-    bool skip_intro = false;
-    
-    for (int frame = 0; frame < total_frames && !skip_intro; frame++) {
-        // Calculate smooth worm movement
-        worm_position = (double)frame / (total_frames - 1);  // Move from 0.0 to 1.0
-        
-        // Determine which words should be visible based on frame progress
-        double word_progress = (double)frame / (total_frames - 1) * title_words.size();
-        int words_to_show = (int)word_progress + 1;  // At least 1 word, up to all 4
-        if (words_to_show > (int)title_words.size()) words_to_show = title_words.size();
-        
-        // Clear and redraw everything for each frame
-        clear();
-        
-        // Redraw skip instruction
-        mvprintw(1, (max_x - skip_msg.length()) / 2, "%s", skip_msg.c_str());
-        
-        // Draw words up to current progress
-        int temp_x = title_start_x;
-        int cursor_x = temp_x; // Track cursor position
-        for (int j = 0; j < words_to_show; j++) {
-            if (has_colors()) {
-                attron(COLOR_PAIR(5));  // Use orange-red color for title
-            }
-            
-            mvprintw(title_y, temp_x, "%s", title_words[j].c_str());
-            
-            if (has_colors()) {
-                attroff(COLOR_PAIR(5));
-            }
-            
-            cursor_x = temp_x + title_words[j].length(); // Update cursor position
-            temp_x += title_words[j].length() + 1;  // Move position for next word (+ space)
-        }
-        
-        // Draw the animated worm first
-        drawBouncyWorm(worm_y, worm_start_x, worm_width, worm_position, worm_frame);
-        
-        // Position cursor at end of last word drawn during animation (after worm drawing)
+    if (f.promptLetters > 0) {
+        int prompt_x = (max_x - (int)strlen(kIntroPrompt)) / 2;
+        mvaddnstr(title_y + 3, prompt_x, kIntroPrompt, f.promptLetters);
+    }
+    
+    if (f.wormFrame >= 0) {
+        // Worm below the title, cursor at the end of the last word
+        drawBouncyWorm(title_y + 2, 2, max_x - 4, (double)f.wormFrame / (kIntroWormFrames - 1), f.wormFrame);
         curs_set(1);
         move(title_y, cursor_x);
-        
-        refresh();
-        
-        // Check for skip key press
-        int ch = getch();
-        if (ch == 's' || ch == 'S') {
-            skip_intro = true;
-            break;
-        }
-        
-        usleep(150000);  // 150ms delay between frames (total: 3 seconds for 20 frames)
-        worm_frame++;  // Advance worm animation frame by frame
+    } else {
+        curs_set(0);
     }
-    
-    // Restore blocking input
-    nodelay(stdscr, FALSE);
-    
-    // Clear the screen and redraw only the title without the worm
-    clear();
-    int temp_x = title_start_x;
-    for (size_t j = 0; j < title_words.size(); j++) {
-        if (has_colors()) {
-            attron(COLOR_PAIR(5));  // Use orange-red color for title
+    presentFrame();
+}
+
+// Animated title screen, driven by the frame clock. Any key during the animation skips
+// straight past the intro; once it has played out, any key continues.
+void showAnimatedIntro() {
+    NodelayScope nodelayScope;
+    FrameClock frameClock(kIntroFrameNs);
+    size_t step = 0;
+    drawIntroFrame(introFrames[step]);
+    while (step + 1 < introFrames.size()) {
+        int ch = ERR;
+        bool tick = false;
+        while (!tick && (ch = readKey()) == ERR) tick = waitForFrame(frameClock);
+        if (ch == KEY_RESIZE) {
+            drawIntroFrame(introFrames[step]);
+            continue;
         }
-        
-        mvprintw(title_y, temp_x, "%s", title_words[j].c_str());
-        
-        if (has_colors()) {
-            attroff(COLOR_PAIR(5));
-        }
-        
-        temp_x += title_words[j].length() + 1;  // Move position for next word (+ space)
-    }
-    
-    // Hide cursor after title animation is complete
-    curs_set(0);
-    refresh();
-    
-    // Hold the complete title for a moment (skip if intro was skipped)
-    if (!skip_intro) {
-        usleep(500000);  // 500ms final pause (reduced since we're adding more animation)
-    }
-    
-    // Show prompt to continue (animate if not skipped)
-    std::string prompt = "Press any key to continue...";
-    int prompt_y = title_y + 3;
-    int prompt_start_x = (max_x - prompt.length()) / 2;
-    
-    if (skip_intro) {
-        // Show prompt immediately if intro was skipped
-        mvprintw(prompt_y, prompt_start_x, "%s", prompt.c_str());
-        refresh();
-    } else {
-        // Animate prompt letter by letter
-        for (size_t i = 0; i < prompt.length(); i++) {
-            mvaddch(prompt_y, prompt_start_x + i, prompt[i]);
-            refresh();
-            usleep(50000);  // 50ms delay between letters (fast typing effect)
+        if (ch != ERR) {
+            curs_set(0);
+            return;
         }
+        drawIntroFrame(introFrames[++step]);
     }
     
     // Wait for any key press
-    getch();
+    nodelay(stdscr, FALSE);
+    readKey();
 }
 
 // Function to draw a decorative worm for closet/inventory screens
@@ -2055,38 +2158,15 @@ void drawDecorativeWorm(int y, int start_x, int width, int color_pair, bool reve
         head_x = start_x + (int)(progress * (width - 1));
     }
     
-    // Worm head animation frames (bouncy effect)
-    char head_chars[] = {'O', 'o', 'O', '0'};
-    char head_char = head_chars[frame % 4];
-    
-    // Apply color
-    if (has_colors()) {
-        attron(COLOR_PAIR(color_pair));
-    }
-    
-    // Draw the worm head
-    mvaddch(y, head_x, head_char);
-    
-    // Draw trailing body segments
-    int worm_length = 6;
-    for (int i = 1; i <= worm_length; i++) {
+    // Head, then the trailing body segments that fit
+    const chtype* cells = decorativeWormFrames[color_pair][frame % kDecorativeWormCycle];
+    mvaddch(y, head_x, cells[0]);
+    for (int i = 1; i < kDecorativeWormLength; i++) {
         int body_x = reverse_direction ? head_x + i : head_x - i;
         if (body_x >= start_x && body_x < start_x + width) {
-            char body_char;
-            if (i == 1) {
-                body_char = 'o';
-            } else if (i <= 3) {
-                body_char = '.';
-            } else {
-                body_char = (frame % 2 == 0) ? ':' : '.';
-            }
-            mvaddch(y, body_x, body_char);
+            mvaddch(y, body_x, cells[i]);
         }
     }
-    
-    if (has_colors()) {
-        attroff(COLOR_PAIR(color_pair));
-    }
 }
 
 // Function to draw bouncy worm animation with color support
@@ -2096,91 +2176,217 @@ void drawBouncyWorm(int y, int start_x, int width, double position, int frame) {
     // Calculate head position across the available width
     int head_x = start_x + (int)(position * (width - 1));
     
-    // Worm head animation frames (bouncy effect)
-    char head_chars[] = {'O', 'o', 'O', '0'};
-    char head_char = head_chars[frame % 4];
-    
-    // Determine worm color based on equipped variant
-    int worm_color = 0;  // Default white
+    // Equipped skin picks the frame table (head glyphs and color)
+    int skin = currentPlayerData != nullptr ? currentPlayerData->equippedSkin : SKIN_DEFAULT;
+    const chtype* cells = bouncyWormFrames[skin][frame % kBouncyWormCycle];
+    for (int i = 0; i < kBouncyWormLength && head_x - i >= start_x; i++) {
+        mvaddch(y, head_x - i, cells[i]);
+    }
+}
+
+
+
+
+// Cell states tracked by the typing screen renderer
+enum CellState {
+    CELL_UNTYPED = 0,
+    CELL_CORRECT = 1,
+    CELL_WRONG = 2
+};
+
+// Incremental renderer for the typing test screen.
+// Keeps the layout and per-cell state from the previous frame so a keystroke
+// only repaints the cells that changed, plus the worm row and stats lines.
+// Everything is repainted from scratch when the terminal is resized or the
+// target text changes.
+struct TypingRenderer {
+    bool valid;                          // False forces a full redraw next frame
+    int max_x, max_y;                    // Terminal size the cache was built for
+    int win_start_x, win_start_y;        // Window origin
+    int window_width, window_height;     // Window size
+    int text_row, text_col;              // Screen origin of the text area
+    TextLayout layout;                   // Cached wrap layout of the target
+    bool layout_stale;                   // Target changed since the layout was built
+    std::vector<unsigned char> cell_state;  // CellState drawn for each character
+    int last_text_row;                   // Last screen row holding target text
+    size_t drawn_typed;                  // typed.length() at the previous frame
+    const char* instructions;            // Bottom line of the chrome; null for the test keys
+
+    TypingRenderer() : valid(false), max_x(0), max_y(0), win_start_x(2), win_start_y(1),
+                       window_width(0), window_height(0), text_row(0), text_col(0),
+                       layout_stale(true), last_text_row(0), drawn_typed(0), instructions(nullptr) {}
+
+    // Force a full redraw on the next frame (another screen was shown on top)
+    void invalidate() { valid = false; }
+
+    // The target text was regenerated - rebuild the layout and redraw
+    void resetText() { valid = false; layout_stale = true; }
+};
+
+// Draw a single target character with the color for its state
+void drawTypingCell(TypingRenderer& r, const std::string& target, size_t pos, unsigned char state) {
+    int color = 3;  // Default to white (untyped)
+    if (state == CELL_CORRECT) {
+        color = 1;  // Custom orange-red color for correct characters
+    } else if (state == CELL_WRONG) {
+        color = 2;  // Red for incorrect characters
+    }
+
     if (has_colors()) {
-        if (currentPlayerData != nullptr) {
-            if (currentPlayerData->equippedWormColor == "yellow") {
-                worm_color = COLOR_PAIR(9);  // Golden/yellow worm
-            } else if (currentPlayerData->equippedWormColor == "magenta") {
-                worm_color = COLOR_PAIR(8);  // Magenta worm
-            } else if (currentPlayerData->equippedWormColor == "blue") {
-                worm_color = COLOR_PAIR(7);  // Blue worm
-            } else if (currentPlayerData->equippedWormColor == "pink") {
-                worm_color = COLOR_PAIR(4);  // Pink worm
-            } else {
-                worm_color = COLOR_PAIR(5);  // Default orange-red worm
-            }
-        } else {
-            worm_color = COLOR_PAIR(5);  // Default orange-red worm
-        }
-        attron(worm_color);
+        attron(COLOR_PAIR(color));
     }
-    
-    // Draw the worm head
-    mvaddch(y, head_x, head_char);
-    
-    // Draw trailing body segments (bouncy worm effect)
-    int worm_length = 8;  // Length of the worm trail
-    for (int i = 1; i <= worm_length && head_x - i >= start_x; i++) {
-        char body_char;
-        
-        // Create bouncy effect with different characters
-        if (i == 1) {
-            body_char = 'o';  // Close to head
-        } else if (i <= 3) {
-            body_char = '.';  // Medium distance
-        } else if (i <= 5) {
-            body_char = (frame % 2 == 0) ? '.' : ':';  // Animated middle
+    const TextPos& p = r.layout.pos[pos];
+    mvaddch(r.text_row + p.row, r.text_col + p.col, target[pos]);
+    if (has_colors()) {
+        attroff(COLOR_PAIR(color));
+    }
+    r.cell_state[pos] = state;
+}
+
+// Draw a centered line inside the typing window, blanking the previous contents of the row
+void drawTypingStatusLine(const TypingRenderer& r, int y, const char* text) {
+    mvhline(y, r.win_start_x + 1, ' ', r.window_width - 2);
+    if (text[0] != '\0') {
+        int x = r.win_start_x + (r.window_width - (int)strlen(text)) / 2;
+        mvprintw(y, x, "%s", text);
+    }
+}
+
+// Draw the static parts of the typing screen: border, title, separator, prompt and instructions
+void drawTypingChrome(const TypingRenderer& r) {
+    int win_start_x = r.win_start_x;
+    int win_start_y = r.win_start_y;
+    int window_width = r.window_width;
+    int window_height = r.window_height;
+
+    // Draw window outline, title and separator
+    drawRetroBox(stdscr, win_start_y, win_start_x, window_height, window_width);
+    drawBoxHeader(stdscr, win_start_y, win_start_x, window_width, "W4RMUP W0RM'S T3RMINAL TYP3R", 1, 2);
+
+    // Display instructions at bottom of window
+    std::string instruct = r.instructions != nullptr ? r.instructions
+                                                      : "ENTER: restart | ESC: quit | L: leaderboard | W: worm closet";
+    int instruct_x = win_start_x + (window_width - instruct.length()) / 2;
+    mvprintw(win_start_y + window_height - 3, instruct_x, "%s", instruct.c_str());
+
+    // Display prompt inside window (centered)
+    std::string prompt = "Type this:";
+    int prompt_x = win_start_x + (window_width - prompt.length()) / 2;
+    mvprintw(win_start_y + 4, prompt_x, "%s", prompt.c_str());
+}
+
+// Render one frame of the typing screen.
+// dirty_from is the lowest typed index that may have changed since the previous frame;
+// only cells from there up to the longer of the old and new typed text are repainted.
+// progressText replaces the typed/target character count when not null.
+void renderTypingScreen(TypingRenderer& r, const std::string& target, const std::string& typed,
+                        size_t dirty_from, double worm_position, int worm_frame,
+                        const char* statsText, const char* progressText) {
+    int max_x, max_y;
+    getmaxyx(stdscr, max_y, max_x);
+
+    bool resized = (max_x != r.max_x || max_y != r.max_y);
+    if (resized || !r.valid) {
+        r.max_x = max_x;
+        r.max_y = max_y;
+        r.window_width = max_x - 4;   // Leave 2 chars padding on each side
+        r.window_height = max_y - 4;  // Leave 2 lines padding top/bottom
+
+        if (resized) {
+            clear();  // Resync the whole terminal after a resize
         } else {
-            body_char = (frame % 3 == 0) ? ':' : '.';  // Tail with slight animation
+            erase();
         }
+        drawTypingChrome(r);
         
-        mvaddch(y, head_x - i, body_char);
-    }
-    
-    if (has_colors()) {
-        attroff(worm_color);
+        // Text area sits below the worm, inside the window margin
+        r.text_row = r.win_start_y + 7;
+        r.text_col = r.win_start_x + 2;
+        int wrap_width = r.window_width - 6;
+        if (r.layout_stale || r.layout.width != wrap_width) {
+            int64_t layout_start = frameProfiler != nullptr ? monotonicNanos() : 0;
+            buildTextLayout(r.layout, target, wrap_width);
+            r.layout_stale = false;
+            if (frameProfiler != nullptr) frameProfiler->current_ns[STAGE_LAYOUT] += monotonicNanos() - layout_start;
+        }
+        r.last_text_row = r.text_row + r.layout.rows - 1;
+
+        r.cell_state.assign(target.length(), CELL_UNTYPED);
+        for (size_t i = 0; i < target.length(); i++) {
+            unsigned char state = CELL_UNTYPED;
+            if (i < typed.length()) {
+                state = (typed[i] == target[i]) ? CELL_CORRECT : CELL_WRONG;
+            }
+            drawTypingCell(r, target, i, state);
+        }
+        r.valid = true;
+    } else {
+        // Repaint only the cells whose typed state may have changed
+        size_t dirty_to = std::max(r.drawn_typed, typed.length());
+        if (dirty_to > target.length()) dirty_to = target.length();
+        for (size_t i = dirty_from; i < dirty_to; i++) {
+            unsigned char state = CELL_UNTYPED;
+            if (i < typed.length()) {
+                state = (typed[i] == target[i]) ? CELL_CORRECT : CELL_WRONG;
+            }
+            if (state != r.cell_state[i]) {
+                drawTypingCell(r, target, i, state);
+            }
+        }
     }
-}
+    r.drawn_typed = typed.length();
 
+    // Draw bouncy worm animation above the text
+    int worm_y = r.win_start_y + 5;
+    int worm_start_x = r.win_start_x + 2;
+    int worm_width = r.window_width - 4;
+    if (worm_width > 0) {
+        mvhline(worm_y, worm_start_x, ' ', worm_width);
+    }
+    drawBouncyWorm(worm_y, worm_start_x, worm_width, worm_position, worm_frame);
 
+    // Stats always sit 2 rows below the last text line
+    int stats_start_y = r.last_text_row + 2;
+    char progress[64];
+    if (progressText == nullptr) {
+        snprintf(progress, sizeof(progress), "Progress: %zu/%zu", typed.length(), target.length());
+        progressText = progress;
+    }
+    drawTypingStatusLine(r, stats_start_y, progressText);
+    drawTypingStatusLine(r, stats_start_y + 1, statsText);
+}
 
+// Move the terminal cursor to the next character to type
+void placeTypingCursor(const TypingRenderer& r, const std::string& target, const std::string& typed) {
+    if (typed.length() < target.length()) {
+        curs_set(1);  // Show cursor when typing
+        const TextPos& p = r.layout.pos[typed.length()];
+        move(r.text_row + p.row, r.text_col + p.col);
+    } else {
+        curs_set(0);  // Hide cursor when not typing
+    }
+}
 
 // Cleanup function
 void cleanup() {
+    waitForScoreStore();  // The loader thread has to be joined before exit
+    stopPersistWorker();  // Every queued save reaches the disk before we go
     if (currentPlayerData != nullptr) {
         delete currentPlayerData;
         currentPlayerData = nullptr;
     }
+    unloadWordList(externalWordList);
     endwin();
+    if (frameProfiler != nullptr) {
+        writeProfileReport(*frameProfiler);
+        if (frameProfiler->io_fd >= 0) close(frameProfiler->io_fd);
+        delete frameProfiler;
+        frameProfiler = nullptr;
+    }
 }
 
-// Signal handler for clean exit
-void signalHandler(int signum) {
-    cleanup();
-    exit(signum);
-}
-
-int main(int argc, char* argv[]) {
-    // Set up signal handling and exit cleanup
-    signal(SIGINT, signalHandler);   // Handle Ctrl+C
-    signal(SIGTERM, signalHandler);  // Handle termination
-    atexit(cleanup);                 // Handle normal exit
-    
-    
-    // Initialize ncurses
-    initscr();                    // Start ncurses mode
-    cbreak();                     // Get chars immediately without Enter
-    noecho();                     // Don't auto-display typed chars
-    keypad(stdscr, TRUE);         // Enable special keys (arrows, F-keys)
-    curs_set(0);                  // Hide cursor initially
-    
-    // Initialize colors
+// Initialize color pairs used by every screen
+void initColors() {
     if (has_colors()) {           // Check if terminal supports colors
         start_color();            // Enable color functionality
 	assume_default_colors(-1,-1);
@@ -2226,33 +2432,580 @@ int main(int argc, char* argv[]) {
         init_pair(2, COLOR_MAGENTA, -1);     // Pair 2: wrong chars (red) with transparent background
         init_pair(3, COLOR_RED, -1);   // Pair 3: untyped chars (white) with transparent background
     }
+    buildAnimationFrames();       // Worm frames carry the color pairs
+}
+
+// Replay a recording headlessly (--replay).
+// Each record's events are fed through the same state machine as the typing loop on a
+// virtual clock, and every frame is rendered into an off-screen terminal to time the
+// render path. Prints the recomputed results for each record.
+int runReplay(const std::string& path) {
+    std::ifstream file(path.c_str(), std::ios::binary);
+    if (!file.is_open()) {
+        fprintf(stderr, "wormtype: could not open recording '%s'\n", path.c_str());
+        return 1;
+    }
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+
+    // Render into a terminal whose output goes nowhere
+    FILE* devnull = fopen("/dev/null", "w");
+    SCREEN* screen = nullptr;
+    if (devnull != nullptr) {
+        screen = newterm(getenv("TERM") != nullptr ? nullptr : (char*)"vt100", devnull, stdin);
+    }
+    if (screen != nullptr) {
+        set_term(screen);
+        resizeterm(40, 120);
+        initColors();
+    }
+
+    const unsigned char* p = (const unsigned char*)data.data();
+    size_t remaining = data.size();
+    int record = 0;
+    int status = 0;
+    while (remaining > 0) {
+        TestRecording recording;
+        size_t recordSize = 0;
+        RecordingStatus read = readRecording(p, remaining, recording, recordSize);
+        if (read != RECORDING_OK) {
+            fprintf(stderr, "wormtype: record %d is %s\n", record + 1,
+                    read == RECORDING_TRUNCATED ? "truncated" : "not a valid recording");
+            status = 1;
+            break;
+        }
+        record++;
+        uint16_t flags = recording.flags;
+        int timedSeconds = recording.timedSeconds;
+        int layoutWidth = recording.layoutWidth;
+        bool streamed = (flags & RECORD_STREAMED) != 0;
+        uint32_t eventCount = (uint32_t)recording.events.size();
+
+        // A streamed test scrolls through the words it drew, as the typing loop did
+        const std::string& script = recording.target;
+        std::string target;
+        TextStream stream;
+        TextLayout layout;
+        if (streamed) {
+            streamReplay(stream, target, script);
+            buildTextLayout(layout, target, layoutWidth);
+        } else {
+            target = script;
+        }
+
+        TypingState typing;
+        resetTypingState(typing, target.length());
+        TypingRenderer renderer;
+        int64_t now_ns = 0;
+        int64_t render_ns = 0;
+        int frames = 0;
+        for (uint32_t i = 0; i < eventCount && (streamed || typing.typed.length() < target.length()); i++) {
+            now_ns += (int64_t)recording.events[i].delta_us * 1000;
+            int key = recording.events[i].key;
+            if (timedSeconds > 0 && typingElapsed(typing, now_ns) >= timedSeconds) break;  // Time is up
+            size_t typed_before = typing.typed.length();
+            applyTypingKey(typing, target, key, now_ns);
+            if (streamed && streamAdvance(stream, target, typing, layout)) {
+                buildTextLayout(layout, target, layoutWidth);
+                renderer.resetText();
+                typed_before = 0;
+            }
+
+            if (screen != nullptr) {
+                int64_t frame_start = monotonicNanos();
+                double ball_position = 0.0;
+                if (timedSeconds > 0) {
+                    ball_position = std::min(1.0, typingElapsed(typing, now_ns) / timedSeconds);
+                } else if (!streamed) {
+                    ball_position = (double)typing.typed.length() / target.length();
+                }
+                renderTypingScreen(renderer, target, typing.typed, std::min(typed_before, typing.typed.length()),
+                                   ball_position, frames, "", nullptr);
+                placeTypingCursor(renderer, target, typing.typed);
+                presentFrame();
+                render_ns += monotonicNanos() - frame_start;
+                frames++;
+            }
+        }
+
+        // A timed test is only recorded once its time is up, and is scored over its whole length
+        double elapsed = timedSeconds > 0 ? (double)timedSeconds : typingDuration(typing);
+        double wpm = 0.0, accuracy = 0.0;
+        if (typing.typedCount() > 0) {
+            computeTypingStats(typing.correct, typing.typedCount(), elapsed, wpm, accuracy);
+        }
+        char mode[32];
+        if (timedSeconds > 0) {
+            snprintf(mode, sizeof(mode), "%ds timed", timedSeconds);
+        } else if (streamed) {
+            snprintf(mode, sizeof(mode), "endless");
+        } else {
+            snprintf(mode, sizeof(mode), "%u words", recording.wordCount);
+        }
+        bool complete = streamed || typing.typed.length() == target.length();
+        printf("record %d: %s%s%s, seed %llu, %u keys: %.1f WPM, %.1f%% accuracy, %.3fs%s",
+               record, mode, (flags & RECORD_PUNCTUATION) ? " +punctuation" : "",
+               (flags & RECORD_NUMBERS) ? " +numbers" : "", (unsigned long long)recording.seed, eventCount,
+               wpm, accuracy, elapsed, complete ? "" : " (incomplete)");
+        if (frames > 0) {
+            printf(", render %.1f us/frame", render_ns / 1000.0 / frames);
+        }
+        printf("\n");
+
+        p += recordSize;
+        remaining -= recordSize;
+    }
+
+    if (screen != nullptr) {
+        endwin();
+        delscreen(screen);
+    }
+    if (devnull != nullptr) {
+        fclose(devnull);
+    }
+    return status;
+}
+
+// How the texts of one test session are generated, so the first text and every
+// Enter-restart come out of the same pool and options
+struct TestText {
+    WordPool pool;
+    int wordCount;
+    bool streamed;                    // Timed and endless tests scroll a TextStream
+    int timedSeconds;                 // Length of a timed test, else 0
+    const WeakKeySampler* sampler;    // Weak-key practice; null draws words uniformly
+    uint16_t recordFlags;
+    uint64_t seed;                    // Seed that reproduces the current text
+    TextStream stream;
+    std::string streamWords;          // Every word the stream drew, kept for --record
+};
+
+// Alias table of the current weak-key practice session
+WeakKeySampler weakKeySampler;
+
+// Generate the next text of the session, start recording it and reset the key statistics
+void beginTestText(TestText& text, std::string& target) {
+    text.seed = nextTextSeed();
+    if (text.streamed) {
+        text.stream.history = testRecorder.enabled ? &text.streamWords : nullptr;
+        streamBegin(text.stream, target, text.pool, text.seed, text.sampler);
+    } else {
+        Pcg32 rng(text.seed);
+        if (text.sampler != nullptr) {
+            generateWeightedText(target, text.pool, *text.sampler, text.wordCount, rng);
+        } else {
+            generateTargetText(target, text.pool, text.wordCount, rng);
+        }
+    }
+    recorderBegin(testRecorder, text.seed, text.wordCount, text.recordFlags, monotonicNanos(), text.timedSeconds);
+    clearKeyStats(testKeyStats);
+    testKeyTimer = KeyTimer();
+}
+
+// Race mode (--join). The race screen reuses the typing renderer; each racer's worm crawls
+// along its own row below the stats as their progress arrives from the server.
+enum RacePhase { RACE_LOBBY, RACE_COUNTDOWN, RACE_TYPING, RACE_FINISHED, RACE_RESULTS };
+
+static const int kRaceNameWidth = 12;  // Name column left of each racer's worm
+
+// Finishers in place order, then everyone who did not finish
+struct RaceResultOrder {
+    bool operator()(const RacerInfo& a, const RacerInfo& b) const {
+        int pa = a.place == 0 ? 256 : a.place;
+        int pb = b.place == 0 ? 256 : b.place;
+        return pa < pb;
+    }
+};
+
+// Lobby and results board: the roster, or the places of the last race
+void drawRaceBoard(ChromeLayer& chrome, const RaceClient& client, bool results, const char* footer) {
+    int max_x, max_y;
+    getmaxyx(stdscr, max_y, max_x);
+    erase();
+    
+    int box_width = 56;
+    int box_height = 20;
+    int box_start_x = (max_x - box_width) / 2;
+    int box_start_y = (max_y - box_height) / 2;
+    composeBoxChrome(chrome, box_start_y, box_start_x, box_height, box_width,
+                     results ? "RACE RESULTS" : "RACE LOBBY", 2, 3);
+    
+    std::vector<RacerInfo> racers = client.racers;
+    if (results) {
+        std::stable_sort(racers.begin(), racers.end(), RaceResultOrder());
+    }
+    int rows = std::min((int)racers.size(), box_height - 8);
+    for (int i = 0; i < rows; i++) {
+        const RacerInfo& racer = racers[i];
+        int y = box_start_y + 5 + i;
+        if (has_colors()) attron(COLOR_PAIR(4 + racer.id % 6));
+        if (!results) {
+            mvprintw(y, box_start_x + 4, "%-32s%s", racer.name.c_str(), racer.id == client.id ? "(you)" : "");
+        } else if (racer.place == 0) {
+            mvprintw(y, box_start_x + 4, " --  %-24s", racer.name.c_str());  // Did not finish
+        } else {
+            mvprintw(y, box_start_x + 4, "%3u  %-24s %5.1f WPM %5.1f%%", racer.place, racer.name.c_str(),
+                     racer.wpm, racer.accuracy);
+        }
+        if (has_colors()) attroff(COLOR_PAIR(4 + racer.id % 6));
+    }
     
-    // Load leaderboard
-    std::vector<PlayerScore> leaderboard = loadLeaderboard();
+    mvprintw(box_start_y + box_height - 2, box_start_x + (box_width - (int)strlen(footer)) / 2, "%s", footer);
+}
+
+// Every other racer's worm on its own row under the stats lines, as far along as their progress
+void drawRacerWorms(const TypingRenderer& r, const RaceClient& client, size_t targetLength) {
+    int y = r.last_text_row + 5;
+    int last_y = r.win_start_y + r.window_height - 5;  // Keep clear of the instructions
+    int worm_x = r.win_start_x + 2 + kRaceNameWidth;
+    int worm_width = r.window_width - 6 - kRaceNameWidth;
+    for (size_t i = 0; i < client.racers.size() && y <= last_y; i++) {
+        const RacerInfo& racer = client.racers[i];
+        if (racer.id == client.id) continue;
+        double progress = targetLength > 0 ? std::min(1.0, (double)racer.position / targetLength) : 0.0;
+        mvhline(y, r.win_start_x + 1, ' ', r.window_width - 2);
+        mvprintw(y, r.win_start_x + 2, "%-*.*s", kRaceNameWidth - 1, kRaceNameWidth - 1, racer.name.c_str());
+        if (racer.place != 0) {
+            mvprintw(y, worm_x + worm_width - 4, "#%u", racer.place);
+        }
+        drawDecorativeWorm(y, worm_x, worm_width - 5, 4 + racer.id % 6, false, (int)(progress * 199));
+        y++;
+    }
+}
+
+// Race against the other clients of the server behind client until ESC or the connection drops
+int runRaceClient(RaceClient& client) {
+    waitForScoreStore();
+    std::vector<PlayerScore> leaderboard = topScores(scoreStore, 10);
+    std::string playerName = getPlayerName(leaderboard);
+    while (playerName == "WORM_CLOSET") {
+        showWormCloset();
+        playerName = getPlayerName(leaderboard);
+    }
+    if (playerName == "CANCEL" || playerName.empty()) {
+        raceDisconnect(client);
+        return 0;
+    }
+    setCurrentPlayer(playerName);
+    raceHello(client, playerName);
+    
+    RacePhase phase = RACE_LOBBY;
+    std::string target;
+    TypingState typing;
+    TypingRenderer renderer;
+    renderer.instructions = "ESC: leave the race";
+    ChromeLayer boardChrome;
+    char finishText[100] = "";
+    int ball_frame = 0;
+    
+    NodelayScope nodelayScope;
+    FrameClock frameClock(kTypingFrameNs);
+    frameClock.net_fd = client.fd;
+    bool connected = true;
+    while (connected) {
+        // Sleep until a key, a server message or the next animation tick
+        int ch = ERR;
+        bool tick = false;
+        while (!tick && (ch = readKey()) == ERR) tick = waitForFrame(frameClock);
+        
+        size_t dirty_from = typing.typed.length();
+        bool leave = false;
+        for (; ch != ERR; ch = readKey()) {
+            if (ch == 27) {
+                leave = true;
+                break;
+            }
+            if (phase != RACE_TYPING) continue;  // Keys before the start do nothing
+            int64_t key_ns = monotonicNanos();
+            size_t typed_before = typing.typedCount();
+            if (applyTypingKey(typing, target, ch, key_ns)) {
+                keyTimerUpdate(testKeyTimer, testKeyStats, typing, target, typed_before, key_ns);
+            }
+            dirty_from = std::min(dirty_from, typing.typed.length());
+            if (typing.typed.length() == target.length()) break;
+        }
+        if (leave) break;
+        
+        int64_t now = monotonicNanos();
+        if (phase == RACE_TYPING) {
+            uint16_t errors = (uint16_t)std::min(typing.incorrect(), (size_t)65535);
+            bool done = typing.typed.length() == target.length();
+            raceSendProgress(client, (uint32_t)typing.typed.length(), errors, now, done);
+            
+            if (done) {
+                double elapsed = typingDuration(typing);
+                double wpm = 0.0, accuracy = 0.0;
+                computeTypingStats(typing.correct, typing.typedCount(), elapsed, wpm, accuracy);
+                raceSendFinish(client, elapsed, wpm, accuracy);
+                snprintf(finishText, sizeof(finishText), "WPM: %.1f | Accuracy: %.1f%% | Time: %.1fs",
+                         wpm, accuracy, elapsed);
+                
+                // A race is scored like a word-count test of the same length
+                int words = (int)std::count(target.begin(), target.end(), ' ') + 1;
+                addScore(scoreStore, makePlayerScore(playerName, wpm, accuracy, elapsed, words, false, false,
+                                                     wallClockMillis()));
+                if (currentPlayerData != nullptr) {
+                    mergeKeyStats(currentPlayerData->keyStats, testKeyStats);
+                    saveKeyStats(keyStatsStore, currentPlayerData->playerName, currentPlayerData->keyStats);
+                }
+                phase = RACE_FINISHED;
+            }
+        }
+        
+        // Read what the server sent and hand it our queued updates
+        connected = racePump(client, now);
+        if (client.started) {
+            client.started = false;
+            target = client.target;
+            resetTypingState(typing, target.length());
+            clearKeyStats(testKeyStats);
+            testKeyTimer = KeyTimer();
+            renderer.resetText();
+            dirty_from = 0;
+            phase = RACE_COUNTDOWN;
+        }
+        if (client.over) {
+            client.over = false;
+            phase = RACE_RESULTS;
+        }
+        if (phase == RACE_COUNTDOWN && now >= client.start_ns) phase = RACE_TYPING;
+        if (tick) ball_frame++;
+        
+        if (phase == RACE_LOBBY || phase == RACE_RESULTS) {
+            drawRaceBoard(boardChrome, client, phase == RACE_RESULTS,
+                          "Waiting for the host to start a race | ESC: leave");
+            renderer.invalidate();  // The board replaced the typing screen
+            curs_set(0);
+            presentFrame();
+            continue;
+        }
+        
+        char progressText[64];
+        const RacerInfo* self = findRacer(client, client.id);
+        if (phase == RACE_COUNTDOWN) {
+            snprintf(progressText, sizeof(progressText), "Get ready: %d",
+                     (int)((client.start_ns - now + 999999999) / 1000000000));
+        } else if (phase == RACE_FINISHED && self != nullptr && self->place != 0) {
+            snprintf(progressText, sizeof(progressText), "Finished #%u - waiting for the others", self->place);
+        } else {
+            snprintf(progressText, sizeof(progressText), "Progress: %zu/%zu", typing.typed.length(), target.length());
+        }
+        
+        char statsText[100] = "";
+        if (phase == RACE_FINISHED) {
+            snprintf(statsText, sizeof(statsText), "%s", finishText);
+        } else if (typing.started && typing.typedCount() > 0) {
+            double elapsed = typingElapsed(typing, now);
+            if (elapsed > 0) {
+                double wpm, accuracy;
+                computeTypingStats(typing.correct, typing.typedCount(), elapsed, wpm, accuracy);
+                snprintf(statsText, sizeof(statsText), "WPM: %.1f | Accuracy: %.1f%% | Time: %.1fs",
+                         wpm, accuracy, elapsed);
+            }
+        }
+        
+        double ball_position = target.empty() ? 0.0 : (double)typing.typed.length() / target.length();
+        renderTypingScreen(renderer, target, typing.typed, dirty_from, ball_position, ball_frame, statsText,
+                           progressText);
+        drawRacerWorms(renderer, client, target.length());
+        if (phase == RACE_TYPING) {
+            placeTypingCursor(renderer, target, typing.typed);
+        } else {
+            curs_set(0);
+        }
+        presentFrame();
+    }
+    
+    if (!connected) {
+        // Tell the player instead of dropping straight back to the shell
+        nodelay(stdscr, FALSE);
+        erase();
+        std::string message = "Lost the connection to the race server. Press any key.";
+        int max_x, max_y;
+        getmaxyx(stdscr, max_y, max_x);
+        mvprintw(max_y / 2, std::max(0, (max_x - (int)message.length()) / 2), "%s", message.c_str());
+        refresh();
+        readKey();
+    }
+    raceDisconnect(client);
+    return 0;
+}
+
+// Print command line usage
+void printUsage(const char* program) {
+    fprintf(stderr, "Usage: %s [--wordlist <file>] [--seed <n>] [--record <file>] [--replay <file>] [--profile <file>]\n"
+                    "       %*s [--quick] [--host <port> [--race-words <n>] | --join <host[:port]>]\n",
+            program, (int)strlen(program), "");
+    fprintf(stderr, "  --wordlist <file>  Draw words from a newline-delimited file\n");
+    fprintf(stderr, "  --seed <n>         Generate the same sequence of texts on every run\n");
+    fprintf(stderr, "  --record <file>    Append a keystroke recording of each completed test\n");
+    fprintf(stderr, "  --replay <file>    Replay a recording headlessly and print the results\n");
+    fprintf(stderr, "  --profile <file>   Show frame timings while typing and write a histogram on exit\n");
+    fprintf(stderr, "  --quick            Skip the intro and menu and start a test straight away\n");
+    fprintf(stderr, "  --host <port>      Run a headless race server; press Enter to start each race\n");
+    fprintf(stderr, "  --race-words <n>   Words in each race the server starts (default 25)\n");
+    fprintf(stderr, "  --join <host>      Join a race server (default port %d; IPv6 as [addr]:port)\n", kRaceDefaultPort);
+}
+
+static_assert(kKeyBackspace == KEY_BACKSPACE, "core backspace code must match ncurses");
+
+int main(int argc, char* argv[]) {
+    // Seed text generation from the clock unless --seed is given
+    seedGenerator = Pcg32((uint64_t)time(nullptr) ^ ((uint64_t)getpid() << 32));
+    
+    // Parse command line options before touching the terminal
+    long hostPort = 0;             // --host: run the race server instead of the game
+    long raceWords = 25;
+    std::string joinAddress;       // --join: race instead of the menu
+    bool quickStart = false;       // --quick: skip the intro and menu, load the history in the background
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--wordlist" && i + 1 < argc) {
+            std::string path = argv[++i];
+            if (!loadWordList(path, externalWordList)) {
+                fprintf(stderr, "wormtype: could not load word list '%s'\n", path.c_str());
+                return 1;
+            }
+        } else if (arg == "--seed" && i + 1 < argc) {
+            char* end = nullptr;
+            uint64_t seed = strtoull(argv[++i], &end, 0);
+            if (end == argv[i] || *end != '\0') {
+                fprintf(stderr, "wormtype: invalid seed '%s'\n", argv[i]);
+                return 1;
+            }
+            seedGenerator = Pcg32(seed);
+        } else if (arg == "--record" && i + 1 < argc) {
+            enableRecording(testRecorder, argv[++i]);
+        } else if (arg == "--replay" && i + 1 < argc) {
+            return runReplay(argv[++i]);
+        } else if (arg == "--profile" && i + 1 < argc) {
+            enableProfiler(argv[++i]);
+        } else if (arg == "--host" && i + 1 < argc) {
+            char* end = nullptr;
+            hostPort = strtol(argv[++i], &end, 10);
+            if (end == argv[i] || *end != '\0' || hostPort <= 0 || hostPort > 65535) {
+                fprintf(stderr, "wormtype: invalid port '%s'\n", argv[i]);
+                return 1;
+            }
+        } else if (arg == "--race-words" && i + 1 < argc) {
+            char* end = nullptr;
+            raceWords = strtol(argv[++i], &end, 10);
+            if (end == argv[i] || *end != '\0' || raceWords <= 0 || raceWords > 1000) {
+                fprintf(stderr, "wormtype: invalid word count '%s'\n", argv[i]);
+                return 1;
+            }
+        } else if (arg == "--join" && i + 1 < argc) {
+            joinAddress = argv[++i];
+        } else if (arg == "--quick") {
+            quickStart = true;
+        } else {
+            printUsage(argv[0]);
+            return (arg == "--help" || arg == "-h") ? 0 : 1;
+        }
+    }
+    
+    // The race server never opens the terminal; it runs after the options so --wordlist and --seed apply
+    if (hostPort > 0) {
+        return runRaceServer((int)hostPort, (int)raceWords, false, false);
+    }
+    
+    // Reach the server before the UI starts so a failure is a plain error message
+    RaceClient raceClient;
+    if (!joinAddress.empty()) {
+        std::string host, error;
+        int port = 0;
+        if (!parseRaceAddress(joinAddress, host, port, error)) {
+            fprintf(stderr, "wormtype: invalid race address '%s': %s\n", joinAddress.c_str(), error.c_str());
+            return 1;
+        }
+        if (!raceConnect(raceClient, host, port, error)) {
+            bool ipv6 = host.find(':') != std::string::npos;
+            fprintf(stderr, "wormtype: could not join %s%s%s:%d: %s\n", ipv6 ? "[" : "", host.c_str(),
+                    ipv6 ? "]" : "", port, error.c_str());
+            return 1;
+        }
+    }
+    
+    // Set up signal handling and exit cleanup
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = signalHandler;  // No SA_RESTART - see readKey()
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGINT, &action, nullptr);   // Handle Ctrl+C
+    sigaction(SIGTERM, &action, nullptr);  // Handle termination
+    atexit(cleanup);                 // Handle normal exit
+    
+    
+    // Initialize ncurses
+    initscr();                    // Start ncurses mode
+    cbreak();                     // Get chars immediately without Enter
+    noecho();                     // Don't auto-display typed chars
+    keypad(stdscr, TRUE);         // Enable special keys (arrows, F-keys)
+    curs_set(0);                  // Hide cursor initially
+    
+    initColors();                 // Set up color pairs
+    
+    // Saves from here on are written by the persistence worker, off the UI thread
+    startPersistWorker();
+    
+    // Load the score history (imports leaderboard.txt on first run). --quick reads it in the
+    // background after the profiles instead, and the leaderboard is filled in on first use.
+    std::vector<PlayerScore> leaderboard;
+    if (!quickStart) {
+        openScoreStore(scoreStore);
+        leaderboard = topScores(scoreStore, 10);
+    }
+    
+    // Load player profiles (imports saves/*.save on first run)
+    if (!openPlayerDatabase(playerDatabase)) {
+        importLegacySaves();
+    }
+    openKeyStatsStore(keyStatsStore);
+    if (quickStart) {
+        loadScoreStoreInBackground();
+    }
+    
+    if (raceClient.fd >= 0) {
+        return runRaceClient(raceClient);
+    }
     
     // Player-specific achievement system now handles initialization
     
-    // Show animated intro
-    showAnimatedIntro();
+    // Show animated intro (--quick goes straight into a test)
+    if (!quickStart) {
+        showAnimatedIntro();
+    }
+    bool skipMenu = quickStart;
     
-    // Start with a default player name - unified menu will handle player selection
+    // Resume the player and settings of the last session - PLAYER1 and a 25-word test the first time
     std::string playerName = "PLAYER1";
-    setCurrentPlayer(playerName); // Initialize default player data
+    GameSettings settings;
+    settings.wordCount = 25;  // Default values
+    settings.includePunctuation = false;
+    settings.includeNumbers = false;
+    settings.isCustomWordCount = false;
+    settings.customWords = 0;
+    settings.timedSeconds = 0;
+    settings.endless = false;
+    settings.weakKeys = false;
+    restoreSession(settings, playerName);  // Read with the profiles - no extra I/O
+    setCurrentPlayer(playerName); // Initialize player data, including the equipped skin
     
     // Main game loop
     while (true) {
         
-        // Set up game settings with current player name
-        GameSettings settings;
+        // The menu starts from the settings of the previous test
         settings.playerName = playerName;
-        settings.wordCount = 25;  // Default values
-        settings.includePunctuation = false;
-        settings.includeNumbers = false;
-        settings.isCustomWordCount = false;
-        settings.customWords = 0;
         
         // Show unified menu (pass leaderboard by reference so it can be updated)
-        bool startTest = showUnifiedMenu(settings, leaderboard);
+        bool startTest = true;
+        if (skipMenu) {
+            skipMenu = false;  // Only the first test of a --quick start
+        } else {
+            waitForScoreStore();
+            leaderboard = topScores(scoreStore, 10);
+            startTest = showUnifiedMenu(settings, leaderboard);
+        }
         
         // If user cancelled, exit program
         if (!startTest) {
@@ -2263,473 +3016,216 @@ int main(int argc, char* argv[]) {
         int wordCount = settings.isCustomWordCount ? settings.customWords : settings.wordCount;
         bool includePunctuation = settings.includePunctuation;
         bool includeNumbers = settings.includeNumbers;
+        int timedSeconds = settings.timedSeconds;               // 0 unless a timed test
+        bool streamed = timedSeconds > 0 || settings.endless;   // Text scrolls past instead of ending
+        bool weakKeys = settings.weakKeys;                      // Practice: words weighted to slow bigrams, no score
         
         // Update player name if it was changed in the menu
         if (settings.playerName != playerName) {
             playerName = settings.playerName;
         }
+        rememberSession(settings, playerName);
         
-        // Word list for random text generation
-        std::vector<std::string> words;
-        words.push_back("the"); words.push_back("quick"); words.push_back("brown"); words.push_back("fox");
-        words.push_back("jumps"); words.push_back("over"); words.push_back("lazy"); words.push_back("dog");
-        words.push_back("hello"); words.push_back("world"); words.push_back("typing"); words.push_back("test");
-        words.push_back("program"); words.push_back("simple"); words.push_back("fast"); words.push_back("computer");
-        words.push_back("keyboard"); words.push_back("screen"); words.push_back("mouse"); words.push_back("software");
-        words.push_back("hardware"); words.push_back("internet"); words.push_back("website"); words.push_back("email");
-        words.push_back("password"); words.push_back("username"); words.push_back("login"); words.push_back("download");
-        words.push_back("upload"); words.push_back("file"); words.push_back("folder"); words.push_back("document");
-        words.push_back("window"); words.push_back("button"); words.push_back("click"); words.push_back("double");
-        words.push_back("right"); words.push_back("left"); words.push_back("center"); words.push_back("top");
-        words.push_back("bottom"); words.push_back("middle"); words.push_back("side"); words.push_back("front");
-        words.push_back("back"); words.push_back("forward"); words.push_back("backward"); words.push_back("up");
-        words.push_back("down"); words.push_back("north"); words.push_back("south"); words.push_back("east");
-        words.push_back("west"); words.push_back("morning"); words.push_back("afternoon"); words.push_back("evening");
-        words.push_back("night"); words.push_back("today"); words.push_back("tomorrow"); words.push_back("yesterday");
-        words.push_back("week"); words.push_back("month"); words.push_back("year"); words.push_back("time");
-        words.push_back("clock"); words.push_back("watch"); words.push_back("minute"); words.push_back("second");
-        words.push_back("hour"); words.push_back("schedule"); words.push_back("appointment"); words.push_back("meeting");
-        words.push_back("conference"); words.push_back("presentation"); words.push_back("project"); words.push_back("task");
-        words.push_back("work"); words.push_back("job"); words.push_back("career"); words.push_back("business");
-        words.push_back("company"); words.push_back("office"); words.push_back("desk"); words.push_back("chair");
-        words.push_back("table"); words.push_back("phone"); words.push_back("mobile"); words.push_back("tablet");
-        words.push_back("laptop"); words.push_back("desktop"); words.push_back("server"); words.push_back("network");
-        words.push_back("wireless"); words.push_back("bluetooth"); words.push_back("cable"); words.push_back("connection");
-        words.push_back("signal"); words.push_back("data"); words.push_back("information"); words.push_back("knowledge");
-        words.push_back("learning"); words.push_back("education"); words.push_back("school"); words.push_back("university");
-        words.push_back("student"); words.push_back("teacher"); words.push_back("book"); words.push_back("page");
-        words.push_back("chapter"); words.push_back("paragraph"); words.push_back("sentence"); words.push_back("word");
-        words.push_back("letter"); words.push_back("number"); words.push_back("count"); words.push_back("calculate");
-        words.push_back("mathematics"); words.push_back("science"); words.push_back("technology"); words.push_back("innovation");
-        words.push_back("development"); words.push_back("progress"); words.push_back("improvement"); words.push_back("solution");
-        words.push_back("problem"); words.push_back("challenge"); words.push_back("opportunity");
-        
-        // Words with punctuation for punctuation mode
-        std::vector<std::string> punctuationWords;
-        punctuationWords.push_back("hello,"); punctuationWords.push_back("world!"); punctuationWords.push_back("it's"); punctuationWords.push_back("don't");
-        punctuationWords.push_back("can't"); punctuationWords.push_back("won't"); punctuationWords.push_back("we're"); punctuationWords.push_back("they're");
-        punctuationWords.push_back("you'll"); punctuationWords.push_back("I'll"); punctuationWords.push_back("she'll"); punctuationWords.push_back("he'll");
-        punctuationWords.push_back("we'll"); punctuationWords.push_back("they'll"); punctuationWords.push_back("isn't"); punctuationWords.push_back("aren't");
-        punctuationWords.push_back("wasn't"); punctuationWords.push_back("weren't"); punctuationWords.push_back("hasn't"); punctuationWords.push_back("haven't");
-        punctuationWords.push_back("doesn't"); punctuationWords.push_back("didn't"); punctuationWords.push_back("shouldn't"); punctuationWords.push_back("wouldn't");
-        punctuationWords.push_back("couldn't"); punctuationWords.push_back("mustn't"); punctuationWords.push_back("needn't"); punctuationWords.push_back("shan't");
-        punctuationWords.push_back("hello."); punctuationWords.push_back("goodbye!"); punctuationWords.push_back("really?"); punctuationWords.push_back("amazing!");
-        punctuationWords.push_back("yes,"); punctuationWords.push_back("no,"); punctuationWords.push_back("wait..."); punctuationWords.push_back("stop!");
-        punctuationWords.push_back("go!"); punctuationWords.push_back("help!"); punctuationWords.push_back("wow!"); punctuationWords.push_back("oh!");
-        
-        // Words with numbers for numbers mode
-        std::vector<std::string> numberWords;
-        numberWords.push_back("123"); numberWords.push_back("456"); numberWords.push_back("789"); numberWords.push_back("101");
-        numberWords.push_back("202"); numberWords.push_back("303"); numberWords.push_back("404"); numberWords.push_back("505");
-        numberWords.push_back("2024"); numberWords.push_back("2025"); numberWords.push_back("1995"); numberWords.push_back("2000");
-        numberWords.push_back("42"); numberWords.push_back("99"); numberWords.push_back("100"); numberWords.push_back("1000");
-        numberWords.push_back("test1"); numberWords.push_back("test2"); numberWords.push_back("file1"); numberWords.push_back("file2");
-        numberWords.push_back("user1"); numberWords.push_back("user2"); numberWords.push_back("admin123"); numberWords.push_back("pass123");
-        numberWords.push_back("v1.0"); numberWords.push_back("v2.0"); numberWords.push_back("v3.1"); numberWords.push_back("v4.2");
-        numberWords.push_back("room101"); numberWords.push_back("room202"); numberWords.push_back("apt3b"); numberWords.push_back("unit4a");
-        numberWords.push_back("level1"); numberWords.push_back("level2"); numberWords.push_back("step1"); numberWords.push_back("step2");
-        numberWords.push_back("page1"); numberWords.push_back("page2"); numberWords.push_back("item1"); numberWords.push_back("item2");
-    
-    srand(time(nullptr));          // Seed random number generator with current time
-    
     // Generate target text based on selected options
-    std::string target = "";       // Text user needs to type
-    
-    if (includeNumbers && !includePunctuation) {
-        // Numbers only mode: only pure numbers and spaces
-        std::vector<std::string> pureNumbers;
-        pureNumbers.push_back("0"); pureNumbers.push_back("1"); pureNumbers.push_back("2"); pureNumbers.push_back("3");
-        pureNumbers.push_back("4"); pureNumbers.push_back("5"); pureNumbers.push_back("6"); pureNumbers.push_back("7");
-        pureNumbers.push_back("8"); pureNumbers.push_back("9"); pureNumbers.push_back("10"); pureNumbers.push_back("11");
-        pureNumbers.push_back("12"); pureNumbers.push_back("13"); pureNumbers.push_back("14"); pureNumbers.push_back("15");
-        pureNumbers.push_back("16"); pureNumbers.push_back("17"); pureNumbers.push_back("18"); pureNumbers.push_back("19");
-        pureNumbers.push_back("20"); pureNumbers.push_back("25"); pureNumbers.push_back("30"); pureNumbers.push_back("42");
-        pureNumbers.push_back("50"); pureNumbers.push_back("75"); pureNumbers.push_back("99"); pureNumbers.push_back("100");
-        pureNumbers.push_back("123"); pureNumbers.push_back("456"); pureNumbers.push_back("789"); pureNumbers.push_back("1000");
-        pureNumbers.push_back("2024"); pureNumbers.push_back("2025"); pureNumbers.push_back("3000"); pureNumbers.push_back("5000");
-        
-        for (int i = 0; i < wordCount; i++) {
-            if (i > 0) target += " ";  // Add space between numbers
-            target += pureNumbers[rand() % pureNumbers.size()];
-        }
-    } else {
-        // Create combined word pool based on selected options
-        std::vector<std::string> combinedWords = words;  // Start with base words
-        
-        if (includePunctuation) {
-            // Add punctuation words to the pool
-            for (size_t i = 0; i < punctuationWords.size(); i++) {
-                combinedWords.push_back(punctuationWords[i]);
-            }
-        }
-        
-        if (includeNumbers) {
-            // Add number words to the pool (mixed with words)
-            for (size_t i = 0; i < numberWords.size(); i++) {
-                combinedWords.push_back(numberWords[i]);
-            }
-        }
-        
-        // Generate target text using selected word count and combined word pool
-        for (int i = 0; i < wordCount; i++) {
-            if (i > 0) target += " ";  // Add space between words
-            target += combinedWords[rand() % combinedWords.size()];  // Pick random word from combined pool
-        }
+    TestText text;
+    text.pool = selectWordPool(includePunctuation, includeNumbers);
+    text.wordCount = wordCount;
+    text.streamed = streamed;
+    text.timedSeconds = timedSeconds;
+    text.sampler = nullptr;
+    if (weakKeys && currentPlayerData != nullptr) {
+        // Weigh the pool once for this session; restarts reuse the table
+        prepareWeakKeySampler(weakKeySampler, text.pool, currentPlayerData->keyStats);
+        text.sampler = &weakKeySampler;
     }
+    text.recordFlags = (includePunctuation ? RECORD_PUNCTUATION : 0) | (includeNumbers ? RECORD_NUMBERS : 0) |
+                       (externalWordList.words.empty() ? 0 : RECORD_WORDLIST) | (weakKeys ? RECORD_WEAK_KEYS : 0) |
+                       (streamed ? RECORD_STREAMED : 0);
+    std::string target = "";       // Text user needs to type
+    beginTestText(text, target);
     
-    std::string typed = "";        // What user has typed so far
-    time_t start_time = 0;         // When user started typing
-    bool started = false;          // Track if timing has begun
-    
-    // Helper function to find next word start position (converted to avoid lambda)
-    // We'll implement this inline in the space handler below
-    
-    // Word jump tracking
-    size_t jumped_from_pos = std::string::npos;  // Position where space jump occurred
-    bool has_jumped = false;       // Whether a word jump is active
+    TypingState typing;            // Typed text, word-jump state and running score
     
     // Ball animation variables
     int ball_frame = 0;            // Animation frame for rolling ball
     double ball_position = 0.0;    // Ball position (0.0 to 1.0 across screen)
     
-    int ch;                        // Variable to store key pressed
-    while ((ch = getch()) != 27) { // Main loop - ESC (27) to quit
-        
-        // Handle different types of input
-        if (ch == KEY_BACKSPACE || ch == 127 || ch == 8) {  // Backspace handling
-            if (has_jumped && typed.length() > jumped_from_pos) {
-                // If we jumped and are past the jump point, return to jump position
-                typed = typed.substr(0, jumped_from_pos);
-                has_jumped = false;
-                jumped_from_pos = std::string::npos;
-            } else if (!typed.empty()) {  // Normal backspace
-                typed.pop_back();
-                has_jumped = false;  // Clear any jump state
-                jumped_from_pos = std::string::npos;
+    // Incremental renderer - draws the first frame before any key is pressed
+    TypingRenderer renderer;
+    resetTypingState(typing, target.length());
+    renderTypingScreen(renderer, target, typing.typed, 0, ball_position, ball_frame, "", nullptr);
+    placeTypingCursor(renderer, target, typing.typed);
+    refresh();
+    
+    // Frame loop: wake on input or the animation tick, drain every waiting key, repaint once
+    NodelayScope nodelayScope;
+    FrameClock frameClock(kTypingFrameNs);
+    bool quit = false;
+    while (!quit) {
+        // Sleep until a key arrives or the next animation tick is due
+        int ch = ERR;
+        bool tick = false;
+        while (!tick && (ch = readKey()) == ERR) tick = waitForFrame(frameClock);
+        
+        // Profile frames that handle input; ones that opened another screen are dropped
+        bool profile_frame = frameProfiler != nullptr && ch != ERR;
+        if (profile_frame) profileBeginFrame(*frameProfiler);
+        
+        size_t dirty_from = typing.typed.length();  // Lowest typed position changed this frame
+        for (; ch != ERR; ch = profiledGetch()) {
+            if (ch == 27) { // ESC - back to the menu
+                quit = true;
+                break;
             }
-        } else if (ch == ' ' || ch == 32) { // Space key - special handling
-            if (typed.length() < target.length()) {
-                if (!started) {
-                    start_time = time(nullptr);
-                    started = true;
-                }
-                
-                // Check if we're in the middle of a word (next char isn't space)
-                if (typed.length() < target.length() && target[typed.length()] != ' ') {
-                    // We're in the middle of a word - jump to next word start
-                    jumped_from_pos = typed.length();
-                    
-                    // Find next word start position inline
-                    size_t next_word_pos = target.length(); // Default to end
-                    size_t space_pos = target.find(' ', typed.length());
-                    if (space_pos != std::string::npos) {
-                        // Skip any consecutive spaces and find next non-space
-                        while (space_pos < target.length() && target[space_pos] == ' ') {
-                            space_pos++;
-                        }
-                        next_word_pos = space_pos;
-                    }
-                    
-                    // Fill with incorrect markers for skipped letters
-                    while (typed.length() < next_word_pos && typed.length() < target.length()) {
-                        if (target[typed.length()] == ' ') {
-                            typed += ' ';  // Keep spaces as spaces
-                        } else {
-                            typed += '_';  // Mark skipped letters as incorrect
+            int64_t key_ns = monotonicNanos();  // Timestamp the keystroke as soon as it is read
+            if (timedSeconds > 0 && typingElapsed(typing, key_ns) >= timedSeconds) break;  // Time is up
+        
+            recorderKey(testRecorder, key_ns, ch);
+        
+            // Handle different types of input
+            size_t typed_before = typing.typedCount();
+            if (applyTypingKey(typing, target, ch, key_ns)) {
+                // Text edits, the space word-jump and backspace are handled by the state machine
+                keyTimerUpdate(testKeyTimer, testKeyStats, typing, target, typed_before, key_ns);
+            } else if (ch == 10 || ch == 13) { // Enter key (newline/carriage return)
+                // Restart with new text
+                ball_position = 0.0;  // Reset ball position
+                ball_frame = 0;       // Reset ball animation
+                renderer.resetText();  // New text needs a new layout
+                // Generate new text from the same pool - only the random draw is repeated
+                beginTestText(text, target);
+                resetTypingState(typing, target.length());  // Clear typed text, jump state, score and timer
+            } else if (ch == 'l' || ch == 'L') { // Show leaderboard
+                profile_frame = false;
+                nodelay(stdscr, FALSE);  // The menus below read keys blocking
+                waitForScoreStore();
+                leaderboard = topScores(scoreStore, 10);
+                int leaderboardResult = showLeaderboard(leaderboard);
+                if (leaderboardResult == 2) {
+                    // Change name requested
+                    std::string newPlayerName = getPlayerName(leaderboard);
+                    if (newPlayerName != "CANCEL") {
+                        while (newPlayerName == "WORM_CLOSET") {
+                            showWormCloset();
+                            newPlayerName = getPlayerName(leaderboard);
+                            if (newPlayerName == "CANCEL") {
+                                break;
+                            }
                         }
-                    }
-                    has_jumped = true;
-                } else {
-                    // Normal space - we're at a space position
-                    typed += ' ';
-                    has_jumped = false;
-                    jumped_from_pos = std::string::npos;
-                }
-            }
-        } else if (ch >= 33 && ch <= 126) { // Other printable ASCII characters (not space)
-            if (typed.length() < target.length()) {  // Don't go past target
-                if (!started) {    // Start timer on first keypress
-                    start_time = time(nullptr);
-                    started = true;
-                }
-                typed += (char)ch; // Add character to typed string
-                has_jumped = false; // Clear jump state on normal typing
-                jumped_from_pos = std::string::npos;
-            }
-        } else if (ch == 10 || ch == 13) { // Enter key (newline/carriage return)
-            // Restart with new text
-            typed = "";        // Clear typed text
-            started = false;   // Reset timer
-            target = "";       // Clear target
-            ball_position = 0.0;  // Reset ball position
-            ball_frame = 0;       // Reset ball animation
-            has_jumped = false;   // Reset jump state
-            jumped_from_pos = std::string::npos;
-            // Generate new text with selected word count using same logic as initial generation
-            if (includeNumbers && !includePunctuation) {
-                // Numbers only mode: only pure numbers and spaces
-                std::vector<std::string> pureNumbers;
-                pureNumbers.push_back("0"); pureNumbers.push_back("1"); pureNumbers.push_back("2"); pureNumbers.push_back("3");
-                pureNumbers.push_back("4"); pureNumbers.push_back("5"); pureNumbers.push_back("6"); pureNumbers.push_back("7");
-                pureNumbers.push_back("8"); pureNumbers.push_back("9"); pureNumbers.push_back("10"); pureNumbers.push_back("11");
-                pureNumbers.push_back("12"); pureNumbers.push_back("13"); pureNumbers.push_back("14"); pureNumbers.push_back("15");
-                pureNumbers.push_back("16"); pureNumbers.push_back("17"); pureNumbers.push_back("18"); pureNumbers.push_back("19");
-                pureNumbers.push_back("20"); pureNumbers.push_back("25"); pureNumbers.push_back("30"); pureNumbers.push_back("42");
-                pureNumbers.push_back("50"); pureNumbers.push_back("75"); pureNumbers.push_back("99"); pureNumbers.push_back("100");
-                pureNumbers.push_back("123"); pureNumbers.push_back("456"); pureNumbers.push_back("789"); pureNumbers.push_back("1000");
-                pureNumbers.push_back("2024"); pureNumbers.push_back("2025"); pureNumbers.push_back("3000"); pureNumbers.push_back("5000");
-                
-                for (int i = 0; i < wordCount; i++) {
-                    if (i > 0) target += " ";
-                    target += pureNumbers[rand() % pureNumbers.size()];
-                }
-            } else {
-                // Create combined word pool based on selected options
-                std::vector<std::string> combinedWords = words;  // Start with base words
-                
-                if (includePunctuation) {
-                    // Add punctuation words to the pool
-                    for (size_t i = 0; i < punctuationWords.size(); i++) {
-                        combinedWords.push_back(punctuationWords[i]);
-                    }
-                }
-                
-                if (includeNumbers) {
-                    // Add number words to the pool (mixed with words)
-                    for (size_t i = 0; i < numberWords.size(); i++) {
-                        combinedWords.push_back(numberWords[i]);
-                    }
-                }
-                
-                for (int i = 0; i < wordCount; i++) {
-                    if (i > 0) target += " ";
-                    target += combinedWords[rand() % combinedWords.size()];
-                }
-            }
-        } else if (ch == 'l' || ch == 'L') { // Show leaderboard
-            int leaderboardResult = showLeaderboard(leaderboard);
-            if (leaderboardResult == 2) {
-                // Change name requested
-                std::string newPlayerName = getPlayerName(leaderboard);
-                if (newPlayerName != "CANCEL") {
-                    while (newPlayerName == "WORM_CLOSET") {
-                        showWormCloset();
-                        newPlayerName = getPlayerName(leaderboard);
-                        if (newPlayerName == "CANCEL") {
-                            break;
+                        if (newPlayerName != "CANCEL") {
+                            playerName = newPlayerName; // Update player name
+                            setCurrentPlayer(playerName); // Update player data
                         }
                     }
-                    if (newPlayerName != "CANCEL") {
-                        playerName = newPlayerName; // Update player name
-                        setCurrentPlayer(playerName); // Update player data
-                    }
+                } else if (leaderboardResult == 3) {
+                    // Worm closet requested
+                    showWormCloset();
                 }
-            } else if (leaderboardResult == 3) {
-                // Worm closet requested
+                nodelay(stdscr, TRUE);
+                renderer.invalidate();  // Leaderboard screen replaced ours
+            } else if (ch == 'W') { // Show worm closet (only capital W to avoid collision with typing)
+                profile_frame = false;
                 showWormCloset();
+                renderer.invalidate();  // Closet screen replaced ours
             }
-        } else if (ch == 'W') { // Show worm closet (only capital W to avoid collision with typing)
-            showWormCloset();
-        }
         
-        // Update ball position and animation based on typing progress
-        if (target.length() > 0) {
-            ball_position = (double)typed.length() / target.length();
-            ball_frame++;  // Advance animation frame
+            dirty_from = std::min(dirty_from, typing.typed.length());
+            if (!streamed && typing.typed.length() == target.length()) break;  // Complete - leave later keys for the result screen
         }
-        
-        // Clear and redraw screen
-        clear();                   // Clear entire screen
-        
-        // Get terminal dimensions
-        int max_x, max_y;
-        getmaxyx(stdscr, max_y, max_x);
-        
-        // Calculate window dimensions and position
-        int window_width = max_x - 4;  // Leave 2 chars padding on each side
-        int window_height = max_y - 4; // Leave 2 lines padding top/bottom
-        int win_start_x = 2;
-        int win_start_y = 1;
-        
-        // Draw window outline using box drawing characters
-        // Top border
-        mvaddch(win_start_y, win_start_x, ACS_ULCORNER);
-        for (int x = win_start_x + 1; x < win_start_x + window_width - 1; x++) {
-            mvaddch(win_start_y, x, ACS_HLINE);
-        }
-        mvaddch(win_start_y, win_start_x + window_width - 1, ACS_URCORNER);
-        
-        // Side borders
-        for (int y = win_start_y + 1; y < win_start_y + window_height - 1; y++) {
-            mvaddch(y, win_start_x, ACS_VLINE);
-            mvaddch(y, win_start_x + window_width - 1, ACS_VLINE);
-        }
-        
-        // Bottom border
-        mvaddch(win_start_y + window_height - 1, win_start_x, ACS_LLCORNER);
-        for (int x = win_start_x + 1; x < win_start_x + window_width - 1; x++) {
-            mvaddch(win_start_y + window_height - 1, x, ACS_HLINE);
+        if (quit) {
+            // Leaving is how endless practice ends, so it is recorded; other unfinished tests are not
+            if (streamed && timedSeconds == 0 && typing.typedCount() > 0) {
+                recorderFinish(testRecorder, text.streamWords, renderer.layout.width);
+            }
+            break;
         }
-        mvaddch(win_start_y + window_height - 1, win_start_x + window_width - 1, ACS_LRCORNER);
-        
-        // Display title inside the window
-        std::string title = "W4RMUP W0RM'S T3RMINAL TYP3R";
-        int title_x = win_start_x + (window_width - title.length()) / 2;
-        mvprintw(win_start_y + 1, title_x, "%s", title.c_str());
-        
-        // Display instructions at bottom of window
-        std::string instruct = "ENTER: restart | ESC: quit | L: leaderboard | W: worm closet";
-        int instruct_x = win_start_x + (window_width - instruct.length()) / 2;
-        mvprintw(win_start_y + window_height - 3, instruct_x, "%s", instruct.c_str());
         
-        // Display separator line
-        for (int x = win_start_x + 2; x < win_start_x + window_width - 2; x++) {
-            mvaddch(win_start_y + 2, x, ACS_HLINE);
+        // Streamed text: scroll typed rows away and generate the ones coming up
+        if (streamed && !renderer.layout_stale && streamAdvance(text.stream, target, typing, renderer.layout)) {
+            renderer.resetText();
         }
         
-        // Display prompt inside window (centered)
-        std::string prompt = "Type this:";
-        int prompt_x = win_start_x + (window_width - prompt.length()) / 2;
-        mvprintw(win_start_y + 4, prompt_x, "%s", prompt.c_str());
-        
-        // Draw bouncy worm animation above the text
-        int worm_y = win_start_y + 5;
-        int worm_start_x = win_start_x + 2;
-        int worm_width = window_width - 4;
-        drawBouncyWorm(worm_y, worm_start_x, worm_width, ball_position, ball_frame);
-        
-        // Display target text with word-wrapping and color coding inside window
-        int current_row = win_start_y + 7;
-        int start_col = win_start_x + 2;  // Inside window margin
-        int current_col = start_col;
-        int max_text_width = window_width - 4;  // Text area width inside window
-        
-        // Split text into words for proper wrapping
-        std::vector<std::string> words_in_target;
-        std::string current_word = "";
-        for (size_t i = 0; i < target.length(); i++) {
-            if (target[i] == ' ') {
-                if (!current_word.empty()) {
-                    words_in_target.push_back(current_word);
-                    current_word = "";
-                }
-                words_in_target.push_back(" ");  // Add space as separate element
-            } else {
-                current_word += target[i];
+        // Update ball position from typing progress (the clock in a timed test, the cursor
+        // column in an endless one); the wiggle advances on the tick
+        double elapsed_now = typingElapsed(typing, monotonicNanos());
+        bool timeUp = timedSeconds > 0 && elapsed_now >= timedSeconds;
+        if (timedSeconds > 0) {
+            ball_position = std::min(1.0, elapsed_now / timedSeconds);
+        } else if (streamed) {
+            if (!renderer.layout_stale && typing.typed.length() < renderer.layout.pos.size()) {
+                ball_position = (double)renderer.layout.pos[typing.typed.length()].col / renderer.layout.width;
             }
+        } else if (target.length() > 0) {
+            ball_position = (double)typing.typed.length() / target.length();
         }
-        if (!current_word.empty()) {
-            words_in_target.push_back(current_word);
-        }
-        
-        // Render words with proper wrapping and track cursor position
-        size_t char_pos = 0;  // Track position in original target string
-        int cursor_row = current_row;   // Track where cursor should be
-        int cursor_col = current_col;   // Track where cursor should be
-        int last_text_row = current_row;  // Track the last row where text was rendered
+        if (tick) ball_frame++;
         
-        for (size_t word_idx = 0; word_idx < words_in_target.size(); word_idx++) {
-            const std::string& word = words_in_target[word_idx];
-            
-            // Check if word fits on current line
-            if (word != " " && current_col + word.length() > win_start_x + max_text_width) {
-                // Move to next line if word doesn't fit
-                current_row++;
-                current_col = start_col;
-            }
-            
-            // Render each character in the word
-            for (size_t char_idx = 0; char_idx < word.length(); char_idx++) {
-                int color = 3;  // Default to white (untyped)
-                
-                if (char_pos < typed.length()) {  // If user has typed this far
-                    if (typed[char_pos] == target[char_pos]) {
-                        color = 1;  // Custom orange-red color for correct characters
-                    } else {
-                        color = 2;  // Red for incorrect characters
-                    }
-                }
-                
-                // Update cursor position - should be at the next character to type
-                if (char_pos == typed.length()) {
-                    cursor_row = current_row;
-                    cursor_col = current_col;
-                }
-                
-                if (has_colors()) {
-                    attron(COLOR_PAIR(color));
-                }
-                mvaddch(current_row, current_col, word[char_idx]);
-                if (has_colors()) {
-                    attroff(COLOR_PAIR(color));
-                }
+        // Calculate live statistics (only once typing has begun)
+        char statsText[100] = "";
+        if (typing.started && typing.typedCount() > 0) {
+            double elapsed = elapsed_now;  // Time elapsed
+            if (elapsed > 0) {     // Avoid division by zero
+                double wpm, accuracy;
+                computeTypingStats(typing.correct, typing.typedCount(), elapsed, wpm, accuracy);
                 
-                current_col++;
-                char_pos++;
-                last_text_row = current_row;  // Keep track of the last row with text
+                snprintf(statsText, sizeof(statsText), "WPM: %.1f | Accuracy: %.1f%% | Time: %.1fs", 
+                         wpm, accuracy, elapsed);
             }
         }
         
-        // Calculate dynamic position for stats - always 2 rows below the last text line
-        int stats_start_y = last_text_row + 2;
-        
-        // Display progress counter inside window (dynamically positioned and centered)
-        std::string progressText = "Progress: " + std::to_string(typed.length()) + "/" + std::to_string(target.length());
-        int progress_x = win_start_x + (window_width - progressText.length()) / 2;
-        mvprintw(stats_start_y, progress_x, "%s", progressText.c_str());
+        int64_t draw_start = 0;
+        if (profile_frame) {
+            draw_start = monotonicNanos();
+            frameProfiler->current_ns[STAGE_UPDATE] = draw_start - frameProfiler->frame_start_ns -
+                                                      frameProfiler->current_ns[STAGE_INPUT];
+        }
         
-        // Calculate and display live statistics inside window (dynamically positioned)
-        if (started && typed.length() > 0) {    // Only if typing has begun
-            double elapsed = difftime(time(nullptr), start_time);  // Time elapsed
-            if (elapsed > 0) {     // Avoid division by zero
-                int correct = 0;   // Count correct characters
-                for (size_t i = 0; i < typed.length() && i < target.length(); i++) {
-                    if (typed[i] == target[i]) correct++;
-                }
-                
-                // WPM = (correct chars / 5) / (time in minutes)
-                double raw_wpm = (correct / 5.0) / (elapsed / 60.0);
-                // Accuracy = (correct chars / total typed) * 100
-                double accuracy = (correct * 100.0) / typed.length();
-                // Apply accuracy penalty to prevent space-mashing exploit
-                // Below 50% accuracy, severely penalize WPM
-                double accuracy_multiplier = 1.0;
-                if (accuracy < 50.0) {
-                    accuracy_multiplier = accuracy / 50.0;  // Linear penalty below 50%
-                }
-                double wpm = raw_wpm * accuracy_multiplier;
-                
-                // Center the WPM stats line
-                char statsBuffer[100];
-                snprintf(statsBuffer, sizeof(statsBuffer), "WPM: %.1f | Accuracy: %.1f%% | Time: %.0fs", 
-                         wpm, accuracy, elapsed);
-                std::string statsText = std::string(statsBuffer);
-                int stats_x = win_start_x + (window_width - statsText.length()) / 2;
-                mvprintw(stats_start_y + 1, stats_x, "%s", statsText.c_str());
-            }
+        // A streamed test has no fixed length to count towards
+        char progressText[64];
+        if (timedSeconds > 0) {
+            snprintf(progressText, sizeof(progressText), "Time left: %.0fs",
+                     std::ceil(std::max(0.0, timedSeconds - elapsed_now)));
+        } else if (streamed) {
+            snprintf(progressText, sizeof(progressText), "Typed: %zu", typing.typedCount());
         }
         
+        // Repaint only what changed since the previous frame
+        renderTypingScreen(renderer, target, typing.typed, dirty_from, ball_position, ball_frame, statsText,
+                           streamed ? progressText : nullptr);
+        int win_start_x = renderer.win_start_x;
+        int win_start_y = renderer.win_start_y;
+        int window_width = renderer.window_width;
+        
         // Show completion message inside window
-        if (typed.length() == target.length()) {
-            // Calculate final stats
-            double elapsed = difftime(time(nullptr), start_time);
-            int correct = 0;
-            for (size_t i = 0; i < typed.length() && i < target.length(); i++) {
-                if (typed[i] == target[i]) correct++;
+        if (timeUp || (!streamed && typing.typed.length() == target.length())) {
+            // Calculate final stats from the running counters, timed to the final keystroke
+            // (or over the whole length of a timed test)
+            double elapsed = timeUp ? (double)timedSeconds : typingDuration(typing);
+            double final_wpm, final_accuracy;
+            computeTypingStats(typing.correct, typing.typedCount(), elapsed, final_wpm, final_accuracy);
+            waitForScoreStore();  // Everything below records the result
+            // Flush the recording only now, off the input path
+            if (streamed) {
+                recorderFinish(testRecorder, text.streamWords, renderer.layout.width);
+            } else {
+                recorderFinish(testRecorder, target);
             }
-            double raw_final_wpm = (correct / 5.0) / (elapsed / 60.0);
-            double final_accuracy = (correct * 100.0) / typed.length();
-            // Apply same accuracy penalty to final WPM calculation
-            double final_accuracy_multiplier = 1.0;
-            if (final_accuracy < 50.0) {
-                final_accuracy_multiplier = final_accuracy / 50.0;  // Linear penalty below 50%
+            nodelay(stdscr, FALSE);  // Result screen and popups read keys blocking
+            
+            // Append to the score log and refresh the top 10 (practice texts are not ranked)
+            if (!weakKeys) {
+                PlayerScore newScore = makePlayerScore(playerName, final_wpm, final_accuracy, elapsed, wordCount,
+                                                       includePunctuation, includeNumbers, wallClockMillis());
+                if (timeUp) newScore.mode = timedModeKey(timedSeconds, includePunctuation, includeNumbers);
+                addScore(scoreStore, newScore);
+                leaderboard = topScores(scoreStore, 10);
             }
-            double final_wpm = raw_final_wpm * final_accuracy_multiplier;
             
-            // Add to leaderboard and save
-            PlayerScore newScore(playerName, final_wpm, final_accuracy, elapsed, wordCount, includePunctuation, includeNumbers);
-            addToLeaderboard(leaderboard, newScore);
-            saveLeaderboard(leaderboard);
+            // Fold this test's keystroke timings into the profile
+            if (currentPlayerData != nullptr) {
+                mergeKeyStats(currentPlayerData->keyStats, testKeyStats);
+                saveKeyStats(keyStatsStore, currentPlayerData->playerName, currentPlayerData->keyStats);
+            }
             
             // Check for achievements
             checkAchievements(final_wpm, final_accuracy, elapsed);
@@ -2745,7 +3241,7 @@ int main(int argc, char* argv[]) {
             
             // Wait for Enter to continue or Q to quit
             while (true) {
-                int complete_ch = getch();
+                int complete_ch = readKey();
                 if (complete_ch == 10 || complete_ch == 13) {
                     break;
                 } else if (complete_ch == 'q' || complete_ch == 'Q') {
@@ -2755,7 +3251,8 @@ int main(int argc, char* argv[]) {
                 }
             }
             
-            // Show leaderboard after completion
+            // Achievements unlocked by this test, then the leaderboard
+            showPendingAchievements();
             int leaderboardResult = showLeaderboard(leaderboard);
             if (leaderboardResult == 2) {
                 // Change name requested
@@ -2781,15 +3278,24 @@ int main(int argc, char* argv[]) {
             break; // Exit typing test loop to return to menu
         }
         
+        if (frameProfiler != nullptr) {
+            if (profile_frame) {
+                frameProfiler->current_ns[STAGE_DRAW] = monotonicNanos() - draw_start - frameProfiler->current_ns[STAGE_LAYOUT];
+            }
+            drawProfileOverlay(*frameProfiler);
+        }
+        
         // Position cursor at the current typing position (AFTER all display calls)
-        if (typed.length() < target.length()) {
-            curs_set(1);  // Show cursor when typing
-            move(cursor_row, cursor_col);
+        placeTypingCursor(renderer, target, typing.typed);
+        
+        if (profile_frame) {
+            int64_t refresh_start = monotonicNanos();
+            presentFrame();
+            frameProfiler->current_ns[STAGE_REFRESH] = monotonicNanos() - refresh_start;
+            profileEndFrame(*frameProfiler);
         } else {
-            curs_set(0);  // Hide cursor when not typing
+            presentFrame();        // Update screen with all changes
         }
-        
-        refresh();             // Update screen with all changes
         }  // End of typing test game loop
     }  // End of main menu loop
     
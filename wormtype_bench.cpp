@@ -0,0 +1,299 @@
+// Headless benchmark harness for the typing tester's hot paths.
+// Drives text generation, wrap layout, scoring, the leaderboard file, the score log and the
+// profiler histogram with synthetic inputs and reports time and heap allocations per operation.
+//
+// Usage: wormtype_bench [filter]   (only runs benchmarks whose name contains filter)
+#include "wormtype_core.h"
+
+#include <atomic>      // Allocation counter
+#include <chrono>      // Timing
+#include <cstdio>      // printf
+#include <cstdlib>     // malloc/free
+#include <new>         // std::bad_alloc
+#include <string>      // String class
+#include <unistd.h>    // For getpid() and unlink()
+
+// Count every heap allocation made by the process
+static std::atomic<unsigned long long> allocationCount(0);
+
+void* operator new(size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    void* p = malloc(size == 0 ? 1 : size);
+    if (p == nullptr) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    free(p);
+}
+
+// Result of running one benchmark body repeatedly
+struct BenchResult {
+    double nsPerOp;
+    double allocsPerOp;
+};
+
+// Only benchmarks whose name contains this are run
+static std::string benchFilter;
+
+// Run body until it has taken at least minSeconds (and at least minIters times), then report.
+// setup runs before every iteration outside the timed and counted region.
+template <typename Setup, typename Body>
+void runBench(const std::string& name, int minIters, double minSeconds, Setup setup, Body body) {
+    if (!benchFilter.empty() && name.find(benchFilter) == std::string::npos) return;
+
+    double totalNs = 0.0;
+    unsigned long long totalAllocs = 0;
+    long iterations = 0;
+    while (iterations < minIters || totalNs < minSeconds * 1e9) {
+        setup();
+        unsigned long long allocsBefore = allocationCount.load(std::memory_order_relaxed);
+        int64_t start = monotonicNanos();
+        body();
+        totalNs += monotonicNanos() - start;
+        totalAllocs += allocationCount.load(std::memory_order_relaxed) - allocsBefore;
+        iterations++;
+    }
+
+    BenchResult result;
+    result.nsPerOp = totalNs / iterations;
+    result.allocsPerOp = (double)totalAllocs / iterations;
+    printf("%-40s %14.1f ns/op %12.2f allocs/op %8ld iters\n",
+           name.c_str(), result.nsPerOp, result.allocsPerOp, iterations);
+    fflush(stdout);
+}
+
+static void noSetup() {}
+
+// Keep the optimizer from discarding benchmark results
+static volatile size_t benchSink = 0;
+
+// Text generation for a word count, reusing the output buffer like a restart does
+static void benchGenerate(int words) {
+    WordPool pool = selectWordPool(true, true);
+    Pcg32 rng(42);
+    std::string target;
+    generateTargetText(target, pool, words, rng);  // Warm the buffer
+    runBench("generate/" + std::to_string(words) + " words", 10, 0.2, noSetup, [&]() {
+        generateTargetText(target, pool, words, rng);
+        benchSink += target.length();
+    });
+}
+
+// Synthetic key statistics with every bigram timed
+static const KeyStats& benchKeyStats() {
+    static KeyStats stats;
+    clearKeyStats(stats);
+    Pcg32 rng(5);
+    for (int i = 0; i < kKeyStatBigrams; i++) {
+        stats.bigrams[i].presses = stats.bigrams[i].timed = 10;
+        stats.bigrams[i].errors = rng.bounded(3);
+        stats.bigrams[i].total_us = 10 * (100000 + rng.bounded(200000));
+    }
+    return stats;
+}
+
+// Weighing a pool for weak-key practice, done once per session
+static void benchWeakKeySampler() {
+    WordPool pool = selectWordPool(false, false);
+    const KeyStats& stats = benchKeyStats();
+    WeakKeySampler sampler;
+    runBench("weak-key sampler/" + std::to_string(pool.count) + " words", 10, 0.2, noSetup, [&]() {
+        prepareWeakKeySampler(sampler, pool, stats);
+        benchSink += sampler.table.alias.size();
+    });
+}
+
+// Weak-key practice text drawn through a prepared alias table
+static void benchWeightedGenerate(int words) {
+    WordPool pool = selectWordPool(false, false);
+    WeakKeySampler sampler;
+    prepareWeakKeySampler(sampler, pool, benchKeyStats());
+    Pcg32 rng(42);
+    std::string target;
+    generateWeightedText(target, pool, sampler, words, rng);  // Warm the buffer
+    runBench("generate weak-key/" + std::to_string(words) + " words", 10, 0.2, noSetup, [&]() {
+        generateWeightedText(target, pool, sampler, words, rng);
+        benchSink += target.length();
+    });
+}
+
+// Wrap layout of a generated text at a typical terminal width
+static void benchLayout(int words) {
+    WordPool pool = selectWordPool(false, false);
+    Pcg32 rng(7);
+    std::string target;
+    generateTargetText(target, pool, words, rng);
+    TextLayout layout;
+    buildTextLayout(layout, target, 110);  // Warm the position array
+    runBench("layout/" + std::to_string(words) + " words", 10, 0.2, noSetup, [&]() {
+        buildTextLayout(layout, target, 110);
+        benchSink += layout.rows;
+    });
+}
+
+// Scoring: type a whole text through the state machine, with a typo and a word jump
+// every few words. Reported per whole test.
+static void benchScoring(int words) {
+    WordPool pool = selectWordPool(false, false);
+    Pcg32 rng(11);
+    std::string target;
+    generateTargetText(target, pool, words, rng);
+
+    // Build the keystroke script once
+    std::vector<int> keys;
+    keys.reserve(target.length() * 2);
+    int word = 0;
+    for (size_t i = 0; i < target.length(); i++) {
+        if (target[i] == ' ') {
+            word++;
+        } else if (word % 7 == 3 && (i == 0 || target[i - 1] == ' ')) {
+            keys.push_back(' ');  // Jump over this word
+            while (i < target.length() && target[i] != ' ') i++;
+            word++;
+            continue;
+        } else if (word % 5 == 1 && (i == 0 || target[i - 1] == ' ')) {
+            keys.push_back('#');  // Typo then backspace
+            keys.push_back(kKeyBackspace);
+        }
+        keys.push_back(target[i]);
+    }
+
+    TypingState state;
+    runBench("scoring/" + std::to_string(words) + " words (per test)", 3, 0.2,
+             [&]() { resetTypingState(state, target.length()); }, [&]() {
+        int64_t now = 0;
+        for (size_t k = 0; k < keys.size(); k++) {
+            applyTypingKey(state, target, keys[k], now);
+            now += 150000000;
+        }
+        benchSink += state.correct;
+    });
+
+    // Same script with the per-keystroke key statistics, as in the typing loop
+    static KeyStats keyStats;
+    KeyTimer timer;
+    runBench("scoring+key stats/" + std::to_string(words) + " words (per test)", 3, 0.2,
+             [&]() { resetTypingState(state, target.length()); clearKeyStats(keyStats); timer = KeyTimer(); }, [&]() {
+        int64_t now = 0;
+        for (size_t k = 0; k < keys.size(); k++) {
+            size_t before = state.typedCount();
+            applyTypingKey(state, target, keys[k], now);
+            keyTimerUpdate(timer, keyStats, state, target, before, now);
+            now += 150000000;
+        }
+        benchSink += state.correct + keyStats.keys[keyStatIndex('e')].presses;
+    });
+}
+
+// 01/02/2025 10:30 UTC, the date of every synthetic score
+static const int64_t kBenchTimestampMs = 1735813800000LL;
+
+// Synthetic leaderboard with n rows
+static std::vector<PlayerScore> makeLeaderboard(int rows) {
+    std::vector<PlayerScore> scores;
+    scores.reserve(rows);
+    Pcg32 rng(99);
+    for (int i = 0; i < rows; i++) {
+        std::string name = "PLAYER" + std::to_string(rng.bounded(500));
+        double wpm = 20.0 + rng.bounded(10000) / 100.0;
+        double accuracy = 80.0 + rng.bounded(2000) / 100.0;
+        scores.push_back(makePlayerScore(name, wpm, accuracy, 10.0 + rng.bounded(600) / 10.0,
+                                         25, rng.bounded(2) == 1, rng.bounded(2) == 1, kBenchTimestampMs));
+    }
+    return scores;
+}
+
+// Leaderboard save, load and insert at a given history size
+static void benchLeaderboard(int rows) {
+    std::string label = std::to_string(rows) + " rows";
+    std::string path = "/tmp/wormtype_bench_" + std::to_string(getpid()) + ".txt";
+    std::vector<PlayerScore> scores = makeLeaderboard(rows);
+    int iters = rows >= 100000 ? 1 : 5;
+
+    runBench("leaderboard save/" + label, iters, 0.1, noSetup, [&]() {
+        saveLeaderboard(scores, path);
+    });
+    runBench("leaderboard load/" + label, iters, 0.1, noSetup, [&]() {
+        benchSink += loadLeaderboard(path).size();
+    });
+
+    std::vector<PlayerScore> working;
+    PlayerScore newScore = makePlayerScore("BENCH", 75.0, 97.0, 20.0, 25, false, false, kBenchTimestampMs);
+    runBench("leaderboard insert/" + label, iters, 0.1, [&]() { working = scores; }, [&]() {
+        addToLeaderboard(working, newScore);
+        benchSink += working.size();
+    });
+    unlink(path.c_str());
+}
+
+// Score log open (read + rank) and append at a given history size
+static void benchScoreLog(int rows) {
+    std::string label = std::to_string(rows) + " rows";
+    std::string base = "/tmp/wormtype_bench_" + std::to_string(getpid());
+    std::string path = base + ".log";
+    std::string legacyPath = base + ".txt";
+    int iters = rows >= 100000 ? 1 : 5;
+
+    // Build the log through the legacy import
+    saveLeaderboard(makeLeaderboard(rows), legacyPath);
+    unlink(path.c_str());
+    ScoreStore store;
+    openScoreStore(store, path, legacyPath);
+    unlink(legacyPath.c_str());
+
+    runBench("score log open/" + label, iters, 0.1, noSetup, [&]() {
+        openScoreStore(store, path, legacyPath);
+        benchSink += store.scores.size();
+    });
+
+    runBench("score log top 10/" + label, 20, 0.1, noSetup, [&]() {
+        benchSink += topScores(store, 10).size();
+    });
+    runBench("score log top 1000/" + label, iters, 0.1, noSetup, [&]() {
+        benchSink += topScores(store, 1000).size();
+    });
+
+    PlayerScore newScore = makePlayerScore("BENCH", 75.0, 97.0, 20.0, 25, false, false, kBenchTimestampMs);
+    runBench("score log append/" + label, 20, 0.1, noSetup, [&]() {
+        addScore(store, newScore);
+        benchSink += store.scores.size();
+    });
+    unlink(path.c_str());
+}
+
+// Profiler histogram: the cost --profile adds per frame
+static void benchLatencyHistogram() {
+    LatencyHistogram hist;
+    Pcg32 rng(7);
+    std::vector<int64_t> samples(1000);
+    for (size_t i = 0; i < samples.size(); i++) samples[i] = 20000 + rng.bounded(2000000);
+
+    runBench("latency record/1000 samples", 10, 0.1, noSetup, [&]() {
+        for (size_t i = 0; i < samples.size(); i++) recordLatency(hist, samples[i]);
+    });
+    runBench("latency p99", 10, 0.1, noSetup, [&]() {
+        benchSink += (size_t)latencyPercentile(hist, 0.99);
+    });
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1) benchFilter = argv[1];
+
+    const int wordCounts[] = { 10, 1000, 100000 };
+    for (int words : wordCounts) benchGenerate(words);
+    for (int words : wordCounts) benchWeightedGenerate(words);
+    benchWeakKeySampler();
+    for (int words : wordCounts) benchLayout(words);
+    for (int words : wordCounts) benchScoring(words);
+
+    const int rowCounts[] = { 1000, 100000, 1000000 };
+    for (int rows : rowCounts) benchLeaderboard(rows);
+    for (int rows : rowCounts) benchScoreLog(rows);
+    benchLatencyHistogram();
+    return 0;
+}
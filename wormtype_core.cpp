@@ -0,0 +1,2002 @@
+#include "wormtype_core.h"
+
+#include <fstream>     // File I/O
+#include <iterator>    // For reading whole files
+#include <cstdio>      // For rename()
+#include <algorithm>   // For sorting
+#include <chrono>      // Monotonic keystroke timing and score timestamps
+#include <ctime>       // For localtime_r(), mktime() and strftime()
+#include <cctype>      // For toupper() and character classes
+#include <cstring>     // For memchr(), memcpy() and strnlen()
+#include <fcntl.h>     // For open()
+#include <sys/mman.h>  // For mmap() of word lists
+#include <sys/stat.h>  // For fstat()
+#include <sys/file.h>  // For flock() on the shared score log
+#include <unistd.h>    // For close(), pread() and ftruncate()
+#include <cerrno>      // EINTR from the worker's wait
+#include <thread>      // Persistence worker
+#include <signal.h>    // For pthread_sigmask() in the worker
+#include <sys/eventfd.h>  // Wakes the persistence worker
+
+// Queued file writes, run by the persistence worker (defined with the score log below)
+enum PersistKind {
+    PERSIST_REPLACE,       // Swap the whole file for data through a temp file
+    PERSIST_APPEND,        // Append data
+    PERSIST_SCORE_RESET,   // The score log holds `records` records the UI has seen; non-empty data replaces it first
+    PERSIST_SCORE_APPEND   // Append one score record, picking up other processes' records first
+};
+
+static void persist(PersistKind kind, const std::string& path, std::string& data, size_t records = 0);
+
+// Next score another process appended to the log, handed over by the worker
+static bool takeForeignScore(PlayerScore& score);
+
+// Write data to a temp file and rename it over path
+static void replaceFile(const std::string& path, const std::string& data);
+
+std::string toUpperCase(const std::string& str) {
+    std::string result = str;
+    std::transform(result.begin(), result.end(), result.begin(), ::toupper);
+    return result;
+}
+
+// ---------------------------------------------------------------------------
+// Scores
+// ---------------------------------------------------------------------------
+
+const std::string& PlayerScore::name() const {
+    return nameRegistry.names[playerId];
+}
+
+PlayerScore makePlayerScore(const std::string& name, double wpm, double accuracy, double time,
+                            int wordCount, bool punctuation, bool numbers, int64_t timestampMs) {
+    PlayerScore score;
+    score.timestampMs = timestampMs;
+    score.playerId = internName(nameRegistry, name, 0);
+    score.wpm = (float)wpm;
+    score.accuracy = (float)accuracy;
+    score.time = (float)time;
+    score.mode = scoreModeKey(wordCount, punctuation, numbers);
+    return score;
+}
+
+int64_t wallClockMillis() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+std::string formatScoreDate(int64_t timestampMs) {
+    if (timestampMs == 0) return "Unknown";
+    time_t seconds = (time_t)(timestampMs / 1000);
+    struct tm local;
+    char buffer[32];
+    if (localtime_r(&seconds, &local) == nullptr ||
+        strftime(buffer, sizeof(buffer), "%m/%d/%Y %H:%M", &local) == 0) {
+        return "Unknown";
+    }
+    return buffer;
+}
+
+int64_t parseScoreDate(const std::string& date) {
+    struct tm local;
+    memset(&local, 0, sizeof(local));
+    int seconds = 0;
+    if (sscanf(date.c_str(), "%d/%d/%d %d:%d", &local.tm_mon, &local.tm_mday, &local.tm_year,
+               &local.tm_hour, &local.tm_min) != 5 &&
+        sscanf(date.c_str(), "%d-%d-%d %d:%d:%d", &local.tm_year, &local.tm_mon, &local.tm_mday,
+               &local.tm_hour, &local.tm_min, &seconds) < 5) {
+        return 0;
+    }
+    local.tm_mon -= 1;
+    local.tm_year -= 1900;
+    local.tm_sec = seconds;
+    local.tm_isdst = -1;  // Let mktime work out daylight saving
+    time_t t = mktime(&local);
+    return t == (time_t)-1 ? 0 : (int64_t)t * 1000;
+}
+
+// ---------------------------------------------------------------------------
+// Leaderboard file
+// ---------------------------------------------------------------------------
+
+std::vector<PlayerScore> loadLeaderboard(const std::string& path) {
+    std::vector<PlayerScore> leaderboard;
+    std::ifstream file(path.c_str());
+    
+    if (file.is_open()) {
+        std::string line;
+        while (std::getline(file, line)) {
+            size_t pos1 = line.find('|');
+            size_t pos2 = line.find('|', pos1 + 1);
+            size_t pos3 = line.find('|', pos2 + 1);
+            size_t pos4 = line.find('|', pos3 + 1);
+            size_t pos5 = line.find('|', pos4 + 1);
+            size_t pos6 = line.find('|', pos5 + 1);
+            size_t pos7 = line.find('|', pos6 + 1);
+            
+            if (pos1 != std::string::npos && pos2 != std::string::npos && pos3 != std::string::npos) {
+                std::string name = toUpperCase(line.substr(0, pos1));
+                double wpm = std::stod(line.substr(pos1 + 1, pos2 - pos1 - 1));
+                double accuracy = std::stod(line.substr(pos2 + 1, pos3 - pos2 - 1));
+                
+                std::string date = "";
+                int wordCount = 15;  // Default for backward compatibility
+                bool hasPunctuation = false;  // Default for backward compatibility
+                bool hasNumbers = false;  // Default for backward compatibility
+                double time = 0.0;
+                
+                if (pos4 != std::string::npos) {
+                    time = std::stod(line.substr(pos3 + 1, pos4 - pos3 - 1));
+                } else {
+                    // Very old format with only 3 fields (name|wpm|accuracy)
+                    time = std::stod(line.substr(pos3 + 1));
+                    date = "Unknown";
+                    leaderboard.push_back(makePlayerScore(name, wpm, accuracy, time, wordCount, hasPunctuation, hasNumbers,
+                                                      parseScoreDate(date)));
+                    continue;
+                }
+                
+                if (pos7 != std::string::npos) {
+                    // Newest format with all fields
+                    try {
+                        date = line.substr(pos4 + 1, pos5 - pos4 - 1);
+                        wordCount = std::stoi(line.substr(pos5 + 1, pos6 - pos5 - 1));
+                        hasPunctuation = (std::stoi(line.substr(pos6 + 1, pos7 - pos6 - 1)) == 1);
+                        hasNumbers = (std::stoi(line.substr(pos7 + 1)) == 1);
+                    } catch (const std::exception&) {
+                        // Fall back to defaults if parsing fails
+                        date = "Unknown";
+                        wordCount = 15;
+                        hasPunctuation = false;
+                        hasNumbers = false;
+                    }
+                } else if (pos5 != std::string::npos) {
+                    // Format with word count but no punctuation/numbers
+                    try {
+                        date = line.substr(pos4 + 1, pos5 - pos4 - 1);
+                        wordCount = std::stoi(line.substr(pos5 + 1));
+                    } catch (const std::exception&) {
+                        // Fall back to defaults if parsing fails
+                        date = "Unknown";
+                        wordCount = 15;
+                    }
+                } else {
+                    // Old format without word count
+                    date = line.substr(pos4 + 1);
+                    if (date.empty()) {
+                        date = "Unknown";
+                    }
+                }
+                
+                leaderboard.push_back(makePlayerScore(name, wpm, accuracy, time, wordCount, hasPunctuation, hasNumbers,
+                                                      parseScoreDate(date)));
+            }
+        }
+        file.close();
+    }
+    
+    return leaderboard;
+}
+
+void saveLeaderboard(const std::vector<PlayerScore>& leaderboard, const std::string& path) {
+    std::ofstream file(path.c_str());
+    
+    if (file.is_open()) {
+        for (size_t i = 0; i < leaderboard.size(); i++) {
+            const PlayerScore& s = leaderboard[i];
+            file << s.name() << "|" << s.wpm << "|" << s.accuracy << "|" << s.time << "|" << formatScoreDate(s.timestampMs) << "|"
+                 << s.wordCount() << "|" << (s.hasPunctuation() ? 1 : 0) << "|" << (s.hasNumbers() ? 1 : 0) << std::endl;
+        }
+        file.close();
+    }
+}
+
+bool compareScores(const PlayerScore& a, const PlayerScore& b) {
+    if (a.wpm != b.wpm) return a.wpm > b.wpm;
+    return a.accuracy > b.accuracy;
+}
+
+void addToLeaderboard(std::vector<PlayerScore>& leaderboard, const PlayerScore& newScore) {
+    leaderboard.push_back(newScore);
+    
+    // Order just the top 10 by WPM (descending), then by accuracy (descending) if WPM is same
+    size_t keep = std::min(leaderboard.size(), (size_t)10);
+    std::partial_sort(leaderboard.begin(), leaderboard.begin() + keep, leaderboard.end(), compareScores);
+    
+    // Keep only top 10
+    if (leaderboard.size() > 10) {
+        leaderboard.resize(10);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Word corpus and text generation
+// ---------------------------------------------------------------------------
+
+// Built-in word corpus.
+// Stored as compile-time tables of (pointer, length) views so starting or
+// restarting a test never builds or copies a word list.
+#define CORPUS_WORD(w) { w, sizeof(w) - 1 }
+
+// Mixed pool laid out as [punctuation][base][numbers] so every combination
+// of the punctuation/numbers options is one contiguous range of the table
+static constexpr WordView kCorpusWords[] = {
+    // Words with punctuation for punctuation mode
+    CORPUS_WORD("hello,"), CORPUS_WORD("world!"), CORPUS_WORD("it's"), CORPUS_WORD("don't"), CORPUS_WORD("can't"),
+    CORPUS_WORD("won't"), CORPUS_WORD("we're"), CORPUS_WORD("they're"), CORPUS_WORD("you'll"), CORPUS_WORD("I'll"),
+    CORPUS_WORD("she'll"), CORPUS_WORD("he'll"), CORPUS_WORD("we'll"), CORPUS_WORD("they'll"), CORPUS_WORD("isn't"),
+    CORPUS_WORD("aren't"), CORPUS_WORD("wasn't"), CORPUS_WORD("weren't"), CORPUS_WORD("hasn't"), CORPUS_WORD("haven't"),
+    CORPUS_WORD("doesn't"), CORPUS_WORD("didn't"), CORPUS_WORD("shouldn't"), CORPUS_WORD("wouldn't"), CORPUS_WORD("couldn't"),
+    CORPUS_WORD("mustn't"), CORPUS_WORD("needn't"), CORPUS_WORD("shan't"), CORPUS_WORD("hello."), CORPUS_WORD("goodbye!"),
+    CORPUS_WORD("really?"), CORPUS_WORD("amazing!"), CORPUS_WORD("yes,"), CORPUS_WORD("no,"), CORPUS_WORD("wait..."),
+    CORPUS_WORD("stop!"), CORPUS_WORD("go!"), CORPUS_WORD("help!"), CORPUS_WORD("wow!"), CORPUS_WORD("oh!"),
+    // Base words
+    CORPUS_WORD("the"), CORPUS_WORD("quick"), CORPUS_WORD("brown"), CORPUS_WORD("fox"), CORPUS_WORD("jumps"), CORPUS_WORD("over"),
+    CORPUS_WORD("lazy"), CORPUS_WORD("dog"), CORPUS_WORD("hello"), CORPUS_WORD("world"), CORPUS_WORD("typing"), CORPUS_WORD("test"),
+    CORPUS_WORD("program"), CORPUS_WORD("simple"), CORPUS_WORD("fast"), CORPUS_WORD("computer"), CORPUS_WORD("keyboard"), CORPUS_WORD("screen"),
+    CORPUS_WORD("mouse"), CORPUS_WORD("software"), CORPUS_WORD("hardware"), CORPUS_WORD("internet"), CORPUS_WORD("website"), CORPUS_WORD("email"),
+    CORPUS_WORD("password"), CORPUS_WORD("username"), CORPUS_WORD("login"), CORPUS_WORD("download"), CORPUS_WORD("upload"), CORPUS_WORD("file"),
+    CORPUS_WORD("folder"), CORPUS_WORD("document"), CORPUS_WORD("window"), CORPUS_WORD("button"), CORPUS_WORD("click"), CORPUS_WORD("double"),
+    CORPUS_WORD("right"), CORPUS_WORD("left"), CORPUS_WORD("center"), CORPUS_WORD("top"), CORPUS_WORD("bottom"), CORPUS_WORD("middle"),
+    CORPUS_WORD("side"), CORPUS_WORD("front"), CORPUS_WORD("back"), CORPUS_WORD("forward"), CORPUS_WORD("backward"), CORPUS_WORD("up"),
+    CORPUS_WORD("down"), CORPUS_WORD("north"), CORPUS_WORD("south"), CORPUS_WORD("east"), CORPUS_WORD("west"), CORPUS_WORD("morning"),
+    CORPUS_WORD("afternoon"), CORPUS_WORD("evening"), CORPUS_WORD("night"), CORPUS_WORD("today"), CORPUS_WORD("tomorrow"), CORPUS_WORD("yesterday"),
+    CORPUS_WORD("week"), CORPUS_WORD("month"), CORPUS_WORD("year"), CORPUS_WORD("time"), CORPUS_WORD("clock"), CORPUS_WORD("watch"),
+    CORPUS_WORD("minute"), CORPUS_WORD("second"), CORPUS_WORD("hour"), CORPUS_WORD("schedule"), CORPUS_WORD("appointment"), CORPUS_WORD("meeting"),
+    CORPUS_WORD("conference"), CORPUS_WORD("presentation"), CORPUS_WORD("project"), CORPUS_WORD("task"), CORPUS_WORD("work"), CORPUS_WORD("job"),
+    CORPUS_WORD("career"), CORPUS_WORD("business"), CORPUS_WORD("company"), CORPUS_WORD("office"), CORPUS_WORD("desk"), CORPUS_WORD("chair"),
+    CORPUS_WORD("table"), CORPUS_WORD("phone"), CORPUS_WORD("mobile"), CORPUS_WORD("tablet"), CORPUS_WORD("laptop"), CORPUS_WORD("desktop"),
+    CORPUS_WORD("server"), CORPUS_WORD("network"), CORPUS_WORD("wireless"), CORPUS_WORD("bluetooth"), CORPUS_WORD("cable"), CORPUS_WORD("connection"),
+    CORPUS_WORD("signal"), CORPUS_WORD("data"), CORPUS_WORD("information"), CORPUS_WORD("knowledge"), CORPUS_WORD("learning"), CORPUS_WORD("education"),
+    CORPUS_WORD("school"), CORPUS_WORD("university"), CORPUS_WORD("student"), CORPUS_WORD("teacher"), CORPUS_WORD("book"), CORPUS_WORD("page"),
+    CORPUS_WORD("chapter"), CORPUS_WORD("paragraph"), CORPUS_WORD("sentence"), CORPUS_WORD("word"), CORPUS_WORD("letter"), CORPUS_WORD("number"),
+    CORPUS_WORD("count"), CORPUS_WORD("calculate"), CORPUS_WORD("mathematics"), CORPUS_WORD("science"), CORPUS_WORD("technology"), CORPUS_WORD("innovation"),
+    CORPUS_WORD("development"), CORPUS_WORD("progress"), CORPUS_WORD("improvement"), CORPUS_WORD("solution"), CORPUS_WORD("problem"), CORPUS_WORD("challenge"),
+    CORPUS_WORD("opportunity"),
+    // Words with numbers for numbers mode
+    CORPUS_WORD("123"), CORPUS_WORD("456"), CORPUS_WORD("789"), CORPUS_WORD("101"), CORPUS_WORD("202"), CORPUS_WORD("303"),
+    CORPUS_WORD("404"), CORPUS_WORD("505"), CORPUS_WORD("2024"), CORPUS_WORD("2025"), CORPUS_WORD("1995"), CORPUS_WORD("2000"),
+    CORPUS_WORD("42"), CORPUS_WORD("99"), CORPUS_WORD("100"), CORPUS_WORD("1000"), CORPUS_WORD("test1"), CORPUS_WORD("test2"),
+    CORPUS_WORD("file1"), CORPUS_WORD("file2"), CORPUS_WORD("user1"), CORPUS_WORD("user2"), CORPUS_WORD("admin123"), CORPUS_WORD("pass123"),
+    CORPUS_WORD("v1.0"), CORPUS_WORD("v2.0"), CORPUS_WORD("v3.1"), CORPUS_WORD("v4.2"), CORPUS_WORD("room101"), CORPUS_WORD("room202"),
+    CORPUS_WORD("apt3b"), CORPUS_WORD("unit4a"), CORPUS_WORD("level1"), CORPUS_WORD("level2"), CORPUS_WORD("step1"), CORPUS_WORD("step2"),
+    CORPUS_WORD("page1"), CORPUS_WORD("page2"), CORPUS_WORD("item1"), CORPUS_WORD("item2"),
+};
+
+static constexpr size_t kPunctuationWordCount = 40;
+static constexpr size_t kBaseWordCount = 127;
+static constexpr size_t kNumberWordCount = 40;
+
+// Numbers only mode: only pure numbers and spaces
+static constexpr WordView kPureNumbers[] = {
+    CORPUS_WORD("0"), CORPUS_WORD("1"), CORPUS_WORD("2"), CORPUS_WORD("3"), CORPUS_WORD("4"), CORPUS_WORD("5"), CORPUS_WORD("6"), CORPUS_WORD("7"), CORPUS_WORD("8"),
+    CORPUS_WORD("9"), CORPUS_WORD("10"), CORPUS_WORD("11"), CORPUS_WORD("12"), CORPUS_WORD("13"), CORPUS_WORD("14"), CORPUS_WORD("15"), CORPUS_WORD("16"), CORPUS_WORD("17"),
+    CORPUS_WORD("18"), CORPUS_WORD("19"), CORPUS_WORD("20"), CORPUS_WORD("25"), CORPUS_WORD("30"), CORPUS_WORD("42"), CORPUS_WORD("50"), CORPUS_WORD("75"), CORPUS_WORD("99"),
+    CORPUS_WORD("100"), CORPUS_WORD("123"), CORPUS_WORD("456"), CORPUS_WORD("789"), CORPUS_WORD("1000"), CORPUS_WORD("2024"), CORPUS_WORD("2025"), CORPUS_WORD("3000"), CORPUS_WORD("5000"),
+};
+
+#undef CORPUS_WORD
+
+WordList externalWordList;
+
+bool loadWordList(const std::string& path, WordList& list) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+
+    void* mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);  // The mapping keeps the file alive
+    if (mapped == MAP_FAILED) return false;
+    madvise(mapped, st.st_size, MADV_SEQUENTIAL);
+
+    list.data = (const char*)mapped;
+    list.size = st.st_size;
+
+    // One pass over the file, sorting each word into its group
+    std::vector<WordView> groups[5];
+    const char* p = list.data;
+    const char* end = list.data + list.size;
+    while (p < end) {
+        const char* line_end = (const char*)memchr(p, '\n', end - p);
+        if (line_end == nullptr) line_end = end;
+
+        // Trim surrounding whitespace (also handles CRLF files)
+        const char* word_start = p;
+        const char* word_end = line_end;
+        while (word_start < word_end && isspace((unsigned char)*word_start)) word_start++;
+        while (word_end > word_start && isspace((unsigned char)word_end[-1])) word_end--;
+
+        bool valid = word_start < word_end;
+        bool hasPunct = false;
+        bool hasDigit = false;
+        bool allDigits = true;
+        for (const char* c = word_start; c < word_end && valid; c++) {
+            if (*c < 33 || *c > 126) {
+                valid = false;  // Not typeable as a single word
+            } else if (isdigit((unsigned char)*c)) {
+                hasDigit = true;
+            } else {
+                allDigits = false;
+                if (!isalpha((unsigned char)*c)) hasPunct = true;
+            }
+        }
+
+        if (valid) {
+            WordView word = { word_start, (size_t)(word_end - word_start) };
+            int group;
+            if (hasPunct && hasDigit) group = 0;
+            else if (hasPunct) group = 1;
+            else if (!hasDigit) group = 2;
+            else if (!allDigits) group = 3;
+            else group = 4;
+            groups[group].push_back(word);
+        }
+        p = line_end + 1;
+    }
+
+    size_t total = 0;
+    for (int g = 0; g < 5; g++) total += groups[g].size();
+    list.words.reserve(total);
+    for (int g = 0; g < 5; g++) {
+        list.words.insert(list.words.end(), groups[g].begin(), groups[g].end());
+        if (g == 0) list.punctDigitEnd = list.words.size();
+        else if (g == 1) list.punctEnd = list.words.size();
+        else if (g == 2) list.plainEnd = list.words.size();
+        else if (g == 3) list.digitEnd = list.words.size();
+    }
+    return !list.words.empty();
+}
+
+void unloadWordList(WordList& list) {
+    if (list.data != nullptr) {
+        munmap((void*)list.data, list.size);
+        list.data = nullptr;
+        list.size = 0;
+    }
+    list.words.clear();
+}
+
+WordPool selectWordPool(bool includePunctuation, bool includeNumbers) {
+    WordPool pool;
+    const WordList& list = externalWordList;
+    if (!list.words.empty()) {
+        size_t first, last;
+        if (includeNumbers && !includePunctuation) {
+            first = list.digitEnd;  // Pure numbers only
+            last = list.words.size();
+        } else {
+            first = includePunctuation ? (includeNumbers ? 0 : list.punctDigitEnd) : list.punctEnd;
+            last = includeNumbers ? list.words.size() : list.plainEnd;
+        }
+        if (last > first) {
+            pool.words = list.words.data() + first;
+            pool.count = last - first;
+            return pool;
+        }
+    }
+
+    if (includeNumbers && !includePunctuation) {
+        pool.words = kPureNumbers;
+        pool.count = sizeof(kPureNumbers) / sizeof(kPureNumbers[0]);
+        return pool;
+    }
+
+    size_t first = includePunctuation ? 0 : kPunctuationWordCount;
+    size_t last = kPunctuationWordCount + kBaseWordCount + (includeNumbers ? kNumberWordCount : 0);
+    pool.words = kCorpusWords + first;
+    pool.count = last - first;
+    return pool;
+}
+
+Pcg32 seedGenerator;
+
+uint64_t nextTextSeed() {
+    return seedGenerator.next64();
+}
+
+void generateTargetText(std::string& target, const WordPool& pool, int wordCount, Pcg32& rng) {
+    target.clear();
+    if (wordCount <= 0 || pool.count == 0) return;
+
+    Pcg32 measure = rng;
+    size_t length = wordCount - 1;  // Spaces between words
+    for (int i = 0; i < wordCount; i++) {
+        length += pool.words[measure.bounded((uint32_t)pool.count)].length;
+    }
+    target.reserve(length);
+
+    for (int i = 0; i < wordCount; i++) {
+        if (i > 0) target += ' ';  // Add space between words
+        const WordView& word = pool.words[rng.bounded((uint32_t)pool.count)];
+        target.append(word.text, word.length);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Typing state machine
+// ---------------------------------------------------------------------------
+
+int64_t monotonicNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void typingKeystroke(TypingState& state, int64_t now_ns) {
+    if (!state.started) {
+        state.started = true;
+        state.start_ns = now_ns;
+    }
+    state.last_key_ns = now_ns;
+}
+
+double typingElapsed(const TypingState& state, int64_t now_ns) {
+    if (!state.started) return 0.0;
+    return (now_ns - state.start_ns) / 1e9;
+}
+
+double typingDuration(const TypingState& state) {
+    double elapsed = typingElapsed(state, state.last_key_ns);
+    return elapsed < 0.001 ? 0.001 : elapsed;
+}
+
+void resetTypingState(TypingState& state, size_t target_length) {
+    state.typed.clear();
+    state.typed.reserve(target_length);
+    state.correct = 0;
+    state.trimmed = 0;
+    state.has_jumped = false;
+    state.jumped_from_pos = std::string::npos;
+    state.jump_correct = 0;
+    state.started = false;
+    state.start_ns = 0;
+    state.last_key_ns = 0;
+}
+
+// Append one character and score it against the target
+static void appendTyped(TypingState& state, const std::string& target, char c) {
+    if (c == target[state.typed.length()]) state.correct++;
+    state.typed += c;
+}
+
+// Forget any active word jump
+static void clearJump(TypingState& state) {
+    state.has_jumped = false;
+    state.jumped_from_pos = std::string::npos;
+    state.jump_correct = 0;
+}
+
+void typingBackspace(TypingState& state, const std::string& target) {
+    if (state.has_jumped && state.typed.length() > state.jumped_from_pos) {
+        // If we jumped and are past the jump point, return to jump position
+        state.correct -= state.jump_correct;
+        state.typed.resize(state.jumped_from_pos);
+        clearJump(state);
+    } else if (!state.typed.empty()) {  // Normal backspace
+        size_t last = state.typed.length() - 1;
+        if (state.typed[last] == target[last]) state.correct--;
+        state.typed.pop_back();
+        clearJump(state);  // Clear any jump state
+    }
+}
+
+void typingSpace(TypingState& state, const std::string& target) {
+    if (state.typed.length() >= target.length()) return;
+
+    // Check if we're in the middle of a word (next char isn't space)
+    if (target[state.typed.length()] != ' ') {
+        // We're in the middle of a word - jump to next word start
+        size_t jumped_from = state.typed.length();
+        size_t correct_before = state.correct;
+
+        // Find next word start position, skipping consecutive spaces
+        size_t next_word_pos = target.length(); // Default to end
+        size_t space_pos = target.find(' ', jumped_from);
+        if (space_pos != std::string::npos) {
+            while (space_pos < target.length() && target[space_pos] == ' ') {
+                space_pos++;
+            }
+            next_word_pos = space_pos;
+        }
+
+        // Fill with incorrect markers for skipped letters
+        while (state.typed.length() < next_word_pos) {
+            if (target[state.typed.length()] == ' ') {
+                appendTyped(state, target, ' ');  // Keep spaces as spaces
+            } else {
+                appendTyped(state, target, '_');  // Mark skipped letters as incorrect
+            }
+        }
+        state.has_jumped = true;
+        state.jumped_from_pos = jumped_from;
+        state.jump_correct = state.correct - correct_before;
+    } else {
+        // Normal space - we're at a space position
+        appendTyped(state, target, ' ');
+        clearJump(state);
+    }
+}
+
+void typingCharacter(TypingState& state, const std::string& target, char c) {
+    if (state.typed.length() >= target.length()) return;  // Don't go past target
+    appendTyped(state, target, c);
+    clearJump(state);  // Clear jump state on normal typing
+}
+
+void computeTypingStats(size_t correct, size_t typedCount, double elapsed, double& wpm, double& accuracy) {
+    // WPM = (correct chars / 5) / (time in minutes)
+    double raw_wpm = (correct / 5.0) / (elapsed / 60.0);
+    // Accuracy = (correct chars / total typed) * 100
+    accuracy = typedCount > 0 ? (correct * 100.0) / typedCount : 0.0;
+    double accuracy_multiplier = 1.0;
+    if (accuracy < 50.0) {
+        accuracy_multiplier = accuracy / 50.0;  // Linear penalty below 50%
+    }
+    wpm = raw_wpm * accuracy_multiplier;
+}
+
+bool applyTypingKey(TypingState& state, const std::string& target, int ch, int64_t now_ns) {
+    if (ch == kKeyBackspace || ch == 127 || ch == 8) {  // Backspace handling
+        typingBackspace(state, target);
+        return true;
+    }
+    if (ch == ' ' || (ch >= 33 && ch <= 126)) {  // Space or other printable ASCII
+        if (state.typed.length() < target.length()) {  // Don't go past target
+            typingKeystroke(state, now_ns);  // Start timer on first keypress
+            if (ch == ' ') {
+                typingSpace(state, target);  // Space key - special handling
+            } else {
+                typingCharacter(state, target, (char)ch);
+            }
+        }
+        return true;
+    }
+    return false;
+}
+
+// ---------------------------------------------------------------------------
+// Test recordings
+// ---------------------------------------------------------------------------
+
+TestRecorder testRecorder;
+
+void enableRecording(TestRecorder& rec, const std::string& path) {
+    rec.enabled = true;
+    rec.path = path;
+    rec.ring.resize(1 << 16);
+}
+
+void recorderBegin(TestRecorder& rec, uint64_t seed, int wordCount, uint16_t flags, int64_t now_ns,
+                   int timedSeconds) {
+    if (!rec.enabled) return;
+    rec.seed = seed;
+    rec.wordCount = (uint32_t)wordCount;
+    rec.flags = flags;
+    rec.timedSeconds = (uint16_t)timedSeconds;
+    rec.last_ns = now_ns;
+    rec.head = 0;
+    rec.count = 0;
+    rec.spill.clear();
+}
+
+void recorderKey(TestRecorder& rec, int64_t now_ns, int key) {
+    if (!rec.enabled) return;
+    if (rec.count == rec.ring.size()) {
+        // Ring is full - move its contents out in order and start over
+        for (size_t i = 0; i < rec.count; i++) {
+            rec.spill.push_back(rec.ring[(rec.head + i) & (rec.ring.size() - 1)]);
+        }
+        rec.head = 0;
+        rec.count = 0;
+    }
+
+    int64_t delta_us = (now_ns - rec.last_ns) / 1000;
+    if (delta_us < 0) delta_us = 0;
+    if (delta_us > 0xFFFFFFFFLL) delta_us = 0xFFFFFFFFLL;
+    KeyEvent& ev = rec.ring[(rec.head + rec.count) & (rec.ring.size() - 1)];
+    ev.delta_us = (uint32_t)delta_us;
+    ev.key = key;
+    rec.count++;
+    rec.last_ns = now_ns;
+}
+
+// Little-endian serialization helpers for the recording format
+static void putU16(std::string& out, uint16_t v) {
+    out += (char)(v & 0xFF);
+    out += (char)(v >> 8);
+}
+
+static void putU32(std::string& out, uint32_t v) {
+    putU16(out, (uint16_t)(v & 0xFFFF));
+    putU16(out, (uint16_t)(v >> 16));
+}
+
+static void putU64(std::string& out, uint64_t v) {
+    putU32(out, (uint32_t)(v & 0xFFFFFFFFULL));
+    putU32(out, (uint32_t)(v >> 32));
+}
+
+uint16_t getU16(const unsigned char* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+uint32_t getU32(const unsigned char* p) {
+    return (uint32_t)getU16(p) | ((uint32_t)getU16(p + 2) << 16);
+}
+
+uint64_t getU64(const unsigned char* p) {
+    return (uint64_t)getU32(p) | ((uint64_t)getU32(p + 4) << 32);
+}
+
+void recorderFinish(TestRecorder& rec, const std::string& target, int layoutWidth) {
+    if (!rec.enabled) return;
+
+    size_t eventCount = rec.spill.size() + rec.count;
+    std::string out;
+    out.reserve(kRecordHeaderSize + target.length() + eventCount * kRecordEventSize);
+    out.append(kRecordMagic, 4);
+    putU16(out, kRecordVersion);
+    putU16(out, rec.flags);
+    putU64(out, rec.seed);
+    putU32(out, rec.wordCount);
+    putU32(out, (uint32_t)target.length());
+    putU32(out, (uint32_t)eventCount);
+    putU16(out, rec.timedSeconds);
+    putU16(out, (uint16_t)std::max(0, std::min(layoutWidth, 0xFFFF)));
+    out += target;
+    for (size_t i = 0; i < eventCount; i++) {
+        const KeyEvent& ev = (i < rec.spill.size()) ? rec.spill[i]
+            : rec.ring[(rec.head + i - rec.spill.size()) & (rec.ring.size() - 1)];
+        putU32(out, ev.delta_us);
+        putU16(out, (uint16_t)ev.key);
+    }
+
+    persist(PERSIST_APPEND, rec.path, out);
+    rec.count = 0;
+    rec.spill.clear();
+}
+
+RecordingStatus readRecording(const unsigned char* data, size_t remaining, TestRecording& record, size_t& size) {
+    uint16_t version = remaining >= kRecordHeaderSizeV1 ? getU16(data + 4) : 0;
+    size_t headerSize = version == kRecordVersion1 ? kRecordHeaderSizeV1 : kRecordHeaderSize;
+    if (remaining < headerSize || memcmp(data, kRecordMagic, 4) != 0 ||
+        (version != kRecordVersion && version != kRecordVersion1)) {
+        return RECORDING_INVALID;
+    }
+    record.version = version;
+    record.flags = getU16(data + 6);
+    record.seed = getU64(data + 8);
+    record.wordCount = getU32(data + 16);
+    uint32_t targetLength = getU32(data + 20);
+    uint32_t eventCount = getU32(data + 24);
+    record.timedSeconds = version == kRecordVersion1 ? 0 : getU16(data + 28);
+    record.layoutWidth = version == kRecordVersion1 ? 0 : getU16(data + 30);
+    if (version == kRecordVersion1) record.flags &= ~RECORD_STREAMED;
+    if ((record.flags & RECORD_STREAMED) && record.layoutWidth <= 0) return RECORDING_INVALID;
+    size = headerSize + targetLength + (size_t)eventCount * kRecordEventSize;
+    if (remaining < size) return RECORDING_TRUNCATED;
+
+    record.target.assign((const char*)data + headerSize, targetLength);
+    const unsigned char* events = data + headerSize + targetLength;
+    record.events.resize(eventCount);
+    for (uint32_t i = 0; i < eventCount; i++) {
+        record.events[i].delta_us = getU32(events + i * kRecordEventSize);
+        record.events[i].key = getU16(events + i * kRecordEventSize + 4);
+    }
+    return RECORDING_OK;
+}
+
+// ---------------------------------------------------------------------------
+// Name registry
+// ---------------------------------------------------------------------------
+
+NameRegistry nameRegistry;
+
+uint32_t internName(NameRegistry& registry, const std::string& name, uint8_t source) {
+    std::unordered_map<std::string, uint32_t>::const_iterator it = registry.ids.find(name);
+    if (it != registry.ids.end()) {
+        registry.sources[it->second] |= source;
+        return it->second;
+    }
+    uint32_t id = (uint32_t)registry.names.size();
+    registry.names.push_back(name);
+    registry.sources.push_back(source);
+    registry.ids[name] = id;
+    return id;
+}
+
+uint32_t findName(const NameRegistry& registry, const std::string& name) {
+    std::unordered_map<std::string, uint32_t>::const_iterator it = registry.ids.find(name);
+    return it == registry.ids.end() ? UINT32_MAX : it->second;
+}
+
+void clearNameSource(NameRegistry& registry, uint8_t source) {
+    for (size_t i = 0; i < registry.sources.size(); i++) registry.sources[i] &= (uint8_t)~source;
+}
+
+// ---------------------------------------------------------------------------
+// Score log
+// ---------------------------------------------------------------------------
+
+ScoreStore scoreStore;
+
+uint32_t scoreModeKey(int wordCount, bool hasPunctuation, bool hasNumbers) {
+    return ((uint32_t)wordCount << 2) | (hasPunctuation ? SCORE_PUNCTUATION : 0) | (hasNumbers ? SCORE_NUMBERS : 0);
+}
+
+uint32_t timedModeKey(int seconds, bool hasPunctuation, bool hasNumbers) {
+    return kScoreModeTimed | scoreModeKey(seconds, hasPunctuation, hasNumbers);
+}
+
+// NUL-padded fixed-width string field
+static void putField(std::string& out, const std::string& s, size_t width) {
+    size_t n = std::min(s.length(), width);
+    out.append(s, 0, n);
+    out.append(width - n, '\0');
+}
+
+static void putF32(std::string& out, float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    putU32(out, bits);
+}
+
+static float getF32(const unsigned char* p) {
+    uint32_t bits = getU32(p);
+    float v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+static double getF64(const unsigned char* p) {
+    uint64_t bits = getU64(p);
+    double v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+static void putScoreLogHeader(std::string& out) {
+    out.append(kScoreLogMagic, 4);
+    putU16(out, kScoreLogVersion);
+    putU16(out, (uint16_t)kScoreRecordSize);
+    putU64(out, 0);
+}
+
+static void putScoreRecord(std::string& out, const PlayerScore& score) {
+    putField(out, score.name(), kScoreNameSize);
+    putU64(out, (uint64_t)score.timestampMs);
+    putF32(out, score.wpm);
+    putF32(out, score.accuracy);
+    putF32(out, score.time);
+    putU32(out, score.mode);
+}
+
+static PlayerScore getScoreRecord(const unsigned char* p) {
+    const char* name = (const char*)p;
+    const unsigned char* q = p + kScoreNameSize;
+    PlayerScore score;
+    score.playerId = internName(nameRegistry, std::string(name, strnlen(name, kScoreNameSize)), 0);
+    score.timestampMs = (int64_t)getU64(q);
+    score.wpm = getF32(q + 8);
+    score.accuracy = getF32(q + 12);
+    score.time = getF32(q + 16);
+    score.mode = getU32(q + 20);
+    return score;
+}
+
+// Version 1 records: name[32]  date[24]  f64 wpm  f64 accuracy  f64 time  u32 wordCount  u16 flags  u16 reserved
+static const uint16_t kScoreLogVersion1 = 1;
+static const size_t kScoreDateSizeV1 = 24;
+static const size_t kScoreRecordSizeV1 = kScoreNameSize + kScoreDateSizeV1 + 8 + 8 + 8 + 4 + 2 + 2;
+
+static PlayerScore getScoreRecordV1(const unsigned char* p) {
+    const char* name = (const char*)p;
+    const char* date = (const char*)p + kScoreNameSize;
+    const unsigned char* q = p + kScoreNameSize + kScoreDateSizeV1;
+    uint16_t flags = getU16(q + 28);
+    return makePlayerScore(std::string(name, strnlen(name, kScoreNameSize)),
+                           getF64(q), getF64(q + 8), getF64(q + 16), (int)getU32(q + 24),
+                           (flags & SCORE_PUNCTUATION) != 0, (flags & SCORE_NUMBERS) != 0,
+                           parseScoreDate(std::string(date, strnlen(date, kScoreDateSizeV1))));
+}
+
+// Orders score indexes best first with compareScores; ties go to the older score
+struct RankOrder {
+    const std::vector<PlayerScore>* scores;
+
+    bool operator()(uint32_t a, uint32_t b) const {
+        const PlayerScore& sa = (*scores)[a];
+        const PlayerScore& sb = (*scores)[b];
+        if (compareScores(sa, sb)) return true;
+        if (compareScores(sb, sa)) return false;
+        return a < b;
+    }
+};
+
+// Offer one score to a top-K. With RankOrder as the heap's "less", the root is the
+// weakest kept score.
+static void offerTopScore(TopScores& top, const RankOrder& order, uint32_t index) {
+    if (top.heap.size() < kTopScoresCapacity) {
+        top.heap.push_back(index);
+        std::push_heap(top.heap.begin(), top.heap.end(), order);
+    } else if (order(index, top.heap.front())) {
+        std::pop_heap(top.heap.begin(), top.heap.end(), order);
+        top.heap.back() = index;
+        std::push_heap(top.heap.begin(), top.heap.end(), order);
+    }
+}
+
+// Offer one score (already in store.scores) to the overall and its mode's top-K,
+// and register its player name
+static void rankScore(ScoreStore& store, uint32_t index) {
+    RankOrder order = { &store.scores };
+    const PlayerScore& s = store.scores[index];
+    nameRegistry.sources[s.playerId] |= NAME_HAS_SCORES;
+    offerTopScore(store.overall, order, index);
+    offerTopScore(store.modeTop[s.mode], order, index);
+}
+
+// Best n of a top-K. If n is past what the top-K can answer, rank the whole
+// history instead (filtered to one mode unless allModes).
+static std::vector<PlayerScore> bestScores(const ScoreStore& store, const TopScores& top, size_t n,
+                                           bool allModes, uint32_t mode) {
+    RankOrder order = { &store.scores };
+    std::vector<uint32_t> ranked;
+    if (n <= top.heap.size() || top.heap.size() < kTopScoresCapacity) {
+        ranked = top.heap;
+    } else {
+        for (size_t i = 0; i < store.scores.size(); i++) {
+            if (allModes || store.scores[i].mode == mode) {
+                ranked.push_back((uint32_t)i);
+            }
+        }
+    }
+
+    n = std::min(n, ranked.size());
+    std::partial_sort(ranked.begin(), ranked.begin() + n, ranked.end(), order);
+    std::vector<PlayerScore> best;
+    best.reserve(n);
+    for (size_t i = 0; i < n; i++) best.push_back(store.scores[ranked[i]]);
+    return best;
+}
+
+// Write all of out in one call where possible (a single O_APPEND write lands whole)
+static bool writeAll(int fd, const std::string& out) {
+    size_t done = 0;
+    while (done < out.size()) {
+        ssize_t n = write(fd, out.data() + done, out.size() - done);
+        if (n <= 0) return false;
+        done += (size_t)n;
+    }
+    return true;
+}
+
+// Open the score log and take the exclusive lock every process holds while it reads or
+// changes the log. A log another process swapped in whole while we waited is reopened,
+// so the lock is always on the file at path. Returns -1 if it cannot be opened.
+static int lockScoreLog(const std::string& path, int flags) {
+    while (true) {
+        int fd = open(path.c_str(), flags, 0644);
+        if (fd < 0) return -1;
+        int locked;
+        do {
+            locked = flock(fd, LOCK_EX);
+        } while (locked != 0 && errno == EINTR);
+        struct stat held, current;
+        if (locked == 0 && fstat(fd, &held) == 0 && stat(path.c_str(), &current) == 0 &&
+            held.st_dev == current.st_dev && held.st_ino == current.st_ino) {
+            return fd;
+        }
+        close(fd);
+        if (locked != 0) return -1;
+    }
+}
+
+// Version of the score log in fd (kScoreLogVersion or kScoreLogVersion1), or 0 if it is not one
+static uint16_t scoreLogVersion(int fd) {
+    unsigned char header[kScoreLogHeaderSize];
+    if (pread(fd, header, sizeof(header), 0) != (ssize_t)sizeof(header)) return 0;
+    if (memcmp(header, kScoreLogMagic, 4) != 0) return 0;
+    uint16_t version = getU16(header + 4);
+    uint16_t recordSize = getU16(header + 6);
+    if (version == kScoreLogVersion && recordSize == kScoreRecordSize) return version;
+    if (version == kScoreLogVersion1 && recordSize == kScoreRecordSizeV1) return version;
+    return 0;
+}
+
+// Whole log image for a list of scores
+static std::string encodeScoreLog(const std::vector<PlayerScore>& scores) {
+    std::string out;
+    out.reserve(kScoreLogHeaderSize + scores.size() * kScoreRecordSize);
+    putScoreLogHeader(out);
+    for (size_t i = 0; i < scores.size(); i++) putScoreRecord(out, scores[i]);
+    return out;
+}
+
+// Decode every whole record of a version 1 log
+static void readScoresV1(ScoreStore& store, int fd, off_t fileSize) {
+    if (fileSize <= (off_t)kScoreLogHeaderSize) return;
+    std::vector<unsigned char> data((size_t)(fileSize - kScoreLogHeaderSize) / kScoreRecordSizeV1 * kScoreRecordSizeV1);
+    size_t got = 0;
+    while (got < data.size()) {
+        ssize_t n = pread(fd, data.data() + got, data.size() - got, (off_t)(kScoreLogHeaderSize + got));
+        if (n <= 0) break;
+        got += (size_t)n;
+    }
+    size_t records = got / kScoreRecordSizeV1;
+    store.scores.reserve(records);
+    for (size_t i = 0; i < records; i++) {
+        store.scores.push_back(getScoreRecordV1(data.data() + i * kScoreRecordSizeV1));
+    }
+}
+
+// Decode the whole records past the ones the store already holds.
+// Returns how many were added to store.scores.
+static size_t readNewScores(ScoreStore& store, int fd, off_t fileSize) {
+    off_t known = (off_t)(kScoreLogHeaderSize + store.scores.size() * kScoreRecordSize);
+    if (fileSize <= known) return 0;
+
+    std::vector<unsigned char> data((size_t)(fileSize - known) / kScoreRecordSize * kScoreRecordSize);
+    size_t got = 0;
+    while (got < data.size()) {
+        ssize_t n = pread(fd, data.data() + got, data.size() - got, known + (off_t)got);
+        if (n <= 0) break;
+        got += (size_t)n;
+    }
+
+    size_t records = got / kScoreRecordSize;
+    store.scores.reserve(store.scores.size() + records);
+    for (size_t i = 0; i < records; i++) {
+        store.scores.push_back(getScoreRecord(data.data() + i * kScoreRecordSize));
+    }
+    return records;
+}
+
+// Empty the store before it is filled from the log at path
+static void resetScoreStore(ScoreStore& store, const std::string& path) {
+    store.path = path;
+    store.scores.clear();
+    store.overall.heap.clear();
+    store.modeTop.clear();
+    clearNameSource(nameRegistry, NAME_HAS_SCORES);
+}
+
+// Tell the worker how many records the store holds, then rank them
+static void finishScoreStore(ScoreStore& store) {
+    std::string none;
+    persist(PERSIST_SCORE_RESET, store.path, none, store.scores.size());
+
+    // O(n log K): nothing outside the kept top-K is ever sorted
+    for (size_t i = 0; i < store.scores.size(); i++) rankScore(store, (uint32_t)i);
+}
+
+void openScoreStore(ScoreStore& store, const std::string& path, const std::string& legacyPath) {
+    resetScoreStore(store, path);
+
+    // Held locked throughout, so a log being created or converted by another process
+    // is only seen once it is complete
+    int fd = lockScoreLog(path, O_RDWR | O_CREAT);
+    if (fd >= 0) {
+        struct stat st;
+        if (fstat(fd, &st) != 0) st.st_size = 0;
+        uint16_t version = scoreLogVersion(fd);
+        if (st.st_size < (off_t)kScoreLogHeaderSize) {
+            // No log yet - carry over the old text leaderboard
+            store.scores = loadLeaderboard(legacyPath);
+            std::string out = encodeScoreLog(store.scores);
+            if (ftruncate(fd, 0) == 0) writeAll(fd, out);
+        } else if (version == kScoreLogVersion) {
+            readNewScores(store, fd, st.st_size);
+            off_t whole = (off_t)(kScoreLogHeaderSize + store.scores.size() * kScoreRecordSize);
+            if (st.st_size > whole && ftruncate(fd, whole) == 0) {
+                st.st_size = whole;  // Torn record cut off
+            }
+        } else if (version == kScoreLogVersion1) {
+            // Convert the old record layout once, swapping the new log in whole
+            readScoresV1(store, fd, st.st_size);
+            replaceFile(path, encodeScoreLog(store.scores));
+        }
+        close(fd);  // Unlocks
+    }
+    finishScoreStore(store);
+}
+
+void readScoreLog(ScoreLogImage& image, const std::string& path) {
+    image.path = path;
+    image.ready = false;
+    image.records.clear();
+
+    int fd = lockScoreLog(path, O_RDWR);
+    if (fd < 0) return;
+    struct stat st;
+    if (fstat(fd, &st) == 0 && st.st_size >= (off_t)kScoreLogHeaderSize &&
+        scoreLogVersion(fd) == kScoreLogVersion) {
+        image.records.resize((size_t)(st.st_size - kScoreLogHeaderSize) / kScoreRecordSize * kScoreRecordSize);
+        size_t got = 0;
+        while (got < image.records.size()) {
+            ssize_t n = pread(fd, image.records.data() + got, image.records.size() - got,
+                              (off_t)(kScoreLogHeaderSize + got));
+            if (n <= 0) break;
+            got += (size_t)n;
+        }
+        image.records.resize(got / kScoreRecordSize * kScoreRecordSize);
+        off_t whole = (off_t)(kScoreLogHeaderSize + image.records.size());
+        image.ready = st.st_size == whole || ftruncate(fd, whole) == 0;  // A torn record is cut off
+    }
+    close(fd);
+}
+
+void openScoreStore(ScoreStore& store, ScoreLogImage& image, const std::string& legacyPath) {
+    if (!image.ready) {
+        openScoreStore(store, image.path, legacyPath);
+        return;
+    }
+    resetScoreStore(store, image.path);
+    size_t records = image.records.size() / kScoreRecordSize;
+    store.scores.reserve(records);
+    for (size_t i = 0; i < records; i++) {
+        store.scores.push_back(getScoreRecord(image.records.data() + i * kScoreRecordSize));
+    }
+    std::vector<unsigned char>().swap(image.records);
+    image.ready = false;
+    finishScoreStore(store);
+}
+
+void addScore(ScoreStore& store, const PlayerScore& score) {
+    // Rank whatever other players appended before our last score went out
+    PlayerScore foreign;
+    while (takeForeignScore(foreign)) {
+        store.scores.push_back(foreign);
+        rankScore(store, (uint32_t)(store.scores.size() - 1));
+    }
+
+    std::string record;
+    putScoreRecord(record, score);
+    persist(PERSIST_SCORE_APPEND, store.path, record);  // The in-memory ranking is kept even if this fails
+
+    store.scores.push_back(score);
+    rankScore(store, (uint32_t)(store.scores.size() - 1));
+}
+
+std::vector<PlayerScore> topScores(const ScoreStore& store, size_t n) {
+    return bestScores(store, store.overall, n, true, 0);
+}
+
+std::vector<PlayerScore> topScoresForMode(const ScoreStore& store, uint32_t mode, size_t n) {
+    std::unordered_map<uint32_t, TopScores>::const_iterator it = store.modeTop.find(mode);
+    if (it == store.modeTop.end()) return std::vector<PlayerScore>();
+    return bestScores(store, it->second, n, false, mode);
+}
+
+std::vector<uint32_t> scoreModes(const ScoreStore& store) {
+    std::vector<uint32_t> modes;
+    modes.reserve(store.modeTop.size());
+    for (std::unordered_map<uint32_t, TopScores>::const_iterator it = store.modeTop.begin(); it != store.modeTop.end(); ++it) {
+        modes.push_back(it->first);
+    }
+    std::sort(modes.begin(), modes.end());
+    return modes;
+}
+
+void clearScoreStore(ScoreStore& store) {
+    store.scores.clear();
+    store.overall.heap.clear();
+    store.modeTop.clear();
+    clearNameSource(nameRegistry, NAME_HAS_SCORES);
+
+    // Appends already queued may still pick up other players' scores; let them land first
+    flushPersistWorker();
+    PlayerScore foreign;
+    while (takeForeignScore(foreign)) {}
+
+    std::string out;
+    putScoreLogHeader(out);
+    persist(PERSIST_SCORE_RESET, store.path, out, 0);
+}
+
+// ---------------------------------------------------------------------------
+// Persistence worker
+// ---------------------------------------------------------------------------
+
+// One score log record exactly as another process wrote it. The worker passes these on
+// undecoded: only the UI thread interns names into the registry.
+struct ForeignScoreRecord {
+    unsigned char bytes[kScoreRecordSize];
+};
+
+struct PersistJob {
+    PersistKind kind;
+    std::string path;
+    std::string data;
+    size_t records;
+
+    PersistJob() : kind(PERSIST_REPLACE), records(0) {}
+};
+
+static const size_t kPersistQueueSize = 256;        // Far more than one test ever queues
+static const size_t kForeignScoreQueueSize = 4096;
+
+static SpscQueue<PersistJob> persistQueue(kPersistQueueSize);           // UI thread -> worker
+static SpscQueue<ForeignScoreRecord> foreignScores(kForeignScoreQueueSize);    // Worker -> UI thread
+static std::thread persistThread;
+static int persistWakeFd = -1;                   // eventfd bumped once per queued job
+static std::atomic<bool> persistStopping(false);
+static std::atomic<uint64_t> persistDone(0);     // Jobs written, counted by the worker
+static uint64_t persistQueued = 0;               // Jobs queued, counted by the UI thread
+
+// Records in the score log that the UI thread has seen (its own and other processes').
+// Owned by whichever thread runs the jobs.
+static size_t scoreLogRecords = 0;
+
+// Indexes of our own records appended while other processes' records before them were
+// still unread (the inbox was full), ascending. Skipped when the reading catches up.
+static std::vector<size_t> ownScoreRecords;
+
+static void replaceFile(const std::string& path, const std::string& data) {
+    std::string tempPath = path + ".tmp";
+    int fd = open(tempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return;
+    bool written = writeAll(fd, data) && fsync(fd) == 0;
+    close(fd);
+    if (!written || rename(tempPath.c_str(), path.c_str()) != 0) unlink(tempPath.c_str());
+}
+
+static void appendFile(const std::string& path, const std::string& data) {
+    int fd = open(path.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+    if (fd < 0) return;
+    writeAll(fd, data);
+    close(fd);
+}
+
+// Append one encoded score, first handing the records other processes appended since
+// the last look to the UI thread
+static void appendScoreRecord(const std::string& path, const std::string& record) {
+    // Locked from the header check to the append, so two processes cannot both start a log
+    int fd = lockScoreLog(path, O_RDWR | O_APPEND | O_CREAT);
+    if (fd < 0) return;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return;
+    }
+
+    std::string out;
+    size_t records = 0;
+    if (st.st_size < (off_t)kScoreLogHeaderSize) {
+        // New (or emptied) log
+        if (st.st_size > 0 && ftruncate(fd, 0) != 0) {
+            close(fd);
+            return;
+        }
+        putScoreLogHeader(out);
+        scoreLogRecords = 0;
+        ownScoreRecords.clear();
+    } else if (scoreLogVersion(fd) == kScoreLogVersion) {
+        records = (size_t)(st.st_size - kScoreLogHeaderSize) / kScoreRecordSize;
+        if (records > scoreLogRecords) {
+            std::vector<unsigned char> data((records - scoreLogRecords) * kScoreRecordSize);
+            off_t known = (off_t)(kScoreLogHeaderSize + scoreLogRecords * kScoreRecordSize);
+            size_t got = 0;
+            while (got < data.size()) {
+                ssize_t n = pread(fd, data.data() + got, data.size() - got, known + (off_t)got);
+                if (n <= 0) break;
+                got += (size_t)n;
+            }
+            // Stop at a full inbox; the rest is read on the next append
+            size_t first = scoreLogRecords;
+            for (size_t i = 0; i < got / kScoreRecordSize; i++) {
+                if (!ownScoreRecords.empty() && ownScoreRecords.front() == first + i) {
+                    ownScoreRecords.erase(ownScoreRecords.begin());
+                } else {
+                    ForeignScoreRecord foreign;
+                    memcpy(foreign.bytes, data.data() + i * kScoreRecordSize, kScoreRecordSize);
+                    if (!foreignScores.push(foreign)) break;
+                }
+                scoreLogRecords++;
+            }
+        }
+    } else {
+        // Not a score log - the score stays in memory only
+        close(fd);
+        return;
+    }
+
+    out += record;
+    if (writeAll(fd, out)) {
+        // Where the record really landed: a writer that does not lock may have appended
+        // since the fstat, and its records come before ours
+        size_t index = records;
+        off_t end = lseek(fd, 0, SEEK_CUR);
+        if (end >= (off_t)(kScoreLogHeaderSize + kScoreRecordSize)) {
+            index = (size_t)(end - kScoreLogHeaderSize) / kScoreRecordSize - 1;
+        }
+        if (scoreLogRecords == index) scoreLogRecords++;
+        else ownScoreRecords.push_back(index);
+    }
+    close(fd);
+}
+
+// UI thread: decode the next record another process appended
+static bool takeForeignScore(PlayerScore& score) {
+    ForeignScoreRecord foreign;
+    if (!foreignScores.pop(foreign)) return false;
+    score = getScoreRecord(foreign.bytes);
+    return true;
+}
+
+static void runPersistJob(PersistJob& job) {
+    switch (job.kind) {
+    case PERSIST_REPLACE:
+        replaceFile(job.path, job.data);
+        break;
+    case PERSIST_APPEND:
+        appendFile(job.path, job.data);
+        break;
+    case PERSIST_SCORE_RESET:
+        if (!job.data.empty()) {
+            int fd = lockScoreLog(job.path, O_RDWR | O_CREAT);
+            replaceFile(job.path, job.data);
+            if (fd >= 0) close(fd);
+        }
+        scoreLogRecords = job.records;
+        ownScoreRecords.clear();
+        break;
+    case PERSIST_SCORE_APPEND:
+        appendScoreRecord(job.path, job.data);
+        break;
+    }
+}
+
+// Write a batch in order. A replaced file only needs its newest snapshot, and appends
+// to the same file in a row go out as one write.
+static void writePersistBatch(std::vector<PersistJob>& batch) {
+    for (size_t i = 0; i < batch.size(); i++) {
+        PersistJob& job = batch[i];
+        if (job.kind == PERSIST_REPLACE) {
+            bool superseded = false;
+            for (size_t k = i + 1; k < batch.size() && !superseded; k++) {
+                superseded = batch[k].kind == PERSIST_REPLACE && batch[k].path == job.path;
+            }
+            if (superseded) continue;
+        } else if (job.kind == PERSIST_APPEND) {
+            while (i + 1 < batch.size() && batch[i + 1].kind == PERSIST_APPEND && batch[i + 1].path == job.path) {
+                job.data += batch[++i].data;
+            }
+        }
+        runPersistJob(job);
+    }
+}
+
+static void wakePersistWorker() {
+    uint64_t one = 1;
+    ssize_t written = write(persistWakeFd, &one, sizeof(one));
+    (void)written;  // Only fails if the counter would overflow, and then the worker is awake anyway
+}
+
+static void persistWorkerLoop() {
+    std::vector<PersistJob> batch;
+    while (true) {
+        // Sleep until something is queued; every job since the last wake is taken in one batch
+        uint64_t wakeups;
+        if (read(persistWakeFd, &wakeups, sizeof(wakeups)) < 0 && errno == EINTR) continue;
+        PersistJob job;
+        while (persistQueue.pop(job)) {
+            batch.push_back(PersistJob());
+            batch.back() = std::move(job);
+        }
+        writePersistBatch(batch);
+        persistDone.fetch_add(batch.size(), std::memory_order_release);
+        batch.clear();
+        if (persistStopping.load(std::memory_order_acquire)) return;
+    }
+}
+
+static void persist(PersistKind kind, const std::string& path, std::string& data, size_t records) {
+    PersistJob job;
+    job.kind = kind;
+    job.path = path;
+    job.data.swap(data);
+    job.records = records;
+    if (!persistThread.joinable()) {
+        runPersistJob(job);
+        return;
+    }
+    while (!persistQueue.push(job)) usleep(1000);  // Full - wait for the worker to catch up
+    persistQueued++;
+    wakePersistWorker();
+}
+
+void startPersistWorker() {
+    if (persistThread.joinable()) return;
+    persistWakeFd = eventfd(0, EFD_CLOEXEC);
+    if (persistWakeFd < 0) return;  // Writes stay on the calling thread
+    persistStopping.store(false, std::memory_order_relaxed);
+
+    // The worker blocks every signal, so SIGINT/SIGTERM always reach the UI thread,
+    // which owns shutdown; a write in progress is never interrupted
+    sigset_t all, previous;
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, &previous);
+    persistThread = std::thread(persistWorkerLoop);
+    pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+}
+
+void flushPersistWorker() {
+    if (!persistThread.joinable()) return;
+    while (persistDone.load(std::memory_order_acquire) < persistQueued) usleep(1000);
+}
+
+void stopPersistWorker() {
+    if (!persistThread.joinable()) return;
+    flushPersistWorker();
+    persistStopping.store(true, std::memory_order_release);
+    wakePersistWorker();
+    persistThread.join();
+    close(persistWakeFd);
+    persistWakeFd = -1;
+}
+
+// ---------------------------------------------------------------------------
+// Player database
+// ---------------------------------------------------------------------------
+
+PlayerDatabase playerDatabase;
+
+// FNV-1a, used as the record checksum
+static uint32_t fnv1a(const unsigned char* p, size_t n) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < n; i++) {
+        hash ^= p[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Encode one record into place in the file image
+static void encodePlayerRecord(std::string& image, size_t i, const PlayerRecord& player, uint32_t nameOffset) {
+    std::string record;
+    record.reserve(kPlayerRecordSize);
+    putU32(record, nameOffset);
+    putU16(record, (uint16_t)player.name.length());
+    putU16(record, player.streak);
+    putField(record, player.wormColor, kPlayerColorSize);
+    putU32(record, player.achievements);
+    putU32(record, (uint32_t)player.currency);
+    putU32(record, fnv1a((const unsigned char*)record.data(), record.size()));
+    image.replace(kPlayerDbHeaderSize + i * kPlayerRecordSize, kPlayerRecordSize, record);
+}
+
+// Encode the session block into place in the file image
+static void encodePlayerSession(PlayerDatabase& db) {
+    std::unordered_map<std::string, size_t>::const_iterator it = db.index.find(db.session.player);
+    std::string block;
+    block.reserve(kPlayerSessionSize);
+    putU32(block, it == db.index.end() ? kNoSessionPlayer : (uint32_t)it->second);
+    putU16(block, db.session.wordCount);
+    putU16(block, db.session.customWords);
+    putU16(block, db.session.timedSeconds);
+    putU16(block, db.session.flags);
+    putU32(block, fnv1a((const unsigned char*)block.data(), block.size()));
+    db.image.replace(kPlayerDbHeaderSizeV1, kPlayerSessionSize, block);
+    db.session.dirty = false;
+}
+
+// Encode the whole file: header, every record, then the string table
+static void encodePlayerDatabase(PlayerDatabase& db) {
+    size_t stringTableSize = 0;
+    for (size_t i = 0; i < db.players.size(); i++) stringTableSize += db.players[i].name.length();
+
+    db.image.clear();
+    db.image.reserve(kPlayerDbHeaderSize + db.players.size() * kPlayerRecordSize + stringTableSize);
+    db.image.append(kPlayerDbMagic, 4);
+    putU16(db.image, kPlayerDbVersion);
+    putU16(db.image, (uint16_t)kPlayerRecordSize);
+    putU32(db.image, (uint32_t)db.players.size());
+    putU32(db.image, (uint32_t)stringTableSize);
+    db.image.append(kPlayerSessionSize + db.players.size() * kPlayerRecordSize, '\0');
+    encodePlayerSession(db);
+
+    uint32_t nameOffset = 0;
+    for (size_t i = 0; i < db.players.size(); i++) {
+        encodePlayerRecord(db.image, i, db.players[i], nameOffset);
+        db.image += db.players[i].name;
+        nameOffset += (uint32_t)db.players[i].name.length();
+    }
+}
+
+bool openPlayerDatabase(PlayerDatabase& db, const std::string& path) {
+    db.path = path;
+    db.players.clear();
+    db.index.clear();
+    db.image.clear();
+    db.rebuild = false;
+    db.session = PlayerSession();
+    clearNameSource(nameRegistry, NAME_HAS_PROFILE);
+
+    std::ifstream file(path.c_str(), std::ios::binary);
+    if (!file.is_open()) return false;
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    const unsigned char* p = (const unsigned char*)data.data();
+    uint16_t version = data.size() >= kPlayerDbHeaderSizeV1 ? getU16(p + 4) : 0;
+    size_t headerSize = version == kPlayerDbVersion1 ? kPlayerDbHeaderSizeV1 : kPlayerDbHeaderSize;
+    if (data.size() < headerSize || memcmp(p, kPlayerDbMagic, 4) != 0 ||
+        (version != kPlayerDbVersion && version != kPlayerDbVersion1) || getU16(p + 6) != kPlayerRecordSize) {
+        db.rebuild = true;  // Unreadable - replaced on the next flush
+        return true;
+    }
+    if (version == kPlayerDbVersion1) db.rebuild = true;  // Gains the session block on the next flush
+    size_t count = getU32(p + 8);
+    size_t stringTableSize = getU32(p + 12);
+    size_t stringTable = headerSize + count * kPlayerRecordSize;
+    if (data.size() < stringTable + stringTableSize) {
+        db.rebuild = true;
+        return true;
+    }
+
+    db.players.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        const unsigned char* r = p + headerSize + i * kPlayerRecordSize;
+        uint32_t nameOffset = getU32(r);
+        uint16_t nameLength = getU16(r + 4);
+        if (fnv1a(r, kPlayerRecordSize - 4) != getU32(r + kPlayerRecordSize - 4) ||
+            (size_t)nameOffset + nameLength > stringTableSize) {
+            db.rebuild = true;  // Damaged record - dropped on the next flush
+            continue;
+        }
+        const char* color = (const char*)r + 8;
+        PlayerRecord player(std::string(data.data() + stringTable + nameOffset, nameLength));
+        player.wormColor = std::string(color, strnlen(color, kPlayerColorSize));
+        player.achievements = getU32(r + 8 + kPlayerColorSize);
+        player.currency = (int32_t)getU32(r + 12 + kPlayerColorSize);
+        player.streak = getU16(r + 6);
+        player.dirty = false;
+        if (db.index.count(player.name) != 0) continue;
+        db.index[player.name] = db.players.size();
+        db.players.push_back(player);
+        internName(nameRegistry, player.name, NAME_HAS_PROFILE);
+    }
+
+    // Last session, by record index (a dropped record only loses it if it was the session's)
+    const unsigned char* session = p + kPlayerDbHeaderSizeV1;
+    if (version == kPlayerDbVersion &&
+        fnv1a(session, kPlayerSessionSize - 4) == getU32(session + kPlayerSessionSize - 4)) {
+        uint32_t player = getU32(session);
+        if (player < count && !db.rebuild) {
+            db.session.player = db.players[player].name;
+        } else if (player < count) {
+            // Records were dropped, so indexes moved; find the name in the file itself
+            const unsigned char* r = p + headerSize + player * kPlayerRecordSize;
+            uint32_t nameOffset = getU32(r);
+            uint16_t nameLength = getU16(r + 4);
+            if ((size_t)nameOffset + nameLength <= stringTableSize) {
+                db.session.player = std::string(data.data() + stringTable + nameOffset, nameLength);
+            }
+        }
+        db.session.wordCount = getU16(session + 4);
+        db.session.customWords = getU16(session + 6);
+        db.session.timedSeconds = getU16(session + 8);
+        db.session.flags = getU16(session + 10);
+    }
+
+    if (!db.rebuild) db.image.swap(data);
+    return true;
+}
+
+PlayerRecord* findPlayer(PlayerDatabase& db, const std::string& name) {
+    std::unordered_map<std::string, size_t>::const_iterator it = db.index.find(name);
+    return it == db.index.end() ? nullptr : &db.players[it->second];
+}
+
+PlayerRecord& upsertPlayer(PlayerDatabase& db, const std::string& name) {
+    PlayerRecord* player = findPlayer(db, name);
+    if (player != nullptr) return *player;
+    db.index[name] = db.players.size();
+    db.players.push_back(PlayerRecord(name));
+    internName(nameRegistry, name, NAME_HAS_PROFILE);
+    db.rebuild = true;  // New name goes into the string table
+    return db.players.back();
+}
+
+void clearPlayerDatabase(PlayerDatabase& db) {
+    db.players.clear();
+    db.index.clear();
+    clearNameSource(nameRegistry, NAME_HAS_PROFILE);
+    db.rebuild = true;
+}
+
+void flushPlayerDatabase(PlayerDatabase& db) {
+    if (db.rebuild || db.image.empty()) {
+        encodePlayerDatabase(db);
+    } else {
+        bool changed = db.session.dirty;
+        if (changed) encodePlayerSession(db);
+        for (size_t i = 0; i < db.players.size(); i++) {
+            if (!db.players[i].dirty) continue;
+            uint32_t nameOffset = getU32((const unsigned char*)db.image.data() + kPlayerDbHeaderSize + i * kPlayerRecordSize);
+            encodePlayerRecord(db.image, i, db.players[i], nameOffset);
+            changed = true;
+        }
+        if (!changed) return;
+    }
+
+    // The image is always the whole file, so the worker just swaps a snapshot of it in
+    std::string snapshot = db.image;
+    persist(PERSIST_REPLACE, db.path, snapshot);
+
+    for (size_t i = 0; i < db.players.size(); i++) db.players[i].dirty = false;
+    db.rebuild = false;
+}
+
+// ---------------------------------------------------------------------------
+// Key statistics
+// ---------------------------------------------------------------------------
+
+KeyStatsStore keyStatsStore;
+
+void clearKeyStats(KeyStats& stats) {
+    memset(&stats, 0, sizeof(stats));
+}
+
+// Count one press against a cell
+static void countKeyStat(KeyStat& stat, bool error, int64_t interval_ns) {
+    stat.presses++;
+    if (error) stat.errors++;
+    if (interval_ns >= 0) {
+        stat.timed++;
+        stat.total_us += (uint64_t)(interval_ns / 1000);
+    }
+}
+
+void keyTimerUpdate(KeyTimer& timer, KeyStats& stats, const TypingState& state, const std::string& target,
+                    size_t typedBefore, int64_t now_ns) {
+    size_t count = state.typedCount();
+    if (count != typedBefore + 1 || state.has_jumped || state.typed.empty()) {
+        timer.last_ns = 0;
+        return;
+    }
+
+    size_t i = state.typed.length() - 1;
+    int key = keyStatIndex(target[i]);
+    if (key < 0) {
+        timer.last_ns = 0;
+        return;
+    }
+    bool error = state.typed[i] != target[i];
+    bool chained = timer.last_ns != 0 && timer.last_pos + 1 == count - 1;
+    int64_t interval_ns = chained ? now_ns - timer.last_ns : -1;
+    if (interval_ns > kKeyPauseNs) {
+        chained = false;
+        interval_ns = -1;
+    }
+
+    countKeyStat(stats.keys[key], error, interval_ns);
+    if (chained) countKeyStat(stats.bigrams[timer.last_key * kKeyStatChars + key], error, interval_ns);
+
+    timer.last_ns = now_ns;
+    timer.last_pos = count - 1;
+    timer.last_key = key;
+}
+
+// Add one table's counters to another
+static void mergeKeyStatTable(KeyStat* into, const KeyStat* from, int cells) {
+    for (int i = 0; i < cells; i++) {
+        into[i].total_us += from[i].total_us;
+        into[i].presses += from[i].presses;
+        into[i].errors += from[i].errors;
+        into[i].timed += from[i].timed;
+    }
+}
+
+void mergeKeyStats(KeyStats& into, const KeyStats& from) {
+    mergeKeyStatTable(into.keys, from.keys, kKeyStatChars);
+    mergeKeyStatTable(into.bigrams, from.bigrams, kKeyStatBigrams);
+}
+
+double keyStatMeanMs(const KeyStat& stat) {
+    return stat.timed == 0 ? 0.0 : stat.total_us / 1000.0 / stat.timed;
+}
+
+// Orders cells slowest mean first, comparing total_us / timed without dividing
+struct SlowerKeyStat {
+    const KeyStat* table;
+
+    bool operator()(int a, int b) const {
+        double lhs = (double)table[a].total_us * table[b].timed;
+        double rhs = (double)table[b].total_us * table[a].timed;
+        if (lhs != rhs) return lhs > rhs;
+        return a < b;
+    }
+};
+
+std::vector<int> slowestKeyStats(const KeyStat* table, int cells, uint32_t minTimed, size_t n) {
+    std::vector<int> found;
+    for (int i = 0; i < cells; i++) {
+        if (table[i].timed >= minTimed && table[i].timed > 0) found.push_back(i);
+    }
+    SlowerKeyStat slower = { table };
+    if (found.size() > n) {
+        std::partial_sort(found.begin(), found.begin() + n, found.end(), slower);
+        found.resize(n);
+    } else {
+        std::sort(found.begin(), found.end(), slower);
+    }
+    return found;
+}
+
+// Encode the entries of every cell that was ever due
+static std::string encodeKeyStats(const KeyStats& stats) {
+    std::string out;
+    putU32(out, 0);  // Entry count, patched below
+    uint32_t count = 0;
+    for (int cell = 0; cell < kKeyStatChars + kKeyStatBigrams; cell++) {
+        const KeyStat& stat = cell < kKeyStatChars ? stats.keys[cell] : stats.bigrams[cell - kKeyStatChars];
+        if (stat.presses == 0) continue;
+        putU16(out, (uint16_t)cell);
+        putU64(out, stat.total_us);
+        putU32(out, stat.presses);
+        putU32(out, stat.errors);
+        putU32(out, stat.timed);
+        count++;
+    }
+    std::string head;
+    putU32(head, count);
+    out.replace(0, 4, head);
+    return out;
+}
+
+void openKeyStatsStore(KeyStatsStore& store, const std::string& path) {
+    store.path = path;
+    store.players.clear();
+
+    std::ifstream file(path.c_str(), std::ios::binary);
+    if (!file.is_open()) return;
+    std::string data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    const unsigned char* p = (const unsigned char*)data.data();
+    if (data.size() < kKeyStatsHeaderSize || memcmp(p, kKeyStatsMagic, 4) != 0 ||
+        getU16(p + 4) != kKeyStatsVersion) {
+        return;  // Unreadable - replaced on the next save
+    }
+    size_t playerCount = getU32(p + 8);
+    size_t at = kKeyStatsHeaderSize;
+    for (size_t i = 0; i < playerCount; i++) {
+        if (data.size() - at < 2) break;
+        size_t nameLength = getU16(p + at);
+        if (data.size() - at - 2 < nameLength + 4) break;
+        std::string name(data.data() + at + 2, nameLength);
+        at += 2 + nameLength;
+        size_t entries = getU32(p + at);
+        size_t blobSize = 4 + entries * kKeyStatEntrySize;
+        if (data.size() - at < blobSize) break;  // Truncated - keep the players before it
+        store.players[name] = data.substr(at, blobSize);
+        at += blobSize;
+    }
+}
+
+void loadKeyStats(const KeyStatsStore& store, const std::string& name, KeyStats& stats) {
+    clearKeyStats(stats);
+    std::unordered_map<std::string, std::string>::const_iterator it = store.players.find(name);
+    if (it == store.players.end()) return;
+
+    const unsigned char* p = (const unsigned char*)it->second.data();
+    size_t entries = getU32(p);
+    for (size_t i = 0; i < entries; i++) {
+        const unsigned char* e = p + 4 + i * kKeyStatEntrySize;
+        int cell = getU16(e);
+        if (cell >= kKeyStatChars + kKeyStatBigrams) continue;
+        KeyStat& stat = cell < kKeyStatChars ? stats.keys[cell] : stats.bigrams[cell - kKeyStatChars];
+        stat.total_us = getU64(e + 2);
+        stat.presses = getU32(e + 10);
+        stat.errors = getU32(e + 14);
+        stat.timed = getU32(e + 18);
+    }
+}
+
+// Encode the whole store and queue it to be swapped in
+static void writeKeyStatsStore(const KeyStatsStore& store) {
+    std::string out;
+    out.append(kKeyStatsMagic, 4);
+    putU16(out, kKeyStatsVersion);
+    putU16(out, 0);
+    putU32(out, (uint32_t)store.players.size());
+    for (std::unordered_map<std::string, std::string>::const_iterator it = store.players.begin();
+         it != store.players.end(); ++it) {
+        putU16(out, (uint16_t)it->first.length());
+        out += it->first;
+        out += it->second;
+    }
+    persist(PERSIST_REPLACE, store.path, out);
+}
+
+void saveKeyStats(KeyStatsStore& store, const std::string& name, const KeyStats& stats) {
+    if (name.empty() || name.length() > 0xFFFF) return;
+    store.players[name] = encodeKeyStats(stats);
+    writeKeyStatsStore(store);
+}
+
+void clearKeyStatsStore(KeyStatsStore& store) {
+    store.players.clear();
+    writeKeyStatsStore(store);
+}
+
+// ---------------------------------------------------------------------------
+// Weak-key practice
+// ---------------------------------------------------------------------------
+
+void buildAliasTable(AliasTable& table, const std::vector<double>& weights) {
+    table.threshold.clear();
+    table.alias.clear();
+    size_t n = weights.size();
+    double total = 0.0;
+    for (size_t i = 0; i < n; i++) total += weights[i] > 0.0 ? weights[i] : 0.0;
+    if (n == 0 || total <= 0.0) return;
+
+    // Scale so the average column holds exactly 1, then pair each light column with a heavy one
+    std::vector<double> scaled(n);
+    std::vector<uint32_t> small, large;
+    small.reserve(n);
+    large.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        scaled[i] = (weights[i] > 0.0 ? weights[i] : 0.0) * n / total;
+        (scaled[i] < 1.0 ? small : large).push_back((uint32_t)i);
+    }
+    table.threshold.assign(n, 0xFFFFFFFFu);
+    table.alias.resize(n);
+    for (size_t i = 0; i < n; i++) table.alias[i] = (uint32_t)i;
+    while (!small.empty() && !large.empty()) {
+        uint32_t light = small.back();
+        small.pop_back();
+        uint32_t heavy = large.back();
+        table.threshold[light] = (uint32_t)(scaled[light] * 4294967295.0);
+        table.alias[light] = heavy;
+        scaled[heavy] -= 1.0 - scaled[light];
+        if (scaled[heavy] < 1.0) {
+            large.pop_back();
+            small.push_back(heavy);
+        }
+    }
+    // Whatever is left is 1 up to rounding and keeps its own column
+}
+
+uint32_t aliasSample(const AliasTable& table, Pcg32& rng) {
+    uint32_t column = rng.bounded((uint32_t)table.alias.size());
+    return rng.next() < table.threshold[column] ? column : table.alias[column];
+}
+
+void weakKeyWeights(std::vector<double>& weights, const WordPool& pool, const KeyStats& stats) {
+    // The player's average bigram interval over the bigrams with enough data
+    uint64_t total_us = 0;
+    uint64_t timed = 0;
+    for (int i = 0; i < kKeyStatBigrams; i++) {
+        if (stats.bigrams[i].timed < kWeakKeyMinTimed) continue;
+        total_us += stats.bigrams[i].total_us;
+        timed += stats.bigrams[i].timed;
+    }
+    double average_us = timed > 0 ? (double)total_us / timed : 0.0;
+
+    // Badness of every bigram, looked up per character below
+    std::vector<float> badness(kKeyStatBigrams, 0.0f);
+    for (int i = 0; i < kKeyStatBigrams && average_us > 0.0; i++) {
+        const KeyStat& stat = stats.bigrams[i];
+        if (stat.timed < kWeakKeyMinTimed) continue;
+        double slowness = (double)stat.total_us / stat.timed / average_us - 1.0;
+        double bad = (slowness > 0.0 ? slowness : 0.0) + (double)stat.errors / stat.presses;
+        badness[i] = (float)bad;
+    }
+
+    weights.assign(pool.count, 1.0);
+    if (average_us <= 0.0) return;  // No data yet - every word equally likely
+    for (size_t w = 0; w < pool.count; w++) {
+        const WordView& word = pool.words[w];
+        double sum = 0.0;
+        int previous = keyStatIndex(' ');
+        for (size_t i = 0; i < word.length; i++) {
+            int key = keyStatIndex(word.text[i]);
+            if (key >= 0 && previous >= 0) sum += badness[previous * kKeyStatChars + key];
+            previous = key;
+        }
+        weights[w] = 1.0 + kWeakKeyBoost * sum;
+    }
+}
+
+void prepareWeakKeySampler(WeakKeySampler& sampler, const WordPool& pool, const KeyStats& stats) {
+    std::vector<double> weights;
+    weakKeyWeights(weights, pool, stats);
+    buildAliasTable(sampler.table, weights);
+    sampler.words = pool.words;
+    sampler.count = pool.count;
+}
+
+void generateWeightedText(std::string& target, const WordPool& pool, const WeakKeySampler& sampler,
+                          int wordCount, Pcg32& rng) {
+    if (sampler.words != pool.words || sampler.count != pool.count || sampler.table.alias.empty()) {
+        generateTargetText(target, pool, wordCount, rng);  // Not prepared for this pool
+        return;
+    }
+    target.clear();
+    if (wordCount <= 0) return;
+
+    Pcg32 measure = rng;
+    size_t length = wordCount - 1;  // Spaces between words
+    for (int i = 0; i < wordCount; i++) {
+        length += pool.words[aliasSample(sampler.table, measure)].length;
+    }
+    target.reserve(length);
+
+    for (int i = 0; i < wordCount; i++) {
+        if (i > 0) target += ' ';  // Add space between words
+        const WordView& word = pool.words[aliasSample(sampler.table, rng)];
+        target.append(word.text, word.length);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Wrap layout
+// ---------------------------------------------------------------------------
+
+void buildTextLayout(TextLayout& layout, const std::string& target, int width) {
+    layout.width = width;
+    layout.pos.resize(target.length());
+
+    int row = 0;
+    int col = 0;
+    size_t i = 0;
+    while (i < target.length()) {
+        if (target[i] == ' ') {
+            layout.pos[i].row = row;
+            layout.pos[i].col = col++;
+            i++;
+            continue;
+        }
+
+        // Measure the word and wrap it as a unit
+        size_t word_end = target.find(' ', i);
+        if (word_end == std::string::npos) word_end = target.length();
+        if (col > 0 && col + (int)(word_end - i) > width) {
+            row++;
+            col = 0;
+        }
+        for (; i < word_end; i++) {
+            layout.pos[i].row = row;
+            layout.pos[i].col = col++;
+        }
+    }
+    layout.rows = row + 1;
+}
+
+// ---------------------------------------------------------------------------
+// Streamed text
+// ---------------------------------------------------------------------------
+
+// Append one word, space-separated from the text before it. False once a replayed
+// script has run out.
+static bool streamAppendWord(TextStream& stream, std::string& target) {
+    const char* text;
+    size_t length;
+    if (stream.script != nullptr) {
+        const std::string& script = *stream.script;
+        size_t start = stream.scriptPos;
+        while (start < script.length() && script[start] == ' ') start++;
+        if (start >= script.length()) return false;
+        size_t end = script.find(' ', start);
+        if (end == std::string::npos) end = script.length();
+        text = script.data() + start;
+        length = end - start;
+        stream.scriptPos = end;
+    } else {
+        uint32_t index = stream.sampler != nullptr ? aliasSample(stream.sampler->table, stream.rng)
+                                                   : stream.rng.bounded((uint32_t)stream.pool.count);
+        text = stream.pool.words[index].text;
+        length = stream.pool.words[index].length;
+    }
+    if (!target.empty()) target += ' ';
+    target.append(text, length);
+    if (stream.history != nullptr) {
+        if (!stream.history->empty()) *stream.history += ' ';
+        stream.history->append(text, length);
+    }
+    return true;
+}
+
+void streamBegin(TextStream& stream, std::string& target, const WordPool& pool, uint64_t seed,
+                 const WeakKeySampler* sampler) {
+    stream.pool = pool;
+    stream.rng = Pcg32(seed);
+    stream.sampler = (sampler != nullptr && sampler->words == pool.words && sampler->count == pool.count &&
+                      !sampler->table.alias.empty()) ? sampler : nullptr;
+    stream.script = nullptr;
+    if (stream.history != nullptr) stream.history->clear();
+    target.clear();
+    if (pool.count == 0) return;
+    while (target.length() < kStreamInitialLength) streamAppendWord(stream, target);
+}
+
+void streamReplay(TextStream& stream, std::string& target, const std::string& script) {
+    stream.pool.words = nullptr;
+    stream.pool.count = 0;
+    stream.sampler = nullptr;
+    stream.script = &script;
+    stream.scriptPos = 0;
+    target.clear();
+    while (target.length() < kStreamInitialLength && streamAppendWord(stream, target)) {}
+}
+
+bool streamAdvance(TextStream& stream, std::string& target, TypingState& state, const TextLayout& layout) {
+    if ((stream.pool.count == 0 && stream.script == nullptr) || layout.width <= 0 ||
+        layout.pos.size() != target.length()) {
+        return false;
+    }
+    size_t cursor = state.typed.length();
+    if (cursor >= target.length()) return false;
+
+    // Keep the row before the cursor's; everything above it has scrolled off
+    int row = layout.pos[cursor].row;
+    size_t drop = 0;
+    if (row >= 2) {
+        drop = cursor;
+        while (drop > 0 && layout.pos[drop - 1].row >= row - 1) drop--;
+        if (state.has_jumped && state.jumped_from_pos < drop) {
+            drop = 0;  // Wait until the jump can no longer be undone with backspace
+        }
+    }
+
+    size_t wanted = (size_t)layout.width * kStreamRowsAhead;
+    if (drop == 0 && target.length() - cursor >= wanted / 2) return false;
+
+    if (drop > 0) {
+        target.erase(0, drop);
+        state.typed.erase(0, drop);
+        state.trimmed += drop;
+        if (state.has_jumped) state.jumped_from_pos -= drop;
+    }
+    size_t kept = target.length();
+    while (target.length() < state.typed.length() + wanted && streamAppendWord(stream, target)) {}
+    return drop > 0 || target.length() != kept;  // A replayed script can run out
+}
+
+// ---------------------------------------------------------------------------
+// Latency histogram
+// ---------------------------------------------------------------------------
+
+static int latencyBucket(int64_t ns) {
+    if (ns < kLatencySubBuckets) return ns < 0 ? 0 : (int)ns;
+    int exponent = 63 - __builtin_clzll((unsigned long long)ns);  // >= 4
+    int sub = (int)((ns >> (exponent - 4)) & (kLatencySubBuckets - 1));
+    return (exponent - 3) * kLatencySubBuckets + sub;
+}
+
+int64_t latencyBucketFloor(int bucket) {
+    if (bucket < kLatencySubBuckets) return bucket;
+    int exponent = bucket / kLatencySubBuckets + 3;
+    int sub = bucket % kLatencySubBuckets;
+    return (int64_t)(kLatencySubBuckets + sub) << (exponent - 4);
+}
+
+void recordLatency(LatencyHistogram& hist, int64_t ns) {
+    hist.counts[latencyBucket(ns)]++;
+    hist.samples++;
+    hist.total_ns += ns;
+    if (ns > hist.max_ns) hist.max_ns = ns;
+}
+
+int64_t latencyPercentile(const LatencyHistogram& hist, double fraction) {
+    if (hist.samples == 0) return 0;
+    uint64_t rank = (uint64_t)(fraction * hist.samples + 0.5);
+    if (rank < 1) rank = 1;
+    if (rank > hist.samples) rank = hist.samples;
+
+    uint64_t seen = 0;
+    for (int i = 0; i < kLatencyBucketCount; i++) {
+        seen += hist.counts[i];
+        if (seen >= rank) {
+            int64_t upper = (i + 1 < kLatencyBucketCount) ? latencyBucketFloor(i + 1) - 1 : hist.max_ns;
+            return upper < hist.max_ns ? upper : hist.max_ns;
+        }
+    }
+    return hist.max_ns;
+}
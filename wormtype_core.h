@@ -0,0 +1,765 @@
+// Headless core of the typing tester: word corpus and text generation,
+// wrap layout, typing state and scoring, recordings, the score log, the
+// legacy leaderboard file, the persistence worker and the latency histogram
+// used by --profile.
+// Nothing here depends on ncurses, so the benchmark harness links it directly.
+#ifndef WORMTYPE_CORE_H
+#define WORMTYPE_CORE_H
+
+#include <string>      // String class
+#include <vector>      // Dynamic arrays
+#include <unordered_map>  // Per-mode score rankings
+#include <atomic>      // Persistence queue indexes
+#include <utility>     // For std::move()
+#include <cstddef>     // size_t
+#include <cstdint>     // Fixed-width integers
+
+// Utility function to convert string to uppercase
+std::string toUpperCase(const std::string& str);
+
+// Flags stored with each score record
+enum ScoreFlags {
+    SCORE_PUNCTUATION = 1,
+    SCORE_NUMBERS = 2
+};
+
+// Leaderboard mode of a score: word count plus the punctuation/numbers options
+uint32_t scoreModeKey(int wordCount, bool hasPunctuation, bool hasNumbers);
+
+// Top bit of the mode key marks a timed test; the length field then holds its seconds,
+// so timed modes rank separately and sort after every word-count mode
+static const uint32_t kScoreModeTimed = 0x80000000u;
+
+// Leaderboard mode of a timed test of the given length
+uint32_t timedModeKey(int seconds, bool hasPunctuation, bool hasNumbers);
+
+// One completed test. A small fixed-size value so the score history and its rankings are
+// contiguous arrays: the player is an id in the name registry, the date is an epoch
+// timestamp formatted only for display, and the options are packed into the mode key.
+struct PlayerScore {
+    int64_t timestampMs;   // When the test was finished, ms since the epoch; 0 if unknown
+    uint32_t playerId;     // Id in nameRegistry
+    float wpm;
+    float accuracy;
+    float time;            // Test duration in seconds
+    uint32_t mode;         // scoreModeKey of the test options
+    
+    const std::string& name() const;
+    bool isTimed() const { return (mode & kScoreModeTimed) != 0; }
+    int wordCount() const { return isTimed() ? 0 : (int)(mode >> 2); }
+    int timedSeconds() const { return isTimed() ? (int)((mode & ~kScoreModeTimed) >> 2) : 0; }
+    bool hasPunctuation() const { return (mode & SCORE_PUNCTUATION) != 0; }
+    bool hasNumbers() const { return (mode & SCORE_NUMBERS) != 0; }
+};
+
+// Build a score, interning the player name
+PlayerScore makePlayerScore(const std::string& name, double wpm, double accuracy, double time,
+                            int wordCount, bool punctuation, bool numbers, int64_t timestampMs);
+
+// Wall-clock time in milliseconds since the epoch, for score timestamps
+int64_t wallClockMillis();
+
+// Local date and time of a score, "MM/DD/YYYY HH:MM", or "Unknown" for 0
+std::string formatScoreDate(int64_t timestampMs);
+
+// Parse a date as written by formatScoreDate (or "YYYY-MM-DD HH:MM[:SS]"); 0 if it is not one
+int64_t parseScoreDate(const std::string& date);
+
+// Function to load leaderboard from file
+std::vector<PlayerScore> loadLeaderboard(const std::string& path = "leaderboard.txt");
+
+// Function to save leaderboard to file
+void saveLeaderboard(const std::vector<PlayerScore>& leaderboard, const std::string& path = "leaderboard.txt");
+
+// Comparison function for sorting scores
+bool compareScores(const PlayerScore& a, const PlayerScore& b);
+
+// Function to add score to leaderboard and maintain top 10
+void addToLeaderboard(std::vector<PlayerScore>& leaderboard, const PlayerScore& newScore);
+
+// View of one word in the built-in corpus or an external word list
+struct WordView {
+    const char* text;   // Not NUL-terminated for external word lists
+    size_t length;
+};
+
+// A contiguous run of words that target text is drawn from
+struct WordPool {
+    const WordView* words;
+    size_t count;
+};
+
+// External word list loaded with --wordlist.
+// The file is memory-mapped and indexed in one pass; words are views into the
+// mapping, never copied. The index is grouped as
+//   [punctuation+digits][punctuation][plain][digits][pure numbers]
+// so every punctuation/numbers combination is again one contiguous range.
+struct WordList {
+    const char* data;             // Mapped file contents
+    size_t size;                  // Mapped length
+    std::vector<WordView> words;  // Grouped word index
+    size_t punctDigitEnd;         // End of words with both punctuation and digits
+    size_t punctEnd;              // End of words with punctuation only
+    size_t plainEnd;              // End of plain words
+    size_t digitEnd;              // End of words mixing letters and digits
+                                  // (pure numbers run to words.size())
+
+    WordList() : data(nullptr), size(0), punctDigitEnd(0), punctEnd(0), plainEnd(0), digitEnd(0) {}
+};
+
+// Global external word list (empty when the built-in corpus is used)
+extern WordList externalWordList;
+
+// Map a newline-delimited word file and build its index.
+// Lines are trimmed; lines containing anything but printable non-space ASCII are skipped.
+bool loadWordList(const std::string& path, WordList& list);
+
+// Release the mapping of an external word list
+void unloadWordList(WordList& list);
+
+// Pick the word pool for the selected text options.
+// With an external word list the same options act as filters over its index;
+// if a filter leaves no words the built-in pool for that mode is used instead.
+WordPool selectWordPool(bool includePunctuation, bool includeNumbers);
+
+// PCG32 random number generator (pcg-random.org, XSH-RR variant).
+// Small, fast and seedable so the same seed always produces the same text.
+struct Pcg32 {
+    uint64_t state;
+    uint64_t inc;
+
+    explicit Pcg32(uint64_t seed = 0x853c49e6748fea9bULL, uint64_t stream = 0xda3e39cb94b95bdbULL)
+        : state(0), inc((stream << 1) | 1) {
+        next();
+        state += seed;
+        next();
+    }
+
+    uint32_t next() {
+        uint64_t old = state;
+        state = old * 6364136223846793005ULL + inc;
+        uint32_t xorshifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+        uint32_t rot = (uint32_t)(old >> 59);
+        return (xorshifted >> rot) | (xorshifted << ((32 - rot) & 31));
+    }
+
+    uint64_t next64() {
+        uint64_t high = next();
+        return (high << 32) | next();
+    }
+
+    // Unbiased value in [0, range) using Lemire's multiply-and-reject reduction
+    uint32_t bounded(uint32_t range) {
+        uint64_t m = (uint64_t)next() * range;
+        uint32_t low = (uint32_t)m;
+        if (low < range) {
+            uint32_t threshold = (0u - range) % range;
+            while (low < threshold) {
+                m = (uint64_t)next() * range;
+                low = (uint32_t)m;
+            }
+        }
+        return (uint32_t)(m >> 32);
+    }
+};
+
+// Source of per-test seeds; seeded from --seed or the clock at startup
+extern Pcg32 seedGenerator;
+
+// Seed for the next generated test text
+uint64_t nextTextSeed();
+
+// Generate target text of wordCount random words from the pool.
+// A first pass on a copy of the generator measures the exact output length so
+// the string is reserved once; the second pass replays the same draws.
+void generateTargetText(std::string& target, const WordPool& pool, int wordCount, Pcg32& rng);
+
+// Monotonic timestamp in nanoseconds for keystroke timing
+int64_t monotonicNanos();
+
+// Typing test state machine with running correctness counters.
+// Every edit updates the counters in O(1) so WPM and accuracy never rescan the typed text.
+struct TypingState {
+    std::string typed;        // What user has typed so far
+    size_t correct;           // Typed characters that match the target (including trimmed ones)
+    size_t trimmed;           // Characters scrolled off the front of typed and the target
+    bool has_jumped;          // Whether a word jump is active
+    size_t jumped_from_pos;   // Position where space jump occurred
+    size_t jump_correct;      // Correct characters added by the active jump (spaces kept as spaces)
+    bool started;             // Track if timing has begun
+    int64_t start_ns;         // Monotonic time of the first keystroke
+    int64_t last_key_ns;      // Monotonic time of the latest keystroke
+
+    TypingState() : correct(0), trimmed(0), has_jumped(false), jumped_from_pos(std::string::npos), jump_correct(0),
+                    started(false), start_ns(0), last_key_ns(0) {}
+
+    size_t typedCount() const { return trimmed + typed.length(); }
+    size_t incorrect() const { return typedCount() - correct; }
+};
+
+// Timestamp a keystroke that edits the text; the first one starts the timer
+void typingKeystroke(TypingState& state, int64_t now_ns);
+
+// Seconds since the first keystroke, measured at now_ns
+double typingElapsed(const TypingState& state, int64_t now_ns);
+
+// Test duration from the first to the latest keystroke, never below one millisecond
+double typingDuration(const TypingState& state);
+
+// Clear typed text and counters, keeping room for a target of the given length
+void resetTypingState(TypingState& state, size_t target_length);
+
+// Backspace: undo a whole word jump, or remove the last typed character
+void typingBackspace(TypingState& state, const std::string& target);
+
+// Space: at a word boundary types the space, mid-word jumps to the start of the next word
+void typingSpace(TypingState& state, const std::string& target);
+
+// Printable character other than space
+void typingCharacter(TypingState& state, const std::string& target, char c);
+
+// WPM and accuracy from the running counters.
+// Below 50% accuracy WPM is scaled down linearly to prevent the space-mashing exploit.
+void computeTypingStats(size_t correct, size_t typedCount, double elapsed, double& wpm, double& accuracy);
+
+// Key code the typing loop receives for Backspace (same value as ncurses KEY_BACKSPACE)
+static const int kKeyBackspace = 0407;
+
+// Apply one key from the typing loop to the test state.
+// Returns false for keys the state machine does not handle (Enter, ESC, screen hotkeys).
+bool applyTypingKey(TypingState& state, const std::string& target, int ch, int64_t now_ns);
+
+// Recorded key event: time since the previous event and the key code
+struct KeyEvent {
+    uint32_t delta_us;
+    int32_t key;
+};
+
+// Binary test recording (--record / --replay), all fields little-endian:
+//   "WTRP" u16 version  u16 flags  u64 seed  u32 wordCount  u32 targetLength  u32 eventCount
+//   u16 timedSeconds  u16 layoutWidth
+//   target bytes, then eventCount x (u32 delta_us, u16 key)
+// A streamed (timed or endless) test stores every word its stream drew as the target, and
+// the layout width the text scrolled at; timedSeconds is 0 except for timed tests.
+// Version 1 records end the header at eventCount and are always word tests.
+// A recording file holds any number of these records back to back.
+static const char kRecordMagic[4] = { 'W', 'T', 'R', 'P' };
+static const uint16_t kRecordVersion = 2;
+static const uint16_t kRecordVersion1 = 1;
+static const size_t kRecordHeaderSizeV1 = 4 + 2 + 2 + 8 + 4 + 4 + 4;
+static const size_t kRecordHeaderSize = kRecordHeaderSizeV1 + 2 + 2;
+static const size_t kRecordEventSize = 4 + 2;
+
+// Flags stored with each recording
+enum RecordFlags {
+    RECORD_PUNCTUATION = 1,
+    RECORD_NUMBERS = 2,
+    RECORD_WORDLIST = 4,
+    RECORD_WEAK_KEYS = 8,
+    RECORD_STREAMED = 16     // Timed or endless: replayed through a TextStream
+};
+
+// Records the keys of the current test into a ring buffer allocated once per session.
+// Nothing touches the disk until the test completes; if a test outgrows the ring the
+// oldest events are moved to a spill buffer so nothing is lost.
+struct TestRecorder {
+    bool enabled;                   // Set by --record
+    std::string path;               // File that completed tests are appended to
+    uint64_t seed;                  // Seed of the recorded text
+    uint32_t wordCount;
+    uint16_t flags;                 // RecordFlags
+    uint16_t timedSeconds;          // Length of a timed test, else 0
+    int64_t last_ns;                // Timestamp of the previous event
+    std::vector<KeyEvent> ring;     // Power-of-two sized event ring
+    size_t head;                    // Index of the oldest event in the ring
+    size_t count;                   // Events currently in the ring
+    std::vector<KeyEvent> spill;    // Events moved out of a full ring
+
+    TestRecorder() : enabled(false), seed(0), wordCount(0), flags(0), timedSeconds(0), last_ns(0), head(0), count(0) {}
+};
+
+// Global test recorder
+extern TestRecorder testRecorder;
+
+// Enable recording to path, preallocating the event ring
+void enableRecording(TestRecorder& rec, const std::string& path);
+
+// Start recording a new test (discards any unfinished one)
+void recorderBegin(TestRecorder& rec, uint64_t seed, int wordCount, uint16_t flags, int64_t now_ns,
+                   int timedSeconds = 0);
+
+// Append one key event
+void recorderKey(TestRecorder& rec, int64_t now_ns, int key);
+
+// Little-endian readers for the recording format
+uint16_t getU16(const unsigned char* p);
+
+uint32_t getU32(const unsigned char* p);
+
+uint64_t getU64(const unsigned char* p);
+
+// Append the finished test to the recording file. A streamed test passes the words its
+// stream drew and the width of the layout they scrolled in.
+void recorderFinish(TestRecorder& rec, const std::string& target, int layoutWidth = 0);
+
+// One record read back from a recording file
+struct TestRecording {
+    uint16_t version;
+    uint16_t flags;               // RecordFlags
+    uint64_t seed;
+    uint32_t wordCount;
+    int timedSeconds;             // 0 except for timed tests
+    int layoutWidth;              // Width a streamed test scrolled at
+    std::string target;           // The text, or every word a streamed test drew
+    std::vector<KeyEvent> events;
+
+    TestRecording() : version(0), flags(0), seed(0), wordCount(0), timedSeconds(0), layoutWidth(0) {}
+};
+
+enum RecordingStatus {
+    RECORDING_OK,
+    RECORDING_INVALID,     // Bad magic or version, or a streamed record without a width
+    RECORDING_TRUNCATED    // Shorter than its header says
+};
+
+// Decode the record (version 2 or 1) at the start of data, setting size to the bytes it spans
+RecordingStatus readRecording(const unsigned char* data, size_t remaining, TestRecording& record, size_t& size);
+
+// Every player name seen in the score log or the player database, interned once.
+// Ids are dense and stable for the run, so per-player tables can be plain arrays.
+enum NameSource {
+    NAME_HAS_SCORES = 1,    // Name appears in the score history
+    NAME_HAS_PROFILE = 2    // Name has a player profile
+};
+
+struct NameRegistry {
+    std::vector<std::string> names;                  // By id, in first-seen order
+    std::vector<uint8_t> sources;                    // NameSource bits by id
+    std::unordered_map<std::string, uint32_t> ids;   // Name -> id
+
+    NameRegistry() {}
+};
+
+// Global name registry, filled by the score store and the player database
+extern NameRegistry nameRegistry;
+
+// Id of a name, adding it if new, and mark where it was seen
+uint32_t internName(NameRegistry& registry, const std::string& name, uint8_t source);
+
+// Id of a known name, or UINT32_MAX
+uint32_t findName(const NameRegistry& registry, const std::string& name);
+
+// Forget one source for every name (after the history or the profiles are cleared)
+void clearNameSource(NameRegistry& registry, uint8_t source);
+
+// Bounded lock-free queue for exactly one producer thread and one consumer thread.
+// Capacity must be a power of two. The indexes only ever grow; each side owns one of them.
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity) : slots_(capacity), mask_(capacity - 1), head_(0), tail_(0) {}
+
+    // Producer: moves value in, or returns false when the queue is full (value is left untouched)
+    bool push(T& value) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) == slots_.size()) return false;
+        slots_[head & mask_] = std::move(value);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer: false when the queue is empty
+    bool pop(T& value) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire)) return false;
+        value = std::move(slots_[tail & mask_]);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::vector<T> slots_;
+    size_t mask_;
+    alignas(64) std::atomic<size_t> head_;   // Next slot to fill, written by the producer
+    alignas(64) std::atomic<size_t> tail_;   // Next slot to drain, written by the consumer
+};
+
+// Background persistence. Every file the game writes during play (score log appends,
+// players.db, keystats.db, recordings) goes through one worker thread: the UI thread
+// encodes a snapshot, queues it and returns at once. The worker writes whatever has
+// queued up when it wakes, keeping only the newest snapshot of each replaced file.
+// Until startPersistWorker() is called (and after stopPersistWorker()) each write
+// runs on the calling thread, so the benchmarks and --replay need no worker.
+void startPersistWorker();
+
+// Wait until every queued write has reached the disk
+void flushPersistWorker();
+
+// Flush, then stop the worker thread. Safe to call more than once.
+void stopPersistWorker();
+
+// Append-only score history (scores.log), all fields little-endian:
+//   "WTSL" u16 version  u16 recordSize  u64 reserved
+//   then fixed-size records:
+//   name[32]  i64 timestampMs  f32 wpm  f32 accuracy  f32 time  u32 mode
+// Names are NUL-padded (and truncated to fit); mode is the scoreModeKey. Every completed
+// test appends one record; nothing is ever rewritten, so the log keeps the full history.
+// A version 1 log (text dates, f64 fields) is converted once when it is opened.
+static const char kScoreLogMagic[4] = { 'W', 'T', 'S', 'L' };
+static const uint16_t kScoreLogVersion = 2;
+static const size_t kScoreLogHeaderSize = 4 + 2 + 2 + 8;
+static const size_t kScoreNameSize = 32;
+static const size_t kScoreRecordSize = kScoreNameSize + 8 + 4 + 4 + 4 + 4;
+
+// Best scores of one category, bounded to a fixed capacity. Kept as a binary heap
+// with the weakest kept score at the root, so a new score is rejected in O(1) or
+// replaces the root in O(log K).
+static const size_t kTopScoresCapacity = 100;
+
+struct TopScores {
+    std::vector<uint32_t> heap;  // Indexes into ScoreStore::scores
+
+    TopScores() {}
+};
+
+// Score history loaded from the log, with a bounded top-K per mode and overall.
+// Rankings use compareScores; equal scores keep the older one ahead.
+struct ScoreStore {
+    std::string path;                        // Log file
+    std::vector<PlayerScore> scores;         // Every record, in log order
+    TopScores overall;                       // Best scores of all modes
+    std::unordered_map<uint32_t, TopScores> modeTop;  // Best scores per scoreModeKey
+
+    ScoreStore() {}
+};
+
+// Global score history
+extern ScoreStore scoreStore;
+
+// Read the log and build the top-K rankings. If the log does not exist yet, the scores in
+// the old text leaderboard are imported into a new one. A torn record at the end
+// (from a crash mid-append) is cut off.
+void openScoreStore(ScoreStore& store, const std::string& path = "scores.log",
+                    const std::string& legacyPath = "leaderboard.txt");
+
+// Undecoded contents of a version 2 score log (--quick loads it in the background)
+struct ScoreLogImage {
+    std::string path;
+    bool ready;                            // A version 2 log was read into records
+    std::vector<unsigned char> records;    // Its whole records, as stored
+
+    ScoreLogImage() : ready(false) {}
+};
+
+// Read the log's records without decoding them. Touches neither the name registry nor
+// the persistence queue, so it can run on any thread. ready stays false if the log is
+// missing or needs converting.
+void readScoreLog(ScoreLogImage& image, const std::string& path = "scores.log");
+
+// Build the store from an image read by readScoreLog (releasing its buffer), or open the
+// log the usual way if the image is not ready. Runs on the UI thread.
+void openScoreStore(ScoreStore& store, ScoreLogImage& image,
+                    const std::string& legacyPath = "leaderboard.txt");
+
+// Offer one score to the top-K rankings and queue its append to the log.
+// Records other processes appended are picked up by the worker when it appends,
+// and ranked here on the next call.
+void addScore(ScoreStore& store, const PlayerScore& score);
+
+// Best n scores across all modes, best first. Any n is allowed: up to
+// kTopScoresCapacity comes from the kept top-K, beyond that the history is ranked.
+std::vector<PlayerScore> topScores(const ScoreStore& store, size_t n);
+
+// Best n scores for one scoreModeKey, best first (same rules as topScores)
+std::vector<PlayerScore> topScoresForMode(const ScoreStore& store, uint32_t mode, size_t n);
+
+// Every scoreModeKey with at least one score, ascending (by word count, then options)
+std::vector<uint32_t> scoreModes(const ScoreStore& store);
+
+// Erase the whole history, leaving an empty log
+void clearScoreStore(ScoreStore& store);
+
+// Player profiles (players.db), all fields little-endian:
+//   "WTPD" u16 version  u16 recordSize  u32 recordCount  u32 stringTableSize
+//   u32 sessionPlayer  u16 wordCount  u16 customWords  u16 timedSeconds  u16 sessionFlags
+//   u32 sessionChecksum
+//   recordCount x (u32 nameOffset  u16 nameLength  u16 streak  char wormColor[12]
+//                  u32 achievements  i32 currency  u32 checksum)
+//   string table holding the player names back to back
+// The checksum (FNV-1a over the rest of the record) lets a damaged record be skipped; the
+// session block has one the same way. sessionPlayer is a record index, or kNoSessionPlayer.
+// A version 1 file has no session block and is rewritten as version 2 on the next flush.
+static const char kPlayerDbMagic[4] = { 'W', 'T', 'P', 'D' };
+static const uint16_t kPlayerDbVersion = 2;
+static const uint16_t kPlayerDbVersion1 = 1;     // No session block
+static const size_t kPlayerDbHeaderSizeV1 = 4 + 2 + 2 + 4 + 4;
+static const size_t kPlayerSessionSize = 4 + 2 + 2 + 2 + 2 + 4;
+static const size_t kPlayerDbHeaderSize = kPlayerDbHeaderSizeV1 + kPlayerSessionSize;
+static const uint32_t kNoSessionPlayer = 0xFFFFFFFFu;
+static const size_t kPlayerColorSize = 12;
+static const size_t kPlayerRecordSize = 4 + 2 + 2 + kPlayerColorSize + 4 + 4 + 4;
+
+// One player's profile
+struct PlayerRecord {
+    std::string name;
+    std::string wormColor;    // Equipped worm variant
+    uint32_t achievements;    // Unlocked achievement bits
+    int32_t currency;
+    uint16_t streak;          // Accurate tests in a row
+    bool dirty;               // Changed since the last flush - set after editing a field
+
+    PlayerRecord(const std::string& n) : name(n), wormColor("default"), achievements(0), currency(0), streak(0), dirty(true) {}
+};
+
+// Options of the last test started, kept with the profiles so the next launch resumes them
+enum SessionFlags {
+    SESSION_CUSTOM_WORDS = 1,
+    SESSION_PUNCTUATION = 2,
+    SESSION_NUMBERS = 4,
+    SESSION_ENDLESS = 8,
+    SESSION_WEAK_KEYS = 16
+};
+
+struct PlayerSession {
+    std::string player;       // Empty when none was saved; stored as the player's record index
+    uint16_t wordCount;
+    uint16_t customWords;
+    uint16_t timedSeconds;    // 0 for a word-count test
+    uint16_t flags;           // SessionFlags
+    bool dirty;               // Changed since the last flush - set after editing a field
+
+    PlayerSession() : wordCount(0), customWords(0), timedSeconds(0), flags(0), dirty(false) {}
+};
+
+// All player profiles, loaded once. The encoded file is kept in memory so a flush
+// re-encodes only the dirty records; the file itself is always replaced atomically.
+struct PlayerDatabase {
+    std::string path;
+    std::vector<PlayerRecord> players;                  // In file order
+    std::unordered_map<std::string, size_t> index;      // Name -> position in players
+    std::string image;                                  // File contents as last written
+    PlayerSession session;                              // Last player and settings
+    bool rebuild;                                       // Players added or removed since the last flush
+
+    PlayerDatabase() : rebuild(false) {}
+};
+
+// Global player database
+extern PlayerDatabase playerDatabase;
+
+// Load the database. Returns false if the file does not exist yet.
+bool openPlayerDatabase(PlayerDatabase& db, const std::string& path = "players.db");
+
+// Look up a player by name; nullptr if unknown
+PlayerRecord* findPlayer(PlayerDatabase& db, const std::string& name);
+
+// Look up a player, adding a default profile if unknown
+PlayerRecord& upsertPlayer(PlayerDatabase& db, const std::string& name);
+
+// Remove every player
+void clearPlayerDatabase(PlayerDatabase& db);
+
+// Write pending changes: re-encode the dirty records (or everything after players were
+// added or removed) and queue the image to be renamed over the database.
+// Does nothing when nothing changed.
+void flushPlayerDatabase(PlayerDatabase& db);
+
+// Keystroke statistics. Every printable ASCII character (' ' to '~') has a cell, and so
+// does every ordered pair of them; the tables are dense and indexed by character code, so
+// a keystroke updates its counters in O(1) with no lookups or allocation.
+static const int kKeyStatChars = 95;
+static const int kKeyStatBigrams = kKeyStatChars * kKeyStatChars;
+static const int64_t kKeyPauseNs = 2000000000;  // Longer gaps are pauses, not key intervals
+
+struct KeyStat {
+    uint64_t total_us;   // Sum of the timed intervals
+    uint32_t presses;    // Times the character was due
+    uint32_t errors;     // Times it was typed wrong
+    uint32_t timed;      // Presses that came within kKeyPauseNs of the previous one
+};
+
+struct KeyStats {
+    KeyStat keys[kKeyStatChars];        // By expected character
+    KeyStat bigrams[kKeyStatBigrams];   // By previous character * kKeyStatChars + expected character
+};
+
+// Cell of a printable character, or -1
+inline int keyStatIndex(char c) { return (c >= ' ' && c <= '~') ? c - ' ' : -1; }
+
+// Previous keystroke of the running test, for intervals and bigrams
+struct KeyTimer {
+    int64_t last_ns;   // When the previous character was typed; 0 = no chain to extend
+    size_t last_pos;   // Its position in the whole test (TypingState::typedCount() - 1)
+    int last_key;      // Its expected cell
+
+    KeyTimer() : last_ns(0), last_pos(0), last_key(-1) {}
+};
+
+// Zero every counter
+void clearKeyStats(KeyStats& stats);
+
+// Account for one key the typing loop applied; typedBefore is state.typedCount() before it.
+// A key that typed one character scores it against the expected one, timed from the
+// previous character. Anything else (backspace, a word jump) just breaks the chain.
+void keyTimerUpdate(KeyTimer& timer, KeyStats& stats, const TypingState& state, const std::string& target,
+                    size_t typedBefore, int64_t now_ns);
+
+// Add the counters of one test to a profile
+void mergeKeyStats(KeyStats& into, const KeyStats& from);
+
+// Mean interval in milliseconds, 0 if never timed
+double keyStatMeanMs(const KeyStat& stat);
+
+// Cells of a table with at least minTimed timed presses, slowest mean first, at most n
+std::vector<int> slowestKeyStats(const KeyStat* table, int cells, uint32_t minTimed, size_t n);
+
+// Key statistics of every player (keystats.db), all fields little-endian:
+//   "WTKS" u16 version  u16 reserved  u32 playerCount
+//   playerCount x (u16 nameLength  name  u32 entryCount
+//                  entryCount x (u16 cell  u64 totalUs  u32 presses  u32 errors  u32 timed))
+// Only cells that were ever due are stored; cells from kKeyStatChars on are bigrams.
+static const char kKeyStatsMagic[4] = { 'W', 'T', 'K', 'S' };
+static const uint16_t kKeyStatsVersion = 1;
+static const size_t kKeyStatsHeaderSize = 4 + 2 + 2 + 4;
+static const size_t kKeyStatEntrySize = 2 + 8 + 4 + 4 + 4;
+
+// Encoded entries per player; decoded only for the current player
+struct KeyStatsStore {
+    std::string path;
+    std::unordered_map<std::string, std::string> players;  // Name -> u32 entryCount + entries
+};
+
+// Global key statistics store
+extern KeyStatsStore keyStatsStore;
+
+// Load the store; a missing or unreadable file is an empty store
+void openKeyStatsStore(KeyStatsStore& store, const std::string& path = "keystats.db");
+
+// Decode one player's statistics (all zero if the player has none)
+void loadKeyStats(const KeyStatsStore& store, const std::string& name, KeyStats& stats);
+
+// Replace one player's statistics and queue the rewritten file (temp file + rename)
+void saveKeyStats(KeyStatsStore& store, const std::string& name, const KeyStats& stats);
+
+// Remove every player's statistics
+void clearKeyStatsStore(KeyStatsStore& store);
+
+// Alias table (Walker/Vose) over a fixed set of weights: one draw is a uniform column
+// plus one biased coin, O(1) however uneven the weights are.
+struct AliasTable {
+    std::vector<uint32_t> threshold;  // Keep column i when a 32-bit draw is below this
+    std::vector<uint32_t> alias;      // Otherwise take this index
+};
+
+// Build the table in O(n); an empty or all-zero weight list gives an empty table
+void buildAliasTable(AliasTable& table, const std::vector<double>& weights);
+
+// Draw one index with probability proportional to its weight
+uint32_t aliasSample(const AliasTable& table, Pcg32& rng);
+
+// Weak-key practice weight of every word in the pool: 1 plus kWeakKeyBoost times the
+// badness of each bigram the word contains (its leading space included). A bigram is bad
+// in proportion to how much slower than the player's average it is and to its error rate;
+// bigrams with fewer than kWeakKeyMinTimed timed presses do not count.
+static const double kWeakKeyBoost = 4.0;
+static const uint32_t kWeakKeyMinTimed = 3;
+void weakKeyWeights(std::vector<double>& weights, const WordPool& pool, const KeyStats& stats);
+
+// Words for weak-key practice: one alias table per pool and statistics snapshot, built
+// once and reused for every text until either changes
+struct WeakKeySampler {
+    const WordView* words;   // Pool the table was built for
+    size_t count;
+    AliasTable table;
+
+    WeakKeySampler() : words(nullptr), count(0) {}
+};
+
+// Rebuild the sampler for the pool and statistics (call again after the statistics change)
+void prepareWeakKeySampler(WeakKeySampler& sampler, const WordPool& pool, const KeyStats& stats);
+
+// Like generateTargetText, drawing the words through the sampler's alias table
+void generateWeightedText(std::string& target, const WordPool& pool, const WeakKeySampler& sampler,
+                          int wordCount, Pcg32& rng);
+
+// Row/column of one character inside the wrapped text area
+struct TextPos {
+    int row;
+    int col;
+};
+
+// Word-wrap layout of a target text, computed once per text and wrap width.
+// Maps every character index to its (row, col) inside the text area so cursor
+// placement and coloring are O(1) lookups.
+struct TextLayout {
+    int width;                   // Wrap width the layout was built for (0 = not built)
+    int rows;                    // Number of rows used by the text
+    std::vector<TextPos> pos;    // Position of each character, indexed like the target
+
+    TextLayout() : width(0), rows(0) {}
+};
+
+// Lay out target text for a text area of the given width.
+// Spaces never wrap; a word that does not fit on the current row moves to the next one.
+void buildTextLayout(TextLayout& layout, const std::string& target, int width);
+
+// Rolling target text for timed and endless tests. Words are generated just ahead of the
+// cursor and rows above it scroll off the front of both the target and the typed text, so
+// the text, the layout and a full redraw stay the same size however long the test runs.
+static const size_t kStreamInitialLength = 512;  // Characters generated before the first layout
+static const int kStreamRowsAhead = 4;           // Rows kept generated past the cursor
+
+struct TextStream {
+    WordPool pool;
+    Pcg32 rng;
+    const WeakKeySampler* sampler;  // Weighted words for weak-key practice; null draws uniformly
+    std::string* history;           // Every word drawn is appended here too (--record); may be null
+    const std::string* script;      // Replays take the recorded words in order instead of drawing
+    size_t scriptPos;
+
+    TextStream() : sampler(nullptr), history(nullptr), script(nullptr), scriptPos(0) {
+        pool.words = nullptr;
+        pool.count = 0;
+    }
+};
+
+// Start a stream from the pool and seed, replacing the target with its first words.
+// A sampler prepared for the same pool weights the words. Clears the history, if set.
+void streamBegin(TextStream& stream, std::string& target, const WordPool& pool, uint64_t seed,
+                 const WeakKeySampler* sampler);
+
+// Start a stream that replays the space-separated words of a recorded history (--replay).
+// The script must outlive the stream; the stream ends when its words run out.
+void streamReplay(TextStream& stream, std::string& target, const std::string& script);
+
+// Once the cursor reaches the third row of the layout, drop the rows above the one before
+// it and top the text up to kStreamRowsAhead rows past the cursor. The layout must be the
+// current one for target. Returns true when the target changed and needs a new layout.
+bool streamAdvance(TextStream& stream, std::string& target, TypingState& state, const TextLayout& layout);
+
+// Latency histogram for --profile. Buckets are log-linear over nanoseconds: exact below
+// 16 ns, then 16 buckets per power of two, so a percentile is within 1/16 of the true
+// value without keeping every sample.
+static const int kLatencySubBuckets = 16;
+static const int kLatencyBucketCount = 61 * kLatencySubBuckets;
+
+struct LatencyHistogram {
+    std::vector<uint64_t> counts;   // Samples per bucket
+    uint64_t samples;
+    int64_t total_ns;
+    int64_t max_ns;
+
+    LatencyHistogram() : counts(kLatencyBucketCount, 0), samples(0), total_ns(0), max_ns(0) {}
+};
+
+// Add one sample
+void recordLatency(LatencyHistogram& hist, int64_t ns);
+
+// Smallest value that falls into a bucket
+int64_t latencyBucketFloor(int bucket);
+
+// Value at or below which the given fraction (0..1) of samples fall, reported as the
+// upper edge of its bucket and never above the largest sample. 0 when empty.
+int64_t latencyPercentile(const LatencyHistogram& hist, double fraction);
+
+#endif // WORMTYPE_CORE_H
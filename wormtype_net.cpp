@@ -0,0 +1,716 @@
+#include "wormtype_net.h"
+#include "wormtype_core.h"  // Text generation for the server
+#include <algorithm>   // For sorting the results
+#include <cerrno>      // errno after non-blocking calls
+#include <cstdio>      // For printf() logging
+#include <cstdlib>     // For strtol()
+#include <cstring>     // For memset()
+#include <unordered_map>  // Server connections by fd
+#include <fcntl.h>     // For fcntl() O_NONBLOCK
+#include <netdb.h>     // For getaddrinfo()
+#include <netinet/in.h>   // For sockaddr_in and sockaddr_in6
+#include <netinet/tcp.h>  // For TCP_NODELAY
+#include <sys/epoll.h>    // Server event loop
+#include <sys/socket.h>   // Sockets
+#include <unistd.h>    // For read() and close()
+
+// ---------------------------------------------------------------------------
+// Framing
+// ---------------------------------------------------------------------------
+
+static void putU8(std::string& out, uint8_t v) {
+    out += (char)v;
+}
+
+static void putU16(std::string& out, uint16_t v) {
+    out += (char)(v & 0xFF);
+    out += (char)(v >> 8);
+}
+
+static void putU32(std::string& out, uint32_t v) {
+    putU16(out, (uint16_t)(v & 0xFFFF));
+    putU16(out, (uint16_t)(v >> 16));
+}
+
+// Append one framed message
+static void putMessage(std::string& out, RaceMessageType type, const std::string& payload) {
+    putU16(out, (uint16_t)payload.size());
+    putU8(out, (uint8_t)type);
+    out += payload;
+}
+
+// Take the next complete message off the front of a receive buffer.
+// Returns false when the buffer does not hold a whole message yet.
+static bool takeMessage(std::string& in, size_t& consumed, uint8_t& type, std::string& payload) {
+    if (in.size() - consumed < kRaceFrameHeaderSize) return false;
+    const unsigned char* p = (const unsigned char*)in.data() + consumed;
+    size_t length = getU16(p);
+    if (in.size() - consumed < kRaceFrameHeaderSize + length) return false;
+    type = p[2];
+    payload.assign(in, consumed + kRaceFrameHeaderSize, length);
+    consumed += kRaceFrameHeaderSize + length;
+    return true;
+}
+
+// Send as much queued output as the socket takes without blocking.
+// Returns false if the connection failed.
+static bool flushOutput(int fd, std::string& out) {
+    size_t done = 0;
+    while (done < out.size()) {
+        ssize_t n = send(fd, out.data() + done, out.size() - done, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return false;
+        }
+        done += (size_t)n;
+    }
+    out.erase(0, done);
+    return true;
+}
+
+// Read everything available without blocking. Returns false on EOF or error.
+static bool readInput(int fd, std::string& in) {
+    char buffer[4096];
+    while (true) {
+        ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+        if (n > 0) {
+            in.append(buffer, (size_t)n);
+            continue;
+        }
+        if (n == 0) return false;
+        if (errno == EINTR) continue;
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+}
+
+static bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+// Printable ASCII only, at most kRaceMaxName characters
+static std::string cleanRacerName(const std::string& name) {
+    std::string clean;
+    for (size_t i = 0; i < name.size() && clean.size() < kRaceMaxName; i++) {
+        if (name[i] >= 32 && name[i] <= 126) clean += name[i];
+    }
+    return clean.empty() ? "RACER" : clean;
+}
+
+// ---------------------------------------------------------------------------
+// Client
+// ---------------------------------------------------------------------------
+
+bool parseRaceAddress(const std::string& address, std::string& host, int& port, std::string& error) {
+    size_t colon = std::string::npos;  // Before the port, if one is given
+    if (!address.empty() && address[0] == '[') {
+        // Bracketed IPv6 literal: [addr] or [addr]:port
+        size_t bracket = address.find(']');
+        if (bracket == std::string::npos) {
+            error = "missing ']'";
+            return false;
+        }
+        host = address.substr(1, bracket - 1);
+        if (bracket + 1 < address.size()) {
+            if (address[bracket + 1] != ':') {
+                error = "expected ':' after ']'";
+                return false;
+            }
+            colon = bracket + 1;
+        }
+    } else {
+        colon = address.find(':');
+        if (colon != std::string::npos && address.find(':', colon + 1) != std::string::npos) {
+            error = "IPv6 addresses must be written as [addr]:port";
+            return false;
+        }
+        host = address.substr(0, colon);
+    }
+
+    port = kRaceDefaultPort;
+    if (colon != std::string::npos) {
+        char* end = nullptr;
+        long value = strtol(address.c_str() + colon + 1, &end, 10);
+        if (end == address.c_str() + colon + 1 || *end != '\0' || value <= 0 || value > 65535) {
+            error = "port must be 1-65535";
+            return false;
+        }
+        port = (int)value;
+    }
+    if (host.empty()) host = "127.0.0.1";
+    return true;
+}
+
+bool raceConnect(RaceClient& client, const std::string& host, int port, std::string& error) {
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* addresses = nullptr;
+    int status = getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints, &addresses);
+    if (status != 0) {
+        error = gai_strerror(status);
+        return false;
+    }
+
+    int fd = -1;
+    for (struct addrinfo* a = addresses; a != nullptr && fd < 0; a = a->ai_next) {
+        fd = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (fd < 0) continue;
+        if (connect(fd, a->ai_addr, a->ai_addrlen) != 0) {
+            error = strerror(errno);
+            close(fd);
+            fd = -1;
+        }
+    }
+    freeaddrinfo(addresses);
+    if (fd < 0) return false;
+
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));  // Small updates, sent at once
+    setNonBlocking(fd);
+    client = RaceClient();
+    client.fd = fd;
+    return true;
+}
+
+void raceHello(RaceClient& client, const std::string& name) {
+    putMessage(client.out, RACE_HELLO, cleanRacerName(name));
+}
+
+// Racer with the given id, adding it if unknown
+static RacerInfo& racerEntry(RaceClient& client, uint8_t id) {
+    for (size_t i = 0; i < client.racers.size(); i++) {
+        if (client.racers[i].id == id) return client.racers[i];
+    }
+    client.racers.push_back(RacerInfo());
+    client.racers.back().id = id;
+    return client.racers.back();
+}
+
+const RacerInfo* findRacer(const RaceClient& client, int id) {
+    for (size_t i = 0; i < client.racers.size(); i++) {
+        if (client.racers[i].id == id) return &client.racers[i];
+    }
+    return nullptr;
+}
+
+// Apply one message from the server
+static void applyServerMessage(RaceClient& client, uint8_t type, const std::string& payload, int64_t now_ns) {
+    const unsigned char* p = (const unsigned char*)payload.data();
+    size_t size = payload.size();
+    if (type == RACE_WELCOME && size >= 1) {
+        client.id = p[0];
+    } else if (type == RACE_ROSTER && size >= 1) {
+        // Keep the progress of racers that are still here
+        std::vector<RacerInfo> previous;
+        previous.swap(client.racers);
+        size_t at = 1;
+        for (size_t i = 0; i < p[0] && at + 2 <= size; i++) {
+            uint8_t id = p[at];
+            size_t nameLength = p[at + 1];
+            if (at + 2 + nameLength > size) break;
+            RacerInfo racer;
+            for (size_t k = 0; k < previous.size(); k++) {
+                if (previous[k].id == id) racer = previous[k];
+            }
+            racer.id = id;
+            racer.name = payload.substr(at + 2, nameLength);
+            client.racers.push_back(racer);
+            at += 2 + nameLength;
+        }
+    } else if (type == RACE_START && size >= 2) {
+        client.target = payload.substr(2);
+        client.start_ns = now_ns + (int64_t)getU16(p) * 1000000;
+        client.started = true;
+        client.over = false;
+        client.sent_position = 0;
+        client.sent_errors = 0;
+        client.last_send_ns = 0;
+        for (size_t i = 0; i < client.racers.size(); i++) {
+            RacerInfo& racer = client.racers[i];
+            racer.position = 0;
+            racer.errors = 0;
+            racer.place = 0;
+            racer.wpm = racer.accuracy = 0.0f;
+        }
+    } else if (type == RACE_STATE && size >= 1) {
+        for (size_t i = 0, at = 1; i < p[0] && at + 8 <= size; i++, at += 8) {
+            RacerInfo& racer = racerEntry(client, p[at]);
+            racer.position = getU32(p + at + 1);
+            racer.errors = getU16(p + at + 5);
+            racer.place = p[at + 7];
+        }
+    } else if (type == RACE_OVER && size >= 1) {
+        for (size_t i = 0, at = 1; i < p[0] && at + 6 <= size; i++, at += 6) {
+            RacerInfo& racer = racerEntry(client, p[at]);
+            racer.place = p[at + 1];
+            racer.wpm = getU16(p + at + 2) / 10.0f;
+            racer.accuracy = getU16(p + at + 4) / 10.0f;
+        }
+        client.over = true;
+    }
+}
+
+bool racePump(RaceClient& client, int64_t now_ns) {
+    if (client.fd < 0) return false;
+    bool open = readInput(client.fd, client.in);
+
+    size_t consumed = 0;
+    uint8_t type;
+    std::string payload;
+    while (takeMessage(client.in, consumed, type, payload)) {
+        applyServerMessage(client, type, payload, now_ns);
+    }
+    client.in.erase(0, consumed);
+
+    if (!open || !flushOutput(client.fd, client.out)) {
+        raceDisconnect(client);
+        return false;
+    }
+    return true;
+}
+
+void raceSendProgress(RaceClient& client, uint32_t position, uint16_t errors, int64_t now_ns, bool force) {
+    if (position == client.sent_position && errors == client.sent_errors) return;
+    if (!force && now_ns - client.last_send_ns < kRaceProgressIntervalNs) return;
+    std::string payload;
+    putU32(payload, position);
+    putU16(payload, errors);
+    putMessage(client.out, RACE_PROGRESS, payload);
+    client.sent_position = position;
+    client.sent_errors = errors;
+    client.last_send_ns = now_ns;
+}
+
+void raceSendFinish(RaceClient& client, double elapsed, double wpm, double accuracy) {
+    std::string payload;
+    putU32(payload, (uint32_t)(elapsed * 1000.0));
+    putU16(payload, (uint16_t)std::min(wpm * 10.0 + 0.5, 65535.0));
+    putU16(payload, (uint16_t)std::min(accuracy * 10.0 + 0.5, 65535.0));
+    putMessage(client.out, RACE_FINISH, payload);
+}
+
+void raceDisconnect(RaceClient& client) {
+    if (client.fd >= 0) close(client.fd);
+    client.fd = -1;
+}
+
+// ---------------------------------------------------------------------------
+// Server
+// ---------------------------------------------------------------------------
+
+static const size_t kRaceMaxQueued = 1 << 20;  // A client this far behind is dropped
+
+// One accepted connection
+struct RaceConnection {
+    int fd;
+    std::string in;
+    std::string out;
+    bool writing;        // EPOLLOUT registered because out did not drain
+    int id;              // Racer id once the hello arrived, -1 before
+    std::string name;
+    bool inRace;         // Was there when the current race started
+    uint32_t position;
+    uint16_t errors;
+    uint8_t place;
+    uint16_t wpm10;      // Final results * 10
+    uint16_t accuracy10;
+
+    RaceConnection() : fd(-1), writing(false), id(-1), inRace(false), position(0), errors(0), place(0),
+                       wpm10(0), accuracy10(0) {}
+};
+
+struct RaceServer {
+    int epoll_fd;
+    int listen_fd;
+    std::unordered_map<int, RaceConnection> connections;  // By fd; references stay valid
+    std::string target;
+    bool racing;
+    uint8_t finished;          // Racers across the line in the current race
+    bool stateDirty;           // Progress changed since the last RACE_STATE
+    int64_t lastStateNs;
+    int wordCount;
+    bool includePunctuation;
+    bool includeNumbers;
+    std::string stdinLine;
+};
+
+struct ById {
+    bool operator()(const RaceConnection* a, const RaceConnection* b) const { return a->id < b->id; }
+};
+
+// Finishers first, in place order
+struct ByPlace {
+    bool operator()(const RaceConnection* a, const RaceConnection* b) const {
+        int pa = a->place == 0 ? 256 : a->place;
+        int pb = b->place == 0 ? 256 : b->place;
+        return pa < pb;
+    }
+};
+
+// Connections that said hello, by racer id
+static std::vector<RaceConnection*> serverRacers(RaceServer& server) {
+    std::vector<RaceConnection*> racers;
+    for (std::unordered_map<int, RaceConnection>::iterator it = server.connections.begin();
+         it != server.connections.end(); ++it) {
+        if (it->second.id >= 0) racers.push_back(&it->second);
+    }
+    std::sort(racers.begin(), racers.end(), ById());
+    return racers;
+}
+
+// Queue a message for every racer
+static void broadcast(RaceServer& server, RaceMessageType type, const std::string& payload) {
+    std::string message;
+    putMessage(message, type, payload);
+    for (std::unordered_map<int, RaceConnection>::iterator it = server.connections.begin();
+         it != server.connections.end(); ++it) {
+        if (it->second.id >= 0) it->second.out += message;
+    }
+}
+
+static void broadcastRoster(RaceServer& server) {
+    std::vector<RaceConnection*> racers = serverRacers(server);
+    std::string payload;
+    putU8(payload, (uint8_t)racers.size());
+    for (size_t i = 0; i < racers.size(); i++) {
+        putU8(payload, (uint8_t)racers[i]->id);
+        putU8(payload, (uint8_t)racers[i]->name.size());
+        payload += racers[i]->name;
+    }
+    broadcast(server, RACE_ROSTER, payload);
+}
+
+static void broadcastState(RaceServer& server, int64_t now_ns) {
+    std::vector<RaceConnection*> racers = serverRacers(server);
+    std::string payload;
+    putU8(payload, 0);  // Count, patched below
+    uint8_t count = 0;
+    for (size_t i = 0; i < racers.size(); i++) {
+        if (!racers[i]->inRace) continue;
+        putU8(payload, (uint8_t)racers[i]->id);
+        putU32(payload, racers[i]->position);
+        putU16(payload, racers[i]->errors);
+        putU8(payload, racers[i]->place);
+        count++;
+    }
+    payload[0] = (char)count;
+    broadcast(server, RACE_STATE, payload);
+    server.stateDirty = false;
+    server.lastStateNs = now_ns;
+}
+
+static void startRace(RaceServer& server) {
+    std::vector<RaceConnection*> racers = serverRacers(server);
+    if (racers.empty()) {
+        printf("No racers have joined yet\n");
+        fflush(stdout);
+        return;
+    }
+
+    Pcg32 rng(nextTextSeed());
+    generateTargetText(server.target, selectWordPool(server.includePunctuation, server.includeNumbers),
+                       server.wordCount, rng);
+    if (server.target.size() > kRaceMaxTarget) server.target.resize(kRaceMaxTarget);
+    for (size_t i = 0; i < racers.size(); i++) {
+        racers[i]->inRace = true;
+        racers[i]->position = 0;
+        racers[i]->errors = 0;
+        racers[i]->place = 0;
+    }
+    server.racing = true;
+    server.finished = 0;
+    server.stateDirty = true;
+
+    std::string payload;
+    putU16(payload, (uint16_t)kRaceCountdownMs);
+    payload += server.target;
+    broadcast(server, RACE_START, payload);
+    printf("Race started with %zu racers: %s\n", racers.size(), server.target.c_str());
+    fflush(stdout);
+}
+
+static void endRace(RaceServer& server) {
+    std::vector<RaceConnection*> racers = serverRacers(server);
+    std::string payload;
+    putU8(payload, 0);  // Count, patched below
+    uint8_t count = 0;
+    for (size_t i = 0; i < racers.size(); i++) {
+        if (!racers[i]->inRace) continue;
+        putU8(payload, (uint8_t)racers[i]->id);
+        putU8(payload, racers[i]->place);
+        putU16(payload, racers[i]->wpm10);
+        putU16(payload, racers[i]->accuracy10);
+        count++;
+    }
+    payload[0] = (char)count;
+    broadcast(server, RACE_OVER, payload);
+
+    // Log the finishers in order, then everyone who did not finish
+    std::stable_sort(racers.begin(), racers.end(), ByPlace());
+    printf("Race over\n");
+    for (size_t i = 0; i < racers.size(); i++) {
+        if (!racers[i]->inRace) continue;
+        racers[i]->inRace = false;
+        if (racers[i]->place == 0) {
+            printf("  DNF  %-20s %u/%zu\n", racers[i]->name.c_str(), racers[i]->position, server.target.size());
+        } else {
+            printf("  %3u  %-20s %5.1f WPM  %5.1f%%\n", racers[i]->place, racers[i]->name.c_str(),
+                   racers[i]->wpm10 / 10.0, racers[i]->accuracy10 / 10.0);
+        }
+    }
+    fflush(stdout);
+    server.racing = false;
+}
+
+// End the race once every racer still connected has finished
+static void checkRaceDone(RaceServer& server) {
+    if (!server.racing) return;
+    std::vector<RaceConnection*> racers = serverRacers(server);
+    for (size_t i = 0; i < racers.size(); i++) {
+        if (racers[i]->inRace && racers[i]->place == 0) return;
+    }
+    endRace(server);
+}
+
+// Smallest racer id not in use, or -1 when the race is full
+static int freeRacerId(RaceServer& server) {
+    std::vector<RaceConnection*> racers = serverRacers(server);
+    if (racers.size() >= kRaceMaxRacers) return -1;
+    int id = 0;
+    for (size_t i = 0; i < racers.size() && racers[i]->id == id; i++) id++;
+    return id;
+}
+
+// Apply one message from a client
+static void applyClientMessage(RaceServer& server, RaceConnection& conn, uint8_t type, const std::string& payload) {
+    const unsigned char* p = (const unsigned char*)payload.data();
+    if (type == RACE_HELLO && conn.id < 0) {
+        conn.id = freeRacerId(server);
+        if (conn.id < 0) return;  // Full - ignored until someone leaves
+        conn.name = cleanRacerName(payload);
+        std::string welcome;
+        putU8(welcome, (uint8_t)conn.id);
+        putMessage(conn.out, RACE_WELCOME, welcome);
+        broadcastRoster(server);
+        printf("%s joined (%zu racers)\n", conn.name.c_str(), serverRacers(server).size());
+        fflush(stdout);
+    } else if (type == RACE_PROGRESS && payload.size() >= 6 && conn.inRace && conn.place == 0) {
+        conn.position = std::min(getU32(p), (uint32_t)server.target.size());
+        conn.errors = getU16(p + 4);
+        server.stateDirty = true;
+    } else if (type == RACE_FINISH && payload.size() >= 8 && conn.inRace && conn.place == 0) {
+        conn.position = (uint32_t)server.target.size();
+        conn.place = ++server.finished;
+        conn.wpm10 = getU16(p + 4);
+        conn.accuracy10 = getU16(p + 6);
+        server.stateDirty = true;
+        printf("%s finished #%u: %.1f WPM, %.1f%%\n", conn.name.c_str(), conn.place, conn.wpm10 / 10.0,
+               conn.accuracy10 / 10.0);
+        fflush(stdout);
+        checkRaceDone(server);
+    }
+}
+
+static void dropConnection(RaceServer& server, int fd) {
+    std::unordered_map<int, RaceConnection>::iterator it = server.connections.find(fd);
+    if (it == server.connections.end()) return;
+    bool wasRacer = it->second.id >= 0;
+    if (wasRacer) {
+        printf("%s left\n", it->second.name.c_str());
+        fflush(stdout);
+    }
+    epoll_ctl(server.epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    server.connections.erase(it);
+    if (wasRacer) {
+        broadcastRoster(server);
+        checkRaceDone(server);
+    }
+}
+
+// Watch for output space only while a connection has a backlog
+static void updateInterest(RaceServer& server, RaceConnection& conn) {
+    bool want = !conn.out.empty();
+    if (want == conn.writing) return;
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN | EPOLLRDHUP | (want ? (uint32_t)EPOLLOUT : 0u);
+    ev.data.fd = conn.fd;
+    epoll_ctl(server.epoll_fd, EPOLL_CTL_MOD, conn.fd, &ev);
+    conn.writing = want;
+}
+
+static void acceptConnections(RaceServer& server) {
+    while (true) {
+        int fd = accept(server.listen_fd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            return;  // EAGAIN - nothing more waiting
+        }
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        setNonBlocking(fd);
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.fd = fd;
+        if (epoll_ctl(server.epoll_fd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            close(fd);
+            continue;
+        }
+        RaceConnection& conn = server.connections[fd];
+        conn.fd = fd;
+    }
+}
+
+// Enter starts a race, or ends the current one early. Returns false when stdin closes.
+static bool readConsole(RaceServer& server) {
+    char buffer[256];
+    ssize_t n = read(STDIN_FILENO, buffer, sizeof(buffer));
+    if (n == 0) return false;
+    if (n < 0) return errno == EINTR || errno == EAGAIN;
+    for (ssize_t i = 0; i < n; i++) {
+        if (buffer[i] != '\n') continue;
+        if (server.racing) {
+            endRace(server);
+        } else {
+            startRace(server);
+        }
+    }
+    return true;
+}
+
+int runRaceServer(int port, int wordCount, bool includePunctuation, bool includeNumbers) {
+    RaceServer server;
+    server.racing = false;
+    server.finished = 0;
+    server.stateDirty = false;
+    server.lastStateNs = 0;
+    server.wordCount = wordCount;
+    server.includePunctuation = includePunctuation;
+    server.includeNumbers = includeNumbers;
+
+    // One dual-stack socket takes IPv4 and IPv6 racers; IPv4 only where there is no IPv6
+    int one = 1;
+    int zero = 0;
+    struct sockaddr_in6 address6;
+    memset(&address6, 0, sizeof(address6));
+    address6.sin6_family = AF_INET6;
+    address6.sin6_addr = in6addr_any;
+    address6.sin6_port = htons((uint16_t)port);
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons((uint16_t)port);
+    struct sockaddr* bound = (struct sockaddr*)&address6;
+    socklen_t boundSize = sizeof(address6);
+
+    server.listen_fd = socket(AF_INET6, SOCK_STREAM, 0);
+    if (server.listen_fd >= 0) {
+        setsockopt(server.listen_fd, IPPROTO_IPV6, IPV6_V6ONLY, &zero, sizeof(zero));
+    } else {
+        server.listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+        bound = (struct sockaddr*)&address;
+        boundSize = sizeof(address);
+    }
+    if (server.listen_fd < 0) {
+        fprintf(stderr, "wormtype: could not create the race socket: %s\n", strerror(errno));
+        return 1;
+    }
+    setsockopt(server.listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(server.listen_fd, bound, boundSize) != 0 ||
+        listen(server.listen_fd, 64) != 0) {
+        fprintf(stderr, "wormtype: could not listen on port %d: %s\n", port, strerror(errno));
+        close(server.listen_fd);
+        return 1;
+    }
+    setNonBlocking(server.listen_fd);
+
+    server.epoll_fd = epoll_create1(0);
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = server.listen_fd;
+    epoll_ctl(server.epoll_fd, EPOLL_CTL_ADD, server.listen_fd, &ev);
+    ev.data.fd = STDIN_FILENO;
+    epoll_ctl(server.epoll_fd, EPOLL_CTL_ADD, STDIN_FILENO, &ev);
+
+    printf("Race server listening on port %d - press Enter to start a race of %d words\n", port, wordCount);
+    fflush(stdout);
+
+    struct epoll_event events[64];
+    bool running = true;
+    while (running) {
+        // Sleep until input, or until held-back progress is due to go out
+        int timeout_ms = -1;
+        if (server.stateDirty) {
+            int64_t wait_ns = server.lastStateNs + kRaceProgressIntervalNs - monotonicNanos();
+            timeout_ms = wait_ns > 0 ? (int)((wait_ns + 999999) / 1000000) : 0;
+        }
+        int count = epoll_wait(server.epoll_fd, events, 64, timeout_ms);
+        if (count < 0 && errno != EINTR) break;
+
+        for (int i = 0; i < count; i++) {
+            int fd = events[i].data.fd;
+            if (fd == server.listen_fd) {
+                acceptConnections(server);
+                continue;
+            }
+            if (fd == STDIN_FILENO) {
+                if (!readConsole(server)) running = false;
+                continue;
+            }
+
+            std::unordered_map<int, RaceConnection>::iterator it = server.connections.find(fd);
+            if (it == server.connections.end()) continue;
+            RaceConnection& conn = it->second;
+            bool open = !(events[i].events & (EPOLLERR | EPOLLHUP));
+            if (open && (events[i].events & (EPOLLIN | EPOLLRDHUP))) {
+                open = readInput(fd, conn.in);
+                size_t consumed = 0;
+                uint8_t type;
+                std::string payload;
+                while (takeMessage(conn.in, consumed, type, payload)) {
+                    applyClientMessage(server, conn, type, payload);
+                }
+                conn.in.erase(0, consumed);
+            }
+            if (!open) dropConnection(server, fd);
+        }
+
+        if (server.stateDirty && monotonicNanos() - server.lastStateNs >= kRaceProgressIntervalNs) {
+            broadcastState(server, monotonicNanos());
+        }
+
+        // Send what was queued; a client that stops reading is dropped. A drop queues a new
+        // roster (and maybe the results) for the others, so flush again until none fail.
+        std::vector<int> failed;
+        do {
+            failed.clear();
+            for (std::unordered_map<int, RaceConnection>::iterator it = server.connections.begin();
+                 it != server.connections.end(); ++it) {
+                RaceConnection& conn = it->second;
+                if (!conn.out.empty() && (!flushOutput(conn.fd, conn.out) || conn.out.size() > kRaceMaxQueued)) {
+                    failed.push_back(conn.fd);
+                    continue;
+                }
+                updateInterest(server, conn);
+            }
+            for (size_t i = 0; i < failed.size(); i++) dropConnection(server, failed[i]);
+        } while (!failed.empty());
+    }
+
+    std::vector<int> fds;
+    for (std::unordered_map<int, RaceConnection>::iterator it = server.connections.begin();
+         it != server.connections.end(); ++it) {
+        fds.push_back(it->first);
+    }
+    for (size_t i = 0; i < fds.size(); i++) close(fds[i]);
+    close(server.listen_fd);
+    close(server.epoll_fd);
+    return 0;
+}
@@ -0,0 +1,107 @@
+// Race mode networking (--host / --join). The server is headless: one epoll loop accepts
+// racers, hands each race's target text to everyone and relays the aggregated progress.
+// Clients keep a non-blocking socket that the typing frame loop pumps once per frame.
+// Nothing here depends on ncurses.
+#ifndef WORMTYPE_NET_H
+#define WORMTYPE_NET_H
+
+#include <string>      // String class
+#include <vector>      // Dynamic arrays
+#include <cstdint>     // Fixed-width integers
+
+// Wire format over TCP, all fields little-endian. Every message is framed as
+//   u16 payloadLength  u8 type  payload
+// Client to server:
+//   RACE_HELLO     name bytes
+//   RACE_PROGRESS  u32 position  u16 errors             (sent when changed, rate-limited)
+//   RACE_FINISH    u32 elapsedMs  u16 wpm*10  u16 accuracy*10
+// Server to client:
+//   RACE_WELCOME   u8 racerId
+//   RACE_ROSTER    u8 count, count x (u8 racerId  u8 nameLength  name)
+//   RACE_START     u16 countdownMs, then the target text
+//   RACE_STATE     u8 count, count x (u8 racerId  u32 position  u16 errors  u8 place)
+//   RACE_OVER      u8 count, count x (u8 racerId  u8 place  u16 wpm*10  u16 accuracy*10)
+enum RaceMessageType {
+    RACE_HELLO = 1,
+    RACE_PROGRESS = 2,
+    RACE_FINISH = 3,
+    RACE_WELCOME = 16,
+    RACE_ROSTER = 17,
+    RACE_START = 18,
+    RACE_STATE = 19,
+    RACE_OVER = 20
+};
+
+static const size_t kRaceFrameHeaderSize = 2 + 1;
+static const int kRaceDefaultPort = 7717;
+static const size_t kRaceMaxRacers = 64;
+static const size_t kRaceMaxName = 32;
+static const size_t kRaceMaxTarget = 60000;                // Fits one frame
+static const int64_t kRaceProgressIntervalNs = 100000000;  // Client progress and server state: 10/s
+static const int kRaceCountdownMs = 3000;
+
+// One racer as the clients see it
+struct RacerInfo {
+    uint8_t id;
+    std::string name;
+    uint32_t position;  // Characters typed in the current race
+    uint16_t errors;
+    uint8_t place;      // Finishing place, 0 while racing or not in the race
+    float wpm;          // Final results, from RACE_OVER
+    float accuracy;
+
+    RacerInfo() : id(0), position(0), errors(0), place(0), wpm(0.0f), accuracy(0.0f) {}
+};
+
+// Client side of a race connection
+struct RaceClient {
+    int fd;                          // Non-blocking socket, -1 once closed
+    std::string in;                  // Received bytes not yet parsed into messages
+    std::string out;                 // Queued bytes the socket has not taken yet
+    int id;                          // Our racer id, -1 until welcomed
+    std::vector<RacerInfo> racers;   // Roster in join order, with the latest progress
+    bool started;                    // A RACE_START arrived and has not been taken yet
+    bool over;                       // A RACE_OVER arrived and has not been taken yet
+    std::string target;              // Text of the current race
+    int64_t start_ns;                // Local monotonic time the race starts (after the countdown)
+    uint32_t sent_position;          // Progress last queued to the server
+    uint16_t sent_errors;
+    int64_t last_send_ns;
+
+    RaceClient() : fd(-1), id(-1), started(false), over(false), start_ns(0), sent_position(0),
+                   sent_errors(0), last_send_ns(0) {}
+};
+
+// Split "host:port", "[ipv6]:port" (or either without the port) into its parts.
+// Returns false with a message in error on a bad port or an unbracketed IPv6 address.
+bool parseRaceAddress(const std::string& address, std::string& host, int& port, std::string& error);
+
+// Connect (blocking, before the UI starts) and switch the socket to non-blocking.
+// Returns false with a message in error if the server cannot be reached.
+bool raceConnect(RaceClient& client, const std::string& host, int port, std::string& error);
+
+// Queue the hello that joins the race under the given name
+void raceHello(RaceClient& client, const std::string& name);
+
+// Read whatever arrived, apply every complete message and flush queued output.
+// Never blocks. Returns false once the connection is gone.
+bool racePump(RaceClient& client, int64_t now_ns);
+
+// Queue our progress if it changed and the last update is at least kRaceProgressIntervalNs old
+// (or always when force is set, e.g. on the final keystroke)
+void raceSendProgress(RaceClient& client, uint32_t position, uint16_t errors, int64_t now_ns, bool force);
+
+// Queue our final result
+void raceSendFinish(RaceClient& client, double elapsed, double wpm, double accuracy);
+
+// Close the socket
+void raceDisconnect(RaceClient& client);
+
+// Racer with the given id, or nullptr
+const RacerInfo* findRacer(const RaceClient& client, int id);
+
+// Run the race server on the given port until stdin closes. Enter on stdin starts a race
+// of wordCount words (or ends one early); progress is logged to stdout.
+int runRaceServer(int port, int wordCount, bool includePunctuation, bool includeNumbers);
+
+#endif // WORMTYPE_NET_H
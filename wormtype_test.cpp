@@ -0,0 +1,375 @@
+// Round-trip and corruption checks for the on-disk formats: the score log (WTSL), the
+// player database (WTPD), key statistics (WTKS) and test recordings (WTRP). Each format
+// is written through the core, read back and compared, then damaged on disk to check
+// that the readers reject or skip what they cannot trust.
+//
+// Usage: wormtype_test   (exit status 1 if any check fails; run by ctest)
+#include "wormtype_core.h"
+
+#include <cstdio>      // printf
+#include <cstring>     // memcmp
+#include <fstream>     // Reading and patching the files
+#include <iterator>    // For reading whole files
+#include <string>      // String class
+#include <vector>      // Dynamic arrays
+#include <unistd.h>    // For getpid() and unlink()
+
+static int checks = 0;
+static int failures = 0;
+
+static void check(bool ok, const std::string& what) {
+    checks++;
+    if (!ok) {
+        fprintf(stderr, "FAIL: %s\n", what.c_str());
+        failures++;
+    }
+}
+
+static std::string tempPath(const std::string& suffix) {
+    return "/tmp/wormtype_test_" + std::to_string(getpid()) + suffix;
+}
+
+static std::string readFile(const std::string& path) {
+    std::ifstream file(path.c_str(), std::ios::binary);
+    return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+}
+
+static void writeFile(const std::string& path, const std::string& data) {
+    std::ofstream file(path.c_str(), std::ios::binary | std::ios::trunc);
+    file.write(data.data(), (std::streamsize)data.size());
+}
+
+// ---------------------------------------------------------------------------
+// Score log
+// ---------------------------------------------------------------------------
+
+static void testScoreLog() {
+    std::string path = tempPath(".log");
+    std::string legacyPath = tempPath("_missing.txt");
+    unlink(path.c_str());
+
+    ScoreStore store;
+    openScoreStore(store, path, legacyPath);
+    check(store.scores.empty(), "score log: a new log is empty");
+    check(readFile(path).size() == kScoreLogHeaderSize, "score log: a new log holds just the header");
+
+    addScore(store, makePlayerScore("ALICE", 71.5, 98.25, 20.5, 25, true, false, 1000));
+    addScore(store, makePlayerScore("BOB", 88.0, 93.5, 12.0, 10, false, true, 2000));
+    PlayerScore timed = makePlayerScore("ALICE", 64.0, 99.0, 30.0, 0, false, false, 3000);
+    timed.mode = timedModeKey(30, false, false);
+    addScore(store, timed);
+
+    ScoreStore reopened;
+    openScoreStore(reopened, path, legacyPath);
+    check(reopened.scores.size() == 3, "score log: every record reads back");
+    if (reopened.scores.size() == 3) {
+        for (size_t i = 0; i < 3; i++) {
+            const PlayerScore& a = store.scores[i];
+            const PlayerScore& b = reopened.scores[i];
+            check(a.name() == b.name() && a.timestampMs == b.timestampMs && a.wpm == b.wpm &&
+                  a.accuracy == b.accuracy && a.time == b.time && a.mode == b.mode,
+                  "score log: record " + std::to_string(i) + " round-trips");
+        }
+        check(reopened.scores[2].isTimed() && reopened.scores[2].timedSeconds() == 30,
+              "score log: the timed mode round-trips");
+    }
+    std::vector<PlayerScore> top = topScores(reopened, 10);
+    check(top.size() == 3 && top[0].name() == "BOB", "score log: rankings rebuild on open");
+
+    // A torn record from a crash mid-append is cut off; the whole ones stay
+    std::string image = readFile(path);
+    writeFile(path, image + std::string(kScoreRecordSize / 2, 'x'));
+    openScoreStore(reopened, path, legacyPath);
+    check(reopened.scores.size() == 3, "score log: a torn record is skipped");
+    check(readFile(path) == image, "score log: a torn record is cut off the file");
+
+    // The background loader's path reads the same records
+    ScoreLogImage background;
+    readScoreLog(background, path);
+    check(background.ready && background.records.size() == 3 * kScoreRecordSize,
+          "score log: readScoreLog takes every whole record");
+    openScoreStore(reopened, background, legacyPath);
+    check(reopened.scores.size() == 3 && reopened.scores[1].name() == "BOB",
+          "score log: a store built from the image matches");
+
+    // Another version is not a score log: nothing is read and nothing is written to it
+    std::string wrongVersion = image;
+    wrongVersion[4] = 9;
+    writeFile(path, wrongVersion);
+    openScoreStore(reopened, path, legacyPath);
+    check(reopened.scores.empty(), "score log: a wrong version is rejected");
+    addScore(reopened, makePlayerScore("CAROL", 50.0, 90.0, 10.0, 5, false, false, 4000));
+    check(readFile(path) == wrongVersion, "score log: a wrong version is left untouched");
+    readScoreLog(background, path);
+    check(!background.ready, "score log: readScoreLog rejects a wrong version");
+
+    // Bad magic is rejected the same way
+    std::string badMagic = image;
+    badMagic[0] = 'X';
+    writeFile(path, badMagic);
+    openScoreStore(reopened, path, legacyPath);
+    check(reopened.scores.empty(), "score log: bad magic is rejected");
+
+    unlink(path.c_str());
+}
+
+// ---------------------------------------------------------------------------
+// Player database
+// ---------------------------------------------------------------------------
+
+static void addPlayers(PlayerDatabase& db) {
+    PlayerRecord& alice = upsertPlayer(db, "ALICE");
+    alice.wormColor = "green";
+    alice.achievements = 0x15;
+    alice.currency = -3;
+    alice.streak = 7;
+    alice.dirty = true;
+    PlayerRecord& bob = upsertPlayer(db, "BOB");
+    bob.wormColor = "rainbow";
+    bob.achievements = 0x80000001u;
+    bob.currency = 1234;
+    bob.streak = 65535;
+    bob.dirty = true;
+    db.session.player = "BOB";
+    db.session.wordCount = 50;
+    db.session.customWords = 0;
+    db.session.timedSeconds = 60;
+    db.session.flags = SESSION_PUNCTUATION | SESSION_WEAK_KEYS;
+    db.session.dirty = true;
+}
+
+static bool samePlayer(const PlayerRecord* a, const PlayerRecord& b) {
+    return a != nullptr && a->wormColor == b.wormColor && a->achievements == b.achievements &&
+           a->currency == b.currency && a->streak == b.streak;
+}
+
+static void testPlayerDatabase() {
+    std::string path = tempPath(".db");
+    unlink(path.c_str());
+
+    PlayerDatabase db;
+    check(!openPlayerDatabase(db, path), "players.db: a missing file reports false");
+    addPlayers(db);
+    flushPlayerDatabase(db);
+    std::string image = readFile(path);
+    check(image.size() > kPlayerDbHeaderSize && getU16((const unsigned char*)image.data() + 4) == kPlayerDbVersion,
+          "players.db: written as the current version");
+
+    PlayerDatabase reopened;
+    check(openPlayerDatabase(reopened, path), "players.db: the written file opens");
+    check(reopened.players.size() == 2, "players.db: every profile reads back");
+    check(samePlayer(findPlayer(reopened, "ALICE"), db.players[0]), "players.db: ALICE round-trips");
+    check(samePlayer(findPlayer(reopened, "BOB"), db.players[1]), "players.db: BOB round-trips");
+    check(reopened.session.player == "BOB" && reopened.session.wordCount == 50 &&
+          reopened.session.timedSeconds == 60 &&
+          reopened.session.flags == (SESSION_PUNCTUATION | SESSION_WEAK_KEYS),
+          "players.db: the session round-trips");
+
+    // Editing one record goes through the incremental path
+    PlayerRecord* alice = findPlayer(reopened, "ALICE");
+    if (alice != nullptr) {
+        alice->currency = 99;
+        alice->dirty = true;
+    }
+    flushPlayerDatabase(reopened);
+    PlayerDatabase edited;
+    openPlayerDatabase(edited, path);
+    check(findPlayer(edited, "ALICE") != nullptr && findPlayer(edited, "ALICE")->currency == 99 &&
+          samePlayer(findPlayer(edited, "BOB"), db.players[1]),
+          "players.db: an incremental flush keeps the other records");
+    image = readFile(path);
+
+    // A record that fails its checksum is dropped; the session still finds its player by name
+    std::string damaged = image;
+    damaged[kPlayerDbHeaderSize + 12] ^= 0x40;  // Inside ALICE's worm color
+    writeFile(path, damaged);
+    openPlayerDatabase(reopened, path);
+    check(findPlayer(reopened, "ALICE") == nullptr, "players.db: a bad record checksum drops the record");
+    check(samePlayer(findPlayer(reopened, "BOB"), db.players[1]), "players.db: the other records survive");
+    check(reopened.session.player == "BOB", "players.db: the session survives a dropped record");
+
+    // A session that fails its checksum is ignored; the profiles are not
+    damaged = image;
+    damaged[kPlayerDbHeaderSizeV1 + 4] ^= 0x01;
+    writeFile(path, damaged);
+    openPlayerDatabase(reopened, path);
+    check(reopened.session.player.empty() && reopened.session.wordCount == 0,
+          "players.db: a bad session checksum drops the session");
+    check(reopened.players.size() == 2, "players.db: a bad session keeps the profiles");
+
+    // Wrong version and truncation leave an empty database, replaced on the next flush
+    damaged = image;
+    damaged[4] = 7;
+    writeFile(path, damaged);
+    openPlayerDatabase(reopened, path);
+    check(reopened.players.empty() && reopened.rebuild, "players.db: a wrong version is rejected");
+    writeFile(path, image.substr(0, kPlayerDbHeaderSize + kPlayerRecordSize));
+    openPlayerDatabase(reopened, path);
+    check(reopened.players.empty() && reopened.rebuild, "players.db: a truncated file is rejected");
+    writeFile(path, image.substr(0, kPlayerDbHeaderSizeV1 - 1));
+    openPlayerDatabase(reopened, path);
+    check(reopened.players.empty(), "players.db: a truncated header is rejected");
+
+    // Version 1 (no session block) still reads, and is rewritten as version 2
+    std::string v1 = image.substr(0, kPlayerDbHeaderSizeV1) + image.substr(kPlayerDbHeaderSize);
+    v1[4] = (char)kPlayerDbVersion1;
+    writeFile(path, v1);
+    openPlayerDatabase(reopened, path);
+    check(reopened.players.size() == 2 && reopened.session.player.empty(), "players.db: version 1 reads");
+    flushPlayerDatabase(reopened);
+    std::string upgraded = readFile(path);
+    check(upgraded.size() > 6 && getU16((const unsigned char*)upgraded.data() + 4) == kPlayerDbVersion,
+          "players.db: version 1 is rewritten as version 2");
+    openPlayerDatabase(edited, path);
+    check(edited.players.size() == 2 && findPlayer(edited, "BOB") != nullptr,
+          "players.db: the upgraded file reads back");
+
+    unlink(path.c_str());
+}
+
+// ---------------------------------------------------------------------------
+// Key statistics
+// ---------------------------------------------------------------------------
+
+static void testKeyStats() {
+    std::string path = tempPath(".ks");
+    unlink(path.c_str());
+
+    std::vector<KeyStats> stats(3);  // Too big for the stack: saved, loaded, and a second player
+    clearKeyStats(stats[0]);
+    clearKeyStats(stats[2]);
+    KeyStat& a = stats[0].keys[keyStatIndex('a')];
+    a.total_us = 123456789012ULL;
+    a.presses = 40;
+    a.errors = 3;
+    a.timed = 38;
+    KeyStat& th = stats[0].bigrams[keyStatIndex('t') * kKeyStatChars + keyStatIndex('h')];
+    th.total_us = 5000;
+    th.presses = 9;
+    th.errors = 1;
+    th.timed = 9;
+    stats[2].keys[keyStatIndex('~')].presses = 1;
+
+    KeyStatsStore store;
+    openKeyStatsStore(store, path);
+    check(store.players.empty(), "keystats.db: a missing file is an empty store");
+    saveKeyStats(store, "BOB", stats[2]);
+    saveKeyStats(store, "ALICE", stats[0]);
+
+    KeyStatsStore reopened;
+    openKeyStatsStore(reopened, path);
+    check(reopened.players.size() == 2, "keystats.db: every player reads back");
+    loadKeyStats(reopened, "ALICE", stats[1]);
+    check(memcmp(&stats[0], &stats[1], sizeof(KeyStats)) == 0, "keystats.db: ALICE's cells round-trip");
+    loadKeyStats(reopened, "BOB", stats[1]);
+    check(memcmp(&stats[2], &stats[1], sizeof(KeyStats)) == 0, "keystats.db: BOB's cells round-trip");
+
+    // A truncated file keeps the players before the cut
+    std::string image = readFile(path);
+    writeFile(path, image.substr(0, image.size() - 1));
+    openKeyStatsStore(reopened, path);
+    check(reopened.players.size() == 1, "keystats.db: a truncated player is dropped");
+
+    std::string damaged = image;
+    damaged[4] = 9;
+    writeFile(path, damaged);
+    openKeyStatsStore(reopened, path);
+    check(reopened.players.empty(), "keystats.db: a wrong version is rejected");
+    damaged = image;
+    damaged[0] = 'X';
+    writeFile(path, damaged);
+    openKeyStatsStore(reopened, path);
+    check(reopened.players.empty(), "keystats.db: bad magic is rejected");
+
+    unlink(path.c_str());
+}
+
+// ---------------------------------------------------------------------------
+// Recordings
+// ---------------------------------------------------------------------------
+
+// Record one test of the given keys, 1ms apart
+static void recordTest(TestRecorder& rec, uint16_t flags, int timedSeconds, const std::string& keys,
+                       const std::string& target, int layoutWidth) {
+    recorderBegin(rec, 0x1122334455667788ULL, 25, flags, 0, timedSeconds);
+    for (size_t i = 0; i < keys.size(); i++) recorderKey(rec, (int64_t)(i + 1) * 1000000, keys[i]);
+    recorderKey(rec, (int64_t)(keys.size() + 1) * 1000000, kKeyBackspace);
+    recorderFinish(rec, target, layoutWidth);
+}
+
+static void testRecordings() {
+    std::string path = tempPath(".wtrp");
+    unlink(path.c_str());
+
+    TestRecorder rec;
+    enableRecording(rec, path);
+    recordTest(rec, RECORD_PUNCTUATION, 0, "hello, world", "hello, world", 0);
+    recordTest(rec, RECORD_STREAMED | RECORD_WEAK_KEYS, 30, "abc def", "abc def ghi jkl", 80);
+    std::string data = readFile(path);
+    const unsigned char* p = (const unsigned char*)data.data();
+
+    TestRecording first, second;
+    size_t firstSize = 0, secondSize = 0;
+    check(readRecording(p, data.size(), first, firstSize) == RECORDING_OK, "recording: a word test reads");
+    check(first.version == kRecordVersion && first.flags == RECORD_PUNCTUATION &&
+          first.seed == 0x1122334455667788ULL && first.wordCount == 25 && first.timedSeconds == 0 &&
+          first.target == "hello, world", "recording: the word test header and text round-trip");
+    bool eventsMatch = first.events.size() == 13;
+    for (size_t i = 0; eventsMatch && i < 12; i++) {
+        eventsMatch = first.events[i].key == "hello, world"[i] && first.events[i].delta_us == 1000;
+    }
+    check(eventsMatch && first.events[12].key == kKeyBackspace, "recording: the key events round-trip");
+
+    check(firstSize < data.size() &&
+          readRecording(p + firstSize, data.size() - firstSize, second, secondSize) == RECORDING_OK &&
+          firstSize + secondSize == data.size(), "recording: records follow each other back to back");
+    check((second.flags & RECORD_STREAMED) && second.timedSeconds == 30 && second.layoutWidth == 80 &&
+          second.target == "abc def ghi jkl" && second.events.size() == 8,
+          "recording: the streamed test round-trips");
+
+    // The script of a streamed record replays word for word
+    TextStream stream;
+    std::string target;
+    streamReplay(stream, target, second.target);
+    check(target == second.target, "recording: a stream replays the recorded words");
+
+    TestRecording bad;
+    size_t badSize = 0;
+    check(readRecording(p, firstSize - 1, bad, badSize) == RECORDING_TRUNCATED, "recording: a truncated record is rejected");
+    check(readRecording(p, kRecordHeaderSizeV1 - 1, bad, badSize) == RECORDING_INVALID,
+          "recording: a truncated header is rejected");
+    std::string damaged = data;
+    damaged[4] = 9;
+    check(readRecording((const unsigned char*)damaged.data(), damaged.size(), bad, badSize) == RECORDING_INVALID,
+          "recording: a wrong version is rejected");
+    damaged = data;
+    damaged[1] = 'X';
+    check(readRecording((const unsigned char*)damaged.data(), damaged.size(), bad, badSize) == RECORDING_INVALID,
+          "recording: bad magic is rejected");
+    damaged = data.substr(firstSize);
+    damaged[30] = 0;  // Layout width of the streamed record
+    damaged[31] = 0;
+    check(readRecording((const unsigned char*)damaged.data(), damaged.size(), bad, badSize) == RECORDING_INVALID,
+          "recording: a streamed record without a width is rejected");
+
+    // Version 1: the header stops at eventCount and the test is always a word test
+    std::string v1 = data.substr(0, kRecordHeaderSizeV1) + data.substr(kRecordHeaderSize, firstSize - kRecordHeaderSize);
+    v1[4] = (char)kRecordVersion1;
+    v1[6] |= (char)RECORD_STREAMED;
+    TestRecording old;
+    size_t oldSize = 0;
+    check(readRecording((const unsigned char*)v1.data(), v1.size(), old, oldSize) == RECORDING_OK &&
+          oldSize == v1.size() && old.target == "hello, world" && old.events.size() == 13 &&
+          !(old.flags & RECORD_STREAMED), "recording: version 1 reads as a word test");
+
+    unlink(path.c_str());
+}
+
+int main() {
+    testScoreLog();
+    testPlayerDatabase();
+    testKeyStats();
+    testRecordings();
+    printf("%d checks, %d failed\n", checks, failures);
+    return failures == 0 ? 0 : 1;
+}